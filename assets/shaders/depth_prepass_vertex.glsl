@@ -0,0 +1,19 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+// Dequantization of compact vertex positions, identity for full ones
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// IMPORTANT: must be computed exactly like in geometry pass, so depths of both passes match
+invariant gl_Position;
+
+void main()
+{
+    vec4 worldPos = model * vec4(positionOffset + aPos * positionScale, 1.0);
+    gl_Position = projection * view * worldPos;
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 330 core
+
+#include "lighting_common.glsl"
+
+struct Material {
+    sampler2D diffuse0;
+    sampler2D specular0;
+};
+
+in vec3 FragPos;
+in vec2 TexCoords;
+in vec3 Normal;
+
+uniform Material material;
+
+layout (location = 0) out vec4 FragColor;
+
+void main()
+{
+    // Depth prepass already ran, so only the visible fragment of every pixel gets here
+    vec3 diffuse = texture(material.diffuse0, TexCoords).rgb;
+    float specular = texture(material.specular0, TexCoords).r;
+    vec4 finalColor = vec4(calculateLighting(FragPos, normalize(Normal), diffuse, specular), 1.0);
+    // Raw count is written, present pass turns it into a heatmap
+    if (debugView == DEBUG_VIEW_LIGHT_COUNT)
+    {
+        FragColor = vec4(float(passedLightsCount), 0.0, 0.0, 1.0);
+        return;
+    }
+    if (useFog)
+    {
+        FragColor = applyFogEffect(finalColor, FragPos, cameraPos, fogMaxDist);
+    }
+    else
+    {
+        FragColor = finalColor;
+    }
+}
\ No newline at end of file
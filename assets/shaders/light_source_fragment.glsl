@@ -3,8 +3,8 @@
 const vec4 FOG_COLOR = vec4(0.8, 0.8, 0.8, 1.0);
 
 in vec3 fragPos;
+flat in vec3 lightColor;
 
-uniform vec3 lightColor;
 uniform float fogMaxDist;
 uniform bool useFog;
 uniform vec3 cameraPos;
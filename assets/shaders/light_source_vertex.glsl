@@ -2,17 +2,22 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoords;
+// Per instance data
+layout (location = 3) in vec3 aLightPosition;
+layout (location = 4) in vec3 aLightColor;
+
+const float SPHERE_SCALE = 0.125;
 
 uniform mat4 projection;
 uniform mat4 view;
-uniform mat4 model;
 
 out vec3 fragPos;
+flat out vec3 lightColor;
 
 void main()
 {
-    vec4 wordlPos = model * vec4(aPos, 1.0);
+    vec4 wordlPos = vec4(aPos * SPHERE_SCALE + aLightPosition, 1.0);
     gl_Position = projection * view * wordlPos;
     fragPos = wordlPos.xyz;
+    lightColor = aLightColor;
 }
\ No newline at end of file
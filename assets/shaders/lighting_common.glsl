@@ -0,0 +1,222 @@
+// Lighting shared by deferred lighting pass and forward+ pass.
+// Point lights come from per-tile lists, so gl_FragCoord must be relative to the rendered area.
+
+struct PointLight {
+    vec3 position;
+    vec3 color;
+    float linear;
+    float quadratic;
+    float radius;
+    // Layers 2 * shadowSlot and 2 * shadowSlot + 1 of point shadow maps, -1 for unshadowed lights
+    int shadowSlot;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float linear;
+    float quadratic;
+    bool use;
+    // Maps world position into the light's tile of the shadow atlas
+    bool hasShadow;
+    mat4 shadowMatrix;
+};
+
+// IMPORTANT: these values must match constants with the same name in PointLightsContainer
+const int TILE_SIZE = 32;
+const int LIGHT_DATA_STRIDE = 3;
+// IMPORTANT: this value must match constant with the same name in DeferredShaderer
+const vec4 FOG_COLOR = vec4(0.8, 0.8, 0.8, 1.0);
+const int MAX_NR_SPOT_LIGHTS = 16;
+const vec3 SPOTLIGHT_COLOR = vec3(1.0, 1.0, 1.0);
+// IMPORTANT: this value must match ATLAS_SIZE in ShadowAtlas
+const float SHADOW_ATLAS_SIZE = 2048.0;
+const float SHADOW_BIAS = 0.0002;
+// IMPORTANT: this value must match MAP_SIZE in PointShadowMaps
+const float POINT_SHADOW_MAP_SIZE = 512.0;
+const float POINT_SHADOW_BIAS = 0.002;
+// IMPORTANT: this value must match DebugView in Controls
+const int DEBUG_VIEW_LIGHT_COUNT = 1;
+
+// Point lights are nodes of the light tree, each tile has its own list of nodes to shade
+uniform samplerBuffer pointLightsData;
+uniform usamplerBuffer tileLightRanges;
+uniform usamplerBuffer tileLightIndices;
+uniform int tilesCountX;
+uniform vec3 cameraPos;
+uniform float ambientLevel;
+uniform float fogMaxDist;
+uniform bool useFog;
+uniform SpotLight spotLights[MAX_NR_SPOT_LIGHTS];
+uniform int nrSpotLights;
+uniform sampler2DShadow spotShadowAtlas;
+uniform sampler2DArrayShadow pointShadowMaps;
+uniform int debugView;
+
+// Lights that passed radius or cone test in last `calculateLighting` call, used by light count debug view
+int passedLightsCount = 0;
+
+PointLight fetchPointLight(int idx);
+vec3 calculatAmbientColor(vec3 diffuseColor, float ambientLevel);
+vec3 calculatePointLightsColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, PointLight pointLight);
+vec3 calculateSpotlightColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, SpotLight spotlight);
+float calculateSpotlightShadow(vec3 fragPos, SpotLight spotlight);
+float calculatePointLightShadow(vec3 fragPos, PointLight pointLight);
+
+vec3 calculateLighting(vec3 fragPos, vec3 normal, vec3 diffuse, float specular)
+{
+    vec3 cameraDir = normalize(cameraPos - fragPos);
+    passedLightsCount = 0;
+
+    // Calculate lighting effect
+    vec3 ambientColor = calculatAmbientColor(diffuse, ambientLevel);
+
+    // Pointlights
+    vec3 pointLightsColor = vec3(0.0, 0.0, 0.0);
+    ivec2 tile = ivec2(gl_FragCoord.xy) / TILE_SIZE;
+    uvec2 tileRange = texelFetch(tileLightRanges, tile.y * tilesCountX + tile.x).xy;
+    for (uint i = 0u; i < tileRange.y; i++)
+    {
+        int lightIdx = int(texelFetch(tileLightIndices, int(tileRange.x + i)).r);
+        pointLightsColor += calculatePointLightsColor(fragPos, normal, diffuse, specular, cameraDir, fetchPointLight(lightIdx));
+    }
+
+    // Spotlights
+    vec3 spotlightsColor = vec3(0.0, 0.0, 0.0);
+    for (int i = 0; i < nrSpotLights; i++)
+    {
+        spotlightsColor += calculateSpotlightColor(fragPos, normal, diffuse, specular, cameraDir, spotLights[i]);
+    }
+
+    // Combine all lights
+    return ambientColor + pointLightsColor + spotlightsColor;
+}
+
+PointLight fetchPointLight(int idx)
+{
+    vec4 positionRadius = texelFetch(pointLightsData, idx * LIGHT_DATA_STRIDE);
+    vec4 colorLinear = texelFetch(pointLightsData, idx * LIGHT_DATA_STRIDE + 1);
+    vec4 quadratic = texelFetch(pointLightsData, idx * LIGHT_DATA_STRIDE + 2);
+    PointLight pointLight;
+    pointLight.position = positionRadius.xyz;
+    pointLight.radius = positionRadius.w;
+    pointLight.color = colorLinear.rgb;
+    pointLight.linear = colorLinear.a;
+    pointLight.quadratic = quadratic.r;
+    pointLight.shadowSlot = int(quadratic.g) - 1;
+    return pointLight;
+}
+
+vec3 calculatAmbientColor(vec3 diffuseColor, float ambientLevel)
+{
+    return diffuseColor * ambientLevel;
+}
+
+vec3 calculatePointLightsColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, PointLight pointLight)
+{
+    vec3 pointLightsColor = vec3(0.0, 0.0, 0.0);
+    float dist = length(pointLight.position - fragPos);
+    if (dist < pointLight.radius)
+    {
+        passedLightsCount++;
+        // Diffuse
+        vec3 lightDir = normalize(pointLight.position - fragPos);
+        vec3 diffuseCol = max(dot(normal, lightDir), 0.0) * diffuse * pointLight.color;
+        // Specular
+        vec3 halfwayDir = normalize(lightDir + cameraDir);
+        float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+        vec3 specularCol = spec * specular * pointLight.color;
+        // Attenuation
+        float attenuation = 1.0 / (1.0 + pointLight.linear * dist + pointLight.quadratic * dist * dist);
+        attenuation *= calculatePointLightShadow(fragPos, pointLight);
+        // Result
+        diffuseCol *= attenuation;
+        specularCol *= attenuation;
+        pointLightsColor += (diffuseCol + specularCol);
+    }
+    return pointLightsColor;
+}
+
+vec3 calculateSpotlightColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, SpotLight spotlight)
+{
+    if (!spotlight.use)
+    {
+        return vec3(0.0, 0.0, 0.0);
+    }
+    float dist = length(spotlight.position - fragPos);
+    // Diffuse
+    vec3 lightDir = normalize(spotlight.position - fragPos);
+    vec3 diffuseCol = max(dot(normal, lightDir), 0.0) * diffuse * SPOTLIGHT_COLOR;
+    // Specular
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(cameraDir, reflectDir), 0.0), 32.0);
+    vec3 specularCol = spec * specular * SPOTLIGHT_COLOR;
+    // Attenuation
+    float attenuation = 1.0 / (1.0 + spotlight.linear * dist + spotlight.quadratic * dist * dist);
+    // Intensity
+    float theta = dot(lightDir, normalize(-spotlight.direction));
+    float epsilon = spotlight.cutOff - spotlight.outerCutOff;
+    float intensity = clamp((theta - spotlight.outerCutOff) / epsilon, 0.0, 1.0);
+    if (intensity > 0.0)
+    {
+        passedLightsCount++;
+        intensity *= calculateSpotlightShadow(fragPos, spotlight);
+    }
+    diffuseCol *= (attenuation * intensity);
+    specularCol *= (attenuation * intensity);
+    return diffuseCol + specularCol;
+}
+
+float calculateSpotlightShadow(vec3 fragPos, SpotLight spotlight)
+{
+    if (!spotlight.hasShadow)
+    {
+        return 1.0;
+    }
+    vec4 shadowPos = spotlight.shadowMatrix * vec4(fragPos, 1.0);
+    vec3 projected = shadowPos.xyz / shadowPos.w;
+    projected.z -= SHADOW_BIAS;
+    // 4 taps, each of them is already bilinearly filtered by hardware comparison
+    float offset = 0.5 / SHADOW_ATLAS_SIZE;
+    float shadow = texture(spotShadowAtlas, projected + vec3(-offset, -offset, 0.0));
+    shadow += texture(spotShadowAtlas, projected + vec3(offset, -offset, 0.0));
+    shadow += texture(spotShadowAtlas, projected + vec3(-offset, offset, 0.0));
+    shadow += texture(spotShadowAtlas, projected + vec3(offset, offset, 0.0));
+    return shadow * 0.25;
+}
+
+float calculatePointLightShadow(vec3 fragPos, PointLight pointLight)
+{
+    if (pointLight.shadowSlot < 0)
+    {
+        return 1.0;
+    }
+    // Paraboloid projection - IMPORTANT: must match point_shadow_vertex.glsl
+    vec3 lightToFrag = fragPos - pointLight.position;
+    float dist = length(lightToFrag);
+    vec3 dir = lightToFrag / dist;
+    float hemisphere = dir.z >= 0.0 ? 1.0 : -1.0;
+    float layer = float(pointLight.shadowSlot * 2) + (dir.z >= 0.0 ? 0.0 : 1.0);
+    vec2 uv = dir.xy / (1.0 + dir.z * hemisphere) * 0.5 + 0.5;
+    // Depth is linear distance from the light, see point_shadow_vertex.glsl
+    float depth = dist / pointLight.radius - POINT_SHADOW_BIAS;
+    // Same 4 taps as for spotlights
+    float offset = 0.5 / POINT_SHADOW_MAP_SIZE;
+    float shadow = texture(pointShadowMaps, vec4(uv + vec2(-offset, -offset), layer, depth));
+    shadow += texture(pointShadowMaps, vec4(uv + vec2(offset, -offset), layer, depth));
+    shadow += texture(pointShadowMaps, vec4(uv + vec2(-offset, offset), layer, depth));
+    shadow += texture(pointShadowMaps, vec4(uv + vec2(offset, offset), layer, depth));
+    return shadow * 0.25;
+}
+
+vec4 applyFogEffect(vec4 finalColor, vec3 fragPos, vec3 cameraPos, float fogMaxDist)
+{
+    float fogMinDist = 0.1;
+    float dist = length(fragPos - cameraPos);
+    float fogFactor = (fogMaxDist - dist) /
+    (fogMaxDist - fogMinDist);
+    fogFactor = clamp(fogFactor, 0.0, 1.0);
+    return mix(FOG_COLOR, finalColor, fogFactor);
+}
\ No newline at end of file
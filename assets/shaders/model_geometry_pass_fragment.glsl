@@ -6,20 +6,33 @@ struct Material {
 };
 
 in vec2 TexCoords;
-in vec3 FragPos;
 in vec3 Normal;
 
 uniform Material material;
 
-layout (location = 0) out vec3 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec4 gAlbedoSpec;
+// Position is not stored - lighting pass reconstructs it from depth
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+
+vec2 encodeNormal(vec3 normal);
 
 void main()
 {
-    gPosition = FragPos;
-    gNormal = normalize(Normal);
+    gNormal = encodeNormal(normalize(Normal));
     gAlbedoSpec.rgb = texture(material.diffuse0, TexCoords).rgb;
     // Specular only need one value so we can store it like thir for better memory usage
     gAlbedoSpec.a = texture(material.specular0, TexCoords).r;
+}
+
+// Octahedral encoding - project normal onto octahedron and unfold it into [0, 1] square
+vec2 encodeNormal(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    vec2 encoded = normal.xy;
+    if (normal.z < 0.0)
+    {
+        vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+        encoded = (1.0 - abs(normal.yx)) * signs;
+    }
+    return encoded * 0.5 + 0.5;
 }
\ No newline at end of file
@@ -4,18 +4,22 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+// Dequantization of compact vertex positions, identity for full ones
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
-out vec3 FragPos;
 out vec2 TexCoords;
 out vec3 Normal;
 
+// IMPORTANT: must be computed exactly like in depth prepass, so depths of both passes match
+invariant gl_Position;
+
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
-    FragPos = worldPos.xyz;
+    vec4 worldPos = model * vec4(positionOffset + aPos * positionScale, 1.0);
     TexCoords = aTexCoords;
 
     // TODO: do it on CPU and pass it in uniform
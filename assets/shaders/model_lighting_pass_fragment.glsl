@@ -1,87 +1,94 @@
 #version 330 core
 
-struct PointLight {
-    vec3 position;
-    vec3 color;
-    float linear;
-    float quadratic;
-    float radius;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-    float linear;
-    float quadratic;
-    bool use;
-};
-
-const int MAX_NR_POINT_LIGHTS = 256;
-const vec4 FOG_COLOR = vec4(0.8, 0.8, 0.8, 1.0);
-const int MAX_NR_SPOT_LIGHTS = 16;
-const vec3 SPOTLIGHT_COLOR = vec3(1.0, 1.0, 1.0);
+// Temporal reprojection
+// IMPORTANT: pattern size (4) must match TEMPORAL_PATTERN_SIZE in DeferredShaderer
+const float MIN_HISTORY_CONFIDENCE = 0.3;
+const float HISTORY_CONFIDENCE_DECAY = 0.8;
+const float HISTORY_BLEND = 0.5;
+const float DISOCCLUSION_THRESHOLD = 0.02;
+const float MOTION_CONFIDENCE_PENALTY = 0.25;
+// Refresh rotates over blocks rather than pixels, so whole warps either reuse history or shade
+const int REFRESH_BLOCK_SIZE = 8;
+
+#include "lighting_common.glsl"
 
 in vec2 TexCoords;
 
-uniform sampler2D gPosition;
+uniform sampler2D gDepth;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
-uniform PointLight pointLights[MAX_NR_POINT_LIGHTS];
-uniform vec3 cameraPos;
-uniform int nrPointLights;
-uniform float ambientLevel;
-uniform float fogMaxDist;
-uniform bool useFog;
-uniform SpotLight spotLights[MAX_NR_POINT_LIGHTS];
-uniform int nrSpotLights;
-
-out vec4 FragColor;
+uniform mat4 inverseViewProjection;
+// Part of gBuffer textures that is actually rendered to (dynamic resolution)
+uniform vec2 renderScale;
+// Temporal reprojection - history holds lit color with confidence and distance from camera of previous frame
+uniform bool useTemporalReprojection;
+uniform bool isHistoryValid;
+uniform sampler2D historyColor;
+uniform sampler2D historyDistance;
+uniform mat4 previousViewProjection;
+uniform vec3 previousCameraPos;
+uniform int frameIndex;
+// Cones of spotlights that changed since history was written - before and after the change
+uniform int changedSpotConesCount;
+uniform vec3 changedSpotConePositions[2 * MAX_NR_SPOT_LIGHTS];
+uniform vec3 changedSpotConeDirections[2 * MAX_NR_SPOT_LIGHTS];
+uniform float changedSpotConeOuterCutOffs[2 * MAX_NR_SPOT_LIGHTS];
+
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec4 HistoryColor;
+layout (location = 2) out float HistoryDistance;
 
 // Helpers
-vec3 calculatAmbientColor(vec3 diffuseColor, float ambientLevel);
-vec3 calculatePointLightsColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, PointLight pointLight);
-vec3 calculateSpotlightColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, SpotLight spotlight);
-vec4 applyFogEffect(vec4 finalColor, vec3 fragPos, vec3 cameraPos, float fogMaxDist);
+vec3 shadePixel(vec2 gTexCoords, vec3 fragPos);
+bool reprojectHistory(vec3 fragPos, out vec4 history);
+bool isLitByChangedSpotLight(vec3 fragPos);
+vec3 reconstructPosition(vec2 texCoords, float depth);
+vec3 decodeNormal(vec2 encoded);
 
 void main()
 {
-    // Get data from gbuffer
-    vec3 fragPos = texture(gPosition, TexCoords).rgb;
-    vec3 normal = texture(gNormal, TexCoords).rgb;
-    vec3 diffuse = texture(gAlbedoSpec, TexCoords).rgb;
-    float specular = texture(gAlbedoSpec, TexCoords).a;
+    // Quad covers only rendered part of the targets, while TexCoords still span the whole screen
+    vec2 gTexCoords = TexCoords * renderScale;
 
-    // In case when we use fog, we don't have any skybox - we just want the whole sky to have color of the fog
-    if (normal == vec3(0,0,0) && useFog)
+    // Sky pixels keep cleared depth and are never shaded - depth is sampled here, so it can't be used for stencil test
+    float depth = texture(gDepth, gTexCoords).r;
+    if (depth == 1.0)
     {
-        FragColor = FOG_COLOR;
-        return;
+        discard;
     }
-
-    vec3 cameraDir = normalize(cameraPos - fragPos);
-
-    // Calculate lighting effect
-    vec3 ambientColor = calculatAmbientColor(diffuse, ambientLevel);
-
-    // Pointlights
-    vec3 pointLightsColor = vec3(0.0, 0.0, 0.0);
-    for (int i = 0; i < nrPointLights; i++)
+    vec3 fragPos = reconstructPosition(TexCoords, depth);
+
+    vec3 litColor;
+    float confidence = 1.0;
+    vec4 history;
+    bool hasHistory = useTemporalReprojection && reprojectHistory(fragPos, history) && !isLitByChangedSpotLight(fragPos);
+    // Every frame a different block of each 2x2 group of blocks is re-shaded, the rest reuse history as long as it can be trusted
+    ivec2 block = ivec2(gl_FragCoord.xy) / REFRESH_BLOCK_SIZE;
+    bool isRefreshed = (block.x & 1) + 2 * (block.y & 1) == frameIndex;
+    if (hasHistory && !isRefreshed && history.a >= MIN_HISTORY_CONFIDENCE)
     {
-        pointLightsColor += calculatePointLightsColor(fragPos, normal, diffuse, specular, cameraDir, pointLights[i]);
+        litColor = history.rgb;
+        confidence = history.a * HISTORY_CONFIDENCE_DECAY;
     }
-
-    // Spotlights
-    vec3 spotlightsColor = vec3(0.0, 0.0, 0.0);
-    for (int i = 0; i < nrSpotLights; i++)
+    else
     {
-        spotlightsColor += calculateSpotlightColor(fragPos, normal, diffuse, specular, cameraDir, spotLights[i]);
+        litColor = shadePixel(gTexCoords, fragPos);
+        // Raw count is written, present pass turns it into a heatmap. Temporal reprojection is off in debug views.
+        if (debugView == DEBUG_VIEW_LIGHT_COUNT)
+        {
+            FragColor = vec4(float(passedLightsCount), 0.0, 0.0, 1.0);
+            return;
+        }
+        if (hasHistory)
+        {
+            litColor = mix(litColor, history.rgb, history.a * HISTORY_BLEND);
+        }
     }
+    // History is stored before fog, as fog depends on current camera position
+    HistoryColor = vec4(litColor, confidence);
+    HistoryDistance = length(fragPos - cameraPos);
 
-    // Combine all lights
-    vec4 finalColor = vec4(ambientColor + pointLightsColor + spotlightsColor, 1.0);
-
+    vec4 finalColor = vec4(litColor, 1.0);
     if (useFog)
     {
         FragColor = applyFogEffect(finalColor, fragPos, cameraPos, fogMaxDist);
@@ -92,65 +99,71 @@ void main()
     }
 }
 
-vec3 calculatAmbientColor(vec3 diffuseColor, float ambientLevel)
+vec3 shadePixel(vec2 gTexCoords, vec3 fragPos)
 {
-    return diffuseColor * ambientLevel;
+    // Get data from gbuffer
+    vec3 normal = decodeNormal(texture(gNormal, gTexCoords).rg);
+    vec4 albedoSpec = texture(gAlbedoSpec, gTexCoords);
+    return calculateLighting(fragPos, normal, albedoSpec.rgb, albedoSpec.a);
 }
 
-vec3 calculatePointLightsColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, PointLight pointLight)
+bool reprojectHistory(vec3 fragPos, out vec4 history)
 {
-    vec3 pointLightsColor = vec3(0.0, 0.0, 0.0);
-    float dist = length(pointLight.position - fragPos);
-    if (dist < pointLight.radius)
+    history = vec4(0.0);
+    if (!isHistoryValid)
     {
-        // Diffuse
-        vec3 lightDir = normalize(pointLight.position - fragPos);
-        vec3 diffuseCol = max(dot(normal, lightDir), 0.0) * diffuse * pointLight.color;
-        // Specular
-        vec3 halfwayDir = normalize(lightDir + cameraDir);
-        float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
-        vec3 specularCol = spec * specular * pointLight.color;
-        // Attenuation
-        float attenuation = 1.0 / (1.0 + pointLight.linear * dist + pointLight.quadratic * dist * dist);
-        // Result
-        diffuseCol *= attenuation;
-        specularCol *= attenuation;
-        pointLightsColor += (diffuseCol + specularCol);
+        return false;
     }
-    return pointLightsColor;
+    // Where this point was on screen in previous frame
+    vec4 previousClip = previousViewProjection * vec4(fragPos, 1.0);
+    vec2 previousTexCoords = previousClip.xy / previousClip.w * 0.5 + 0.5;
+    if (previousClip.w <= 0.0 || any(lessThan(previousTexCoords, vec2(0.0))) || any(greaterThan(previousTexCoords, vec2(1.0))))
+    {
+        return false;
+    }
+    vec2 historyTexCoords = previousTexCoords * renderScale;
+    // Disocclusion - something else was visible at that spot in previous frame
+    float previousDistance = texelFetch(historyDistance, ivec2(historyTexCoords * vec2(textureSize(historyDistance, 0))), 0).r;
+    float expectedDistance = length(fragPos - previousCameraPos);
+    if (abs(previousDistance - expectedDistance) > DISOCCLUSION_THRESHOLD * expectedDistance)
+    {
+        return false;
+    }
+    history = texture(historyColor, historyTexCoords);
+    // The more camera moved, the blurrier bilinear history gets - so it's trusted less
+    float motion = length((previousTexCoords - TexCoords) * vec2(textureSize(historyColor, 0)) * renderScale);
+    history.a *= clamp(1.0 - motion * MOTION_CONFIDENCE_PENALTY, 0.0, 1.0);
+    return true;
 }
 
-vec3 calculateSpotlightColor(vec3 fragPos, vec3 normal, vec3 diffuse, float specular, vec3 cameraDir, SpotLight spotlight)
+bool isLitByChangedSpotLight(vec3 fragPos)
 {
-    if (!spotlight.use)
+    // Stale history of moved, switched or reshadowed spotlights would ghost, so it's rejected in their cones
+    for (int i = 0; i < changedSpotConesCount; i++)
     {
-        return vec3(0.0, 0.0, 0.0);
+        vec3 lightDir = normalize(fragPos - changedSpotConePositions[i]);
+        if (dot(lightDir, changedSpotConeDirections[i]) > changedSpotConeOuterCutOffs[i])
+        {
+            return true;
+        }
     }
-    float dist = length(spotlight.position - fragPos);
-    // Diffuse
-    vec3 lightDir = normalize(spotlight.position - fragPos);
-    vec3 diffuseCol = max(dot(normal, lightDir), 0.0) * diffuse * SPOTLIGHT_COLOR;
-    // Specular
-    vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(cameraDir, reflectDir), 0.0), 32.0);
-    vec3 specularCol = spec * specular * SPOTLIGHT_COLOR;
-    // Attenuation
-    float attenuation = 1.0 / (1.0 + spotlight.linear * dist + spotlight.quadratic * dist * dist);
-    // Intensity
-    float theta = dot(lightDir, normalize(-spotlight.direction));
-    float epsilon = spotlight.cutOff - spotlight.outerCutOff;
-    float intensity = clamp((theta - spotlight.outerCutOff) / epsilon, 0.0, 1.0);
-    diffuseCol *= (attenuation * intensity);
-    specularCol *= (attenuation * intensity);
-    return diffuseCol + specularCol;
+    return false;
+}
+
+vec3 reconstructPosition(vec2 texCoords, float depth)
+{
+    vec4 ndc = vec4(texCoords * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec4 worldPos = inverseViewProjection * ndc;
+    return worldPos.xyz / worldPos.w;
 }
 
-vec4 applyFogEffect(vec4 finalColor, vec3 fragPos, vec3 cameraPos, float fogMaxDist)
+vec3 decodeNormal(vec2 encoded)
 {
-    float fogMinDist = 0.1;
-    float dist = length(fragPos - cameraPos);
-    float fogFactor = (fogMaxDist - dist) /
-    (fogMaxDist - fogMinDist);
-    fogFactor = clamp(fogFactor, 0.0, 1.0);
-    return mix(FOG_COLOR, finalColor, fogFactor);
+    encoded = encoded * 2.0 - 1.0;
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    // Fold back lower hemisphere
+    float t = clamp(-normal.z, 0.0, 1.0);
+    normal.x += normal.x >= 0.0 ? -t : t;
+    normal.y += normal.y >= 0.0 ? -t : t;
+    return normalize(normal);
 }
\ No newline at end of file
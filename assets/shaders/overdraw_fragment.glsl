@@ -0,0 +1,9 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// Every fragment adds one with additive blending, present pass turns the sum into a heatmap
+void main()
+{
+    FragColor = vec4(1.0, 0.0, 0.0, 1.0);
+}
\ No newline at end of file
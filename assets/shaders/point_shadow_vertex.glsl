@@ -0,0 +1,26 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+// Dequantization of compact vertex positions, identity for full ones
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform mat4 model;
+uniform vec3 lightPos;
+// Light radius - depth is stored as linear distance from the light divided by it
+uniform float farPlane;
+// 1 for front (+z) and -1 for back (-z) hemisphere
+uniform float hemisphere;
+
+void main()
+{
+    // Paraboloid projection - IMPORTANT: must match `calculatePointLightShadow` in lighting_common.glsl
+    vec3 lightToVertex = (model * vec4(positionOffset + aPos * positionScale, 1.0)).xyz - lightPos;
+    lightToVertex.z *= hemisphere;
+    float dist = length(lightToVertex);
+    vec3 dir = lightToVertex / dist;
+    // Geometry behind the paraboloid belongs to the other hemisphere
+    gl_ClipDistance[0] = dir.z;
+    // Vertices right behind the light would be projected to infinity, they are clipped anyway
+    gl_Position = vec4(dir.xy / max(1.0 + dir.z, 0.0001), dist / farPlane * 2.0 - 1.0, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#version 330 core
+
+// How quickly taps lying at different depth than the nearest one are rejected
+const float DEPTH_SHARPNESS = 2000.0;
+// IMPORTANT: these values must match DebugView in Controls
+const int DEBUG_VIEW_NONE = 0;
+const int DEBUG_VIEW_LIGHT_COUNT = 1;
+// Values mapped to red end of the heatmap
+const float HEATMAP_MAX_LIGHTS = 32.0;
+const float HEATMAP_MAX_OVERDRAW = 8.0;
+
+in vec2 TexCoords;
+
+uniform sampler2D sceneColor;
+uniform sampler2D sceneDepth;
+// Part of scene textures that is actually rendered to (dynamic resolution)
+uniform vec2 renderSize;
+uniform bool isNativeResolution;
+// Scene color holds raw light count or overdraw in red channel instead of lit color
+uniform int debugView;
+
+out vec4 FragColor;
+
+// Helpers
+vec3 upscale(vec2 texCoords);
+vec3 heatmap(float value);
+
+void main()
+{
+    // Counts are not filtered, nearest texel is used even with dynamic resolution
+    if (debugView != DEBUG_VIEW_NONE)
+    {
+        float count = texelFetch(sceneColor, ivec2(TexCoords * renderSize), 0).r;
+        float maxCount = debugView == DEBUG_VIEW_LIGHT_COUNT ? HEATMAP_MAX_LIGHTS : HEATMAP_MAX_OVERDRAW;
+        FragColor = vec4(count > 0.0 ? heatmap(count / maxCount) : vec3(0.0), 1.0);
+        return;
+    }
+    // Native resolution - every pixel has exactly one texel
+    if (isNativeResolution)
+    {
+        FragColor = vec4(texelFetch(sceneColor, ivec2(gl_FragCoord.xy), 0).rgb, 1.0);
+        return;
+    }
+    FragColor = vec4(upscale(TexCoords), 1.0);
+}
+
+vec3 upscale(vec2 texCoords)
+{
+    // Bilinear filter whose taps are weighted down when they lie across a depth discontinuity,
+    // so edges of objects stay sharp instead of bleeding into background
+    vec2 position = texCoords * renderSize - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 f = fract(position);
+    ivec2 maxTexel = ivec2(renderSize) - 1;
+    float referenceDepth = texelFetch(sceneDepth, clamp(ivec2(round(position)), ivec2(0), maxTexel), 0).r;
+
+    vec3 color = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            ivec2 texel = clamp(base + ivec2(x, y), ivec2(0), maxTexel);
+            vec2 bilinear = mix(1.0 - f, f, vec2(x, y));
+            float depth = texelFetch(sceneDepth, texel, 0).r;
+            float weight = bilinear.x * bilinear.y / (1.0 + abs(depth - referenceDepth) * DEPTH_SHARPNESS);
+            color += texelFetch(sceneColor, texel, 0).rgb * weight;
+            totalWeight += weight;
+        }
+    }
+    return color / max(totalWeight, 0.0001);
+}
+
+vec3 heatmap(float value)
+{
+    // Blue -> cyan -> green -> yellow -> red
+    value = clamp(value, 0.0, 1.0);
+    return clamp(vec3(1.5 - abs(4.0 * value - 3.0), 1.5 - abs(4.0 * value - 2.0), 1.5 - abs(4.0 * value - 1.0)), 0.0, 1.0);
+}
\ No newline at end of file
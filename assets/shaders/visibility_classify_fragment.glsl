@@ -0,0 +1,15 @@
+#version 330 core
+
+// IMPORTANT: must match the same constants in VisibilityBuffer and visibility quad vertex shader
+const uint PRIMITIVE_ID_BITS = 23u;
+const uint EMPTY_DRAW_ID = 0xFFFFFFFFu >> PRIMITIVE_ID_BITS;
+const float MATERIAL_DEPTH_SCALE = 1024.0;
+
+uniform usampler2D visibility;
+
+void main()
+{
+    uint drawId = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).r >> PRIMITIVE_ID_BITS;
+    // Empty pixels are put behind every resolve quad
+    gl_FragDepth = drawId == EMPTY_DRAW_ID ? 1.0 : float(drawId + 1u) / MATERIAL_DEPTH_SCALE;
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+
+// IMPORTANT: must match the same constant in VisibilityBuffer
+const uint PRIMITIVE_ID_BITS = 23u;
+
+uniform int drawId;
+
+layout (location = 0) out uint visibility;
+
+void main()
+{
+    visibility = (uint(drawId) << PRIMITIVE_ID_BITS) | uint(gl_PrimitiveID);
+}
\ No newline at end of file
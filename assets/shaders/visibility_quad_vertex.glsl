@@ -0,0 +1,14 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+
+// Quad is placed at material depth of the draw, so only pixels covered by that draw pass the depth test
+uniform int drawId;
+
+const float MATERIAL_DEPTH_SCALE = 1024.0;
+
+void main()
+{
+    float materialDepth = float(drawId + 1) / MATERIAL_DEPTH_SCALE;
+    gl_Position = vec4(aPos.xy, materialDepth * 2.0 - 1.0, 1.0);
+}
\ No newline at end of file
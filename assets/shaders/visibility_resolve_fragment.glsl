@@ -0,0 +1,147 @@
+#version 330 core
+
+struct Material {
+    sampler2D diffuse0;
+    sampler2D specular0;
+};
+
+// IMPORTANT: must match the same constants in VisibilityBuffer
+const uint PRIMITIVE_ID_BITS = 23u;
+const uint PRIMITIVE_ID_MASK = (1u << PRIMITIVE_ID_BITS) - 1u;
+const int DRAW_DATA_STRIDE = 8;
+const int VERTEX_DATA_STRIDE = 2;
+
+uniform Material material;
+uniform usampler2D visibility;
+// Full vertices take two texels: (position, normal.x) and (normal.yz, texCoords)
+uniform samplerBuffer arenaVertices;
+// Compact vertices take one texel of the same buffer
+uniform usamplerBuffer arenaPackedVertices;
+uniform usamplerBuffer arenaIndices;
+uniform usamplerBuffer arenaShortIndices;
+uniform samplerBuffer draws;
+// Draw ids in visibility are local to the batch
+uniform int firstDrawId;
+uniform mat4 viewProjection;
+uniform vec2 renderSize;
+
+layout (location = 0) out vec2 gNormal;
+layout (location = 1) out vec4 gAlbedoSpec;
+
+vec3 calculateBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 ndc);
+vec2 encodeNormal(vec3 normal);
+float decodeHalf(uint bits);
+vec3 decodeNormal(uint bits);
+
+void main()
+{
+    uint visibilityData = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).r;
+    int drawBase = (firstDrawId + int(visibilityData >> PRIMITIVE_ID_BITS)) * DRAW_DATA_STRIDE;
+    int primitiveId = int(visibilityData & PRIMITIVE_ID_MASK);
+
+    mat4 model = mat4(texelFetch(draws, drawBase), texelFetch(draws, drawBase + 1), texelFetch(draws, drawBase + 2), texelFetch(draws, drawBase + 3));
+    mat3 normalMatrix = mat3(texelFetch(draws, drawBase + 4).xyz, texelFetch(draws, drawBase + 5).xyz, texelFetch(draws, drawBase + 6).xyz);
+    vec4 offsets = texelFetch(draws, drawBase + 7);
+    int baseVertex = int(offsets.x);
+    int firstIndex = int(offsets.y) + primitiveId * 3;
+    bool isCompact = offsets.z > 0.5;
+    bool isShort = offsets.w > 0.5;
+
+    // Fetch and transform the triangle again - it is cheaper than storing attributes for every pixel
+    vec4 clip[3];
+    vec3 normals[3];
+    vec2 texCoords[3];
+    for (int i = 0; i < 3; i++)
+    {
+        uint index = isShort ? texelFetch(arenaShortIndices, firstIndex + i).r : texelFetch(arenaIndices, firstIndex + i).r;
+        int vertex = baseVertex + int(index);
+        vec3 position;
+        if (isCompact)
+        {
+            // Model matrix of compact draws includes dequantization
+            uvec4 packed = texelFetch(arenaPackedVertices, vertex);
+            position = vec3(float(packed.x & 0xFFFFu), float(packed.x >> 16u), float(packed.y & 0xFFFFu)) / 65535.0;
+            normals[i] = decodeNormal(packed.z);
+            texCoords[i] = vec2(decodeHalf(packed.w & 0xFFFFu), decodeHalf(packed.w >> 16u));
+        }
+        else
+        {
+            vec4 first = texelFetch(arenaVertices, vertex * VERTEX_DATA_STRIDE);
+            vec4 second = texelFetch(arenaVertices, vertex * VERTEX_DATA_STRIDE + 1);
+            position = first.xyz;
+            normals[i] = vec3(first.w, second.xy);
+            texCoords[i] = second.zw;
+        }
+        clip[i] = viewProjection * (model * vec4(position, 1.0));
+    }
+
+    // Barycentrics of neighbouring pixels give texture coordinates derivatives, as hardware ones are meaningless here
+    vec2 ndc = gl_FragCoord.xy / renderSize * 2.0 - 1.0;
+    vec2 pixelSize = 2.0 / renderSize;
+    vec3 barycentrics = calculateBarycentrics(clip[0], clip[1], clip[2], ndc);
+    vec3 barycentricsX = calculateBarycentrics(clip[0], clip[1], clip[2], ndc + vec2(pixelSize.x, 0.0));
+    vec3 barycentricsY = calculateBarycentrics(clip[0], clip[1], clip[2], ndc + vec2(0.0, pixelSize.y));
+    mat3x2 texCoordsMatrix = mat3x2(texCoords[0], texCoords[1], texCoords[2]);
+    vec2 uv = texCoordsMatrix * barycentrics;
+    vec2 uvDx = texCoordsMatrix * barycentricsX - uv;
+    vec2 uvDy = texCoordsMatrix * barycentricsY - uv;
+
+    vec3 normal = mat3(normals[0], normals[1], normals[2]) * barycentrics;
+    gNormal = encodeNormal(normalize(normalMatrix * normal));
+    gAlbedoSpec.rgb = textureGrad(material.diffuse0, uv, uvDx, uvDy).rgb;
+    gAlbedoSpec.a = textureGrad(material.specular0, uv, uvDx, uvDy).r;
+}
+
+// Perspective correct barycentrics of ndc point inside triangle given in clip space
+vec3 calculateBarycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 ndc)
+{
+    vec3 invW = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+    vec2 ndc0 = clip0.xy * invW.x;
+    vec2 ndc1 = clip1.xy * invW.y;
+    vec2 ndc2 = clip2.xy * invW.z;
+
+    float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+    vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+    float ddxSum = dot(ddx, vec3(1.0));
+    float ddySum = dot(ddy, vec3(1.0));
+
+    vec2 delta = ndc - ndc0;
+    float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+    float interpW = 1.0 / interpInvW;
+    return vec3(
+        interpW * (invW.x + delta.x * ddx.x + delta.y * ddy.x),
+        interpW * (delta.x * ddx.y + delta.y * ddy.y),
+        interpW * (delta.x * ddx.z + delta.y * ddy.z)
+    );
+}
+
+// Octahedral encoding - project normal onto octahedron and unfold it into [0, 1] square
+vec2 encodeNormal(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    vec2 encoded = normal.xy;
+    if (normal.z < 0.0)
+    {
+        vec2 signs = vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+        encoded = (1.0 - abs(normal.yx)) * signs;
+    }
+    return encoded * 0.5 + 0.5;
+}
+
+// IMPORTANT: decoding of PackedVertex fields must match packing in vertex_quantization.cpp
+// Half floats without infinities and NaNs, which are never packed
+float decodeHalf(uint bits)
+{
+    uint exponent = (bits >> 10u) & 0x1Fu;
+    uint mantissa = bits & 0x3FFu;
+    float value = exponent == 0u ? float(mantissa) * exp2(-24.0) : uintBitsToFloat(((exponent + 112u) << 23u) | (mantissa << 13u));
+    return (bits & 0x8000u) != 0u ? -value : value;
+}
+
+// Signed normalized 10-10-10-2, the same conversion vertex fetch does for GL_INT_2_10_10_10_REV
+vec3 decodeNormal(uint bits)
+{
+    ivec3 components = ivec3(int(bits << 22u) >> 22, int(bits << 12u) >> 22, int(bits << 2u) >> 22);
+    return max(vec3(components) / 511.0, -1.0);
+}
\ No newline at end of file
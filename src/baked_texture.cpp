@@ -0,0 +1,188 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+#include "baked_texture.h"
+
+namespace Renderer3D {
+    BakedTexture::BakedTexture(const BakedTextureFormat format, const uint32_t width, const uint32_t height, const bool isFlipped, const BakedTextureSource source, std::vector<std::vector<std::byte>> levels)
+        : _format(format), _width(width), _height(height), _isFlipped(isFlipped), _source(source), _levels(std::move(levels))
+    {
+    }
+
+    std::optional<BakedTexture> BakedTexture::Load(const fs::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        Header header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+        if (!file || std::memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != VERSION)
+        {
+            spdlog::error("Baked texture {} has invalid header", path.string());
+            return std::nullopt;
+        }
+        const auto format = static_cast<BakedTextureFormat>(header.Format);
+        if (format != BakedTextureFormat::BC1 && format != BakedTextureFormat::BC3 && format != BakedTextureFormat::BC4 && format != BakedTextureFormat::BC5)
+        {
+            spdlog::error("Baked texture {} has unsupported format {}", path.string(), header.Format);
+            return std::nullopt;
+        }
+
+        BakedTexture texture(format, header.Width, header.Height, header.IsFlipped != 0, {header.SourceSize, header.SourceModificationTime}, {});
+        for (uint32_t level = 0; level < header.LevelsCount; level++)
+        {
+            uint32_t levelSize = 0;
+            file.read(reinterpret_cast<char*>(&levelSize), sizeof(levelSize));
+            // Size stored in file must agree with dimensions, otherwise upload would read out of bounds
+            if (!file || levelSize != GetLevelSize(format, texture.GetLevelWidth(level), texture.GetLevelHeight(level)))
+            {
+                spdlog::error("Baked texture {} is truncated or corrupted", path.string());
+                return std::nullopt;
+            }
+            std::vector<std::byte> data(levelSize);
+            file.read(reinterpret_cast<char*>(data.data()), levelSize);
+            file.ignore(static_cast<std::streamsize>((LEVEL_ALIGNMENT - levelSize % LEVEL_ALIGNMENT) % LEVEL_ALIGNMENT));
+            if (!file)
+            {
+                spdlog::error("Baked texture {} is truncated", path.string());
+                return std::nullopt;
+            }
+            texture._levels.push_back(std::move(data));
+        }
+        return texture;
+    }
+
+    bool BakedTexture::Save(const fs::path& path) const
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            spdlog::error("Failed to create baked texture {}", path.string());
+            return false;
+        }
+        Header header{};
+        std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+        header.Version = VERSION;
+        header.Format = static_cast<uint32_t>(_format);
+        header.Width = _width;
+        header.Height = _height;
+        header.IsFlipped = _isFlipped ? 1 : 0;
+        header.LevelsCount = static_cast<uint32_t>(_levels.size());
+        header.SourceSize = _source.Size;
+        header.SourceModificationTime = _source.ModificationTime;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        for (const auto& level : _levels)
+        {
+            static constexpr char padding[LEVEL_ALIGNMENT] = {};
+            const auto levelSize = static_cast<uint32_t>(level.size());
+            file.write(reinterpret_cast<const char*>(&levelSize), sizeof(levelSize));
+            file.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+            file.write(padding, static_cast<std::streamsize>((LEVEL_ALIGNMENT - levelSize % LEVEL_ALIGNMENT) % LEVEL_ALIGNMENT));
+        }
+        if (!file)
+        {
+            spdlog::error("Failed to write baked texture {}", path.string());
+            return false;
+        }
+        return true;
+    }
+
+    fs::path BakedTexture::GetBakedPath(const fs::path& sourcePath)
+    {
+        auto bakedPath = sourcePath;
+        bakedPath += EXTENSION;
+        return bakedPath;
+    }
+
+    size_t BakedTexture::GetLevelSize(const BakedTextureFormat format, const uint32_t width, const uint32_t height)
+    {
+        // Partial blocks at the edges are stored as whole ones
+        const auto blocksX = (static_cast<size_t>(width) + 3) / 4;
+        const auto blocksY = (static_cast<size_t>(height) + 3) / 4;
+        return blocksX * blocksY * GetBlockSize(format);
+    }
+
+    size_t BakedTexture::GetBlockSize(const BakedTextureFormat format)
+    {
+        return format == BakedTextureFormat::BC1 || format == BakedTextureFormat::BC4 ? 8 : 16;
+    }
+
+    std::optional<BakedTextureSource> BakedTexture::ReadSource(const fs::path& sourcePath)
+    {
+        std::error_code error;
+        const auto size = fs::file_size(sourcePath, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+        const auto modificationTime = fs::last_write_time(sourcePath, error);
+        if (error)
+        {
+            return std::nullopt;
+        }
+        return BakedTextureSource{size, static_cast<int64_t>(modificationTime.time_since_epoch().count())};
+    }
+
+    bool BakedTexture::IsUpToDate(const fs::path& sourcePath) const
+    {
+        return ReadSource(sourcePath) == _source;
+    }
+
+    BakedTextureFormat BakedTexture::GetFormat() const
+    {
+        return _format;
+    }
+
+    uint32_t BakedTexture::GetWidth() const
+    {
+        return _width;
+    }
+
+    uint32_t BakedTexture::GetHeight() const
+    {
+        return _height;
+    }
+
+    bool BakedTexture::IsFlipped() const
+    {
+        return _isFlipped;
+    }
+
+    size_t BakedTexture::GetLevelsCount() const
+    {
+        return _levels.size();
+    }
+
+    uint32_t BakedTexture::GetLevelWidth(const size_t level) const
+    {
+        return std::max(_width >> level, 1u);
+    }
+
+    uint32_t BakedTexture::GetLevelHeight(const size_t level) const
+    {
+        return std::max(_height >> level, 1u);
+    }
+
+    const std::vector<std::byte>& BakedTexture::GetLevel(const size_t level) const
+    {
+        return _levels[level];
+    }
+
+    size_t BakedTexture::GetDataSize() const
+    {
+        size_t size = 0;
+        for (const auto& level : _levels)
+        {
+            size += level.size();
+        }
+        return size;
+    }
+} // Renderer3D
@@ -0,0 +1,98 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef BAKED_TEXTURE_H
+#define BAKED_TEXTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace Renderer3D {
+
+    // Block compressed formats, every 4x4 block of texels takes a fixed number of bytes
+    enum class BakedTextureFormat : uint32_t
+    {
+        // Opaque RGB, 8 bytes per block
+        BC1 = 1,
+        // RGBA with interpolated alpha, 16 bytes per block
+        BC3 = 3,
+        // Single channel, 8 bytes per block
+        BC4 = 4,
+        // Two independent channels, 16 bytes per block
+        BC5 = 5
+    };
+
+    // Identifies the version of the source image a texture was baked from. Size and modification time are enough
+    // to notice an edited image without reading it, which would cost as much as decoding it.
+    struct BakedTextureSource
+    {
+        uint64_t Size = 0;
+        int64_t ModificationTime = 0;
+
+        bool operator==(const BakedTextureSource&) const = default;
+    };
+
+    // Texture compressed offline by the texture baker, together with its whole mip chain. The container follows KTX:
+    // a header and then every level as its byte size followed by data padded to 4 bytes, from the biggest level.
+    // It doesn't depend on GL, so the baker can run on machines without a GPU.
+    class BakedTexture {
+    public:
+        BakedTexture(BakedTextureFormat format, uint32_t width, uint32_t height, bool isFlipped, BakedTextureSource source, std::vector<std::vector<std::byte>> levels);
+        [[nodiscard]] static std::optional<BakedTexture> Load(const fs::path& path);
+        bool Save(const fs::path& path) const;
+        // Baked file is stored next to the source image
+        [[nodiscard]] static fs::path GetBakedPath(const fs::path& sourcePath);
+        [[nodiscard]] static size_t GetLevelSize(BakedTextureFormat format, uint32_t width, uint32_t height);
+        [[nodiscard]] static size_t GetBlockSize(BakedTextureFormat format);
+        // Empty when source image can't be accessed
+        [[nodiscard]] static std::optional<BakedTextureSource> ReadSource(const fs::path& sourcePath);
+        // Whether source image is still the one the texture was baked from
+        [[nodiscard]] bool IsUpToDate(const fs::path& sourcePath) const;
+        [[nodiscard]] BakedTextureFormat GetFormat() const;
+        [[nodiscard]] uint32_t GetWidth() const;
+        [[nodiscard]] uint32_t GetHeight() const;
+        // Whether image was flipped vertically before compression
+        [[nodiscard]] bool IsFlipped() const;
+        [[nodiscard]] size_t GetLevelsCount() const;
+        [[nodiscard]] uint32_t GetLevelWidth(size_t level) const;
+        [[nodiscard]] uint32_t GetLevelHeight(size_t level) const;
+        [[nodiscard]] const std::vector<std::byte>& GetLevel(size_t level) const;
+        // Size of all levels together
+        [[nodiscard]] size_t GetDataSize() const;
+    private:
+        struct Header
+        {
+            char Magic[8];
+            uint32_t Version;
+            uint32_t Format;
+            uint32_t Width;
+            uint32_t Height;
+            uint32_t IsFlipped;
+            uint32_t LevelsCount;
+            uint64_t SourceSize;
+            int64_t SourceModificationTime;
+        };
+
+        BakedTextureFormat _format;
+        uint32_t _width;
+        uint32_t _height;
+        bool _isFlipped;
+        BakedTextureSource _source;
+        std::vector<std::vector<std::byte>> _levels;
+
+        // Consts
+        static constexpr char MAGIC[8] = { 'R', '3', 'D', 'K', 'T', 'X', '\r', '\n' };
+        static constexpr uint32_t VERSION = 2;
+        static constexpr auto EXTENSION = ".baked";
+        static constexpr size_t LEVEL_ALIGNMENT = 4;
+    };
+
+} // Renderer3D
+
+#endif //BAKED_TEXTURE_H
@@ -200,6 +200,11 @@ namespace Renderer3D {
         }
     }
 
+    const SpotLightSource* Camera::GetFlashlight() const
+    {
+        return _flashlight.get();
+    }
+
     void Camera::UpdateCameraVectors()
     {
         glm::vec3 front;
@@ -52,6 +52,7 @@ namespace Renderer3D {
         void CreateFlashlight(SpotLightsFactory& spotLightsFactory);
         void SetFlashlightUniforms(const std::shared_ptr<Shader>& lightingPassShader) const;
         void UpdateUseFlashlight(bool useFlashlight) const;
+        [[nodiscard]] const SpotLightSource* GetFlashlight() const;
     private:
         // Camera attributes
         glm::vec3 _position{};
@@ -11,6 +11,7 @@
 #include <backends/imgui_impl_opengl3.h>
 
 #include "controls.h"
+#include "point_shadow_maps.h"
 
 namespace Renderer3D {
     Controls::Controls(const Window& window)
@@ -49,7 +50,155 @@ namespace Renderer3D {
         // Fps data
         ImGui::Spacing();
         ImGui::Text("FPS: %.2f", 1.0f / deltaTima);
+        ImGui::Text("GPU frame time: %.2f ms", _gpuFrameTime);
+        if (_pendingModels > 0 || _pendingTextures > 0)
+        {
+            ImGui::Text("Loading models: %zu, textures: %zu", _pendingModels, _pendingTextures);
+        }
+        ImGui::Text("Textures: %zu resident, %zu path hits, %zu content hits, %zu misses, %zu evicted", _textureCacheStatistics.ResidentTextures,
+            _textureCacheStatistics.PathHits, _textureCacheStatistics.ContentHits, _textureCacheStatistics.Misses, _textureCacheStatistics.Evictions);
+        // Texture streaming - detailed mips of model textures are kept within the budget
+        ImGui::SliderInt("Texture budget (MB)", &_textureBudget, 16, 2048);
+        ImGui::Text("Streaming: %.1f MB in %zu textures, %zu loading, %zu levels evicted", static_cast<float>(_textureStreamingStatistics.ResidentSize) / static_cast<float>(BYTES_PER_MEGABYTE),
+            _textureStreamingStatistics.StreamedTextures, _textureStreamingStatistics.PendingLoads, _textureStreamingStatistics.EvictedLevels);
+        // Mesh memory - CPU bytes stay zero unless a model retains its data for CPU side algorithms
+        MeshMemoryUsage totalUsage;
+        for (const auto& [_, usage] : _modelMemoryUsages)
+        {
+            totalUsage.CpuBytes += usage.CpuBytes;
+            totalUsage.GpuBytes += usage.GpuBytes;
+        }
+        ImGui::Text("Meshes: %.1f MB CPU, %.1f MB GPU in %zu models", static_cast<float>(totalUsage.CpuBytes) / static_cast<float>(BYTES_PER_MEGABYTE),
+            static_cast<float>(totalUsage.GpuBytes) / static_cast<float>(BYTES_PER_MEGABYTE), _modelMemoryUsages.size());
+        ImGui::Checkbox("Model memory", &_isModelMemoryVisible);
+        if (_isModelMemoryVisible)
+        {
+            for (const auto& [name, usage] : _modelMemoryUsages)
+            {
+                ImGui::Text("%s: %.2f MB CPU, %.2f MB GPU", name.c_str(), static_cast<float>(usage.CpuBytes) / static_cast<float>(BYTES_PER_MEGABYTE),
+                    static_cast<float>(usage.GpuBytes) / static_cast<float>(BYTES_PER_MEGABYTE));
+            }
+        }
+        // Mesh LODs - positive bias switches to simplified meshes closer to the camera
+        ImGui::SliderFloat("LOD bias", &_lodBias, MIN_LOD_BIAS, MAX_LOD_BIAS);
+        ImGui::Spacing();
+
+        // Per pass statistics - triangles and fragments tell whether a pass is bound by geometry, fill rate or shading
+        ImGui::Checkbox("Pass statistics", &_isPassStatisticsVisible);
+        if (_isPassStatisticsVisible)
+        {
+            for (const auto& pass : _passStatistics)
+            {
+                ImGui::Text("%s: %.2f ms, %llu samples", pass.Name.c_str(), pass.GpuTime, static_cast<unsigned long long>(pass.SamplesPassed));
+                if (_hasPipelineStatistics)
+                {
+                    ImGui::Text("    %llu vertices, %llu primitives, %llu fragment invocations", static_cast<unsigned long long>(pass.VerticesSubmitted), static_cast<unsigned long long>(pass.PrimitivesSubmitted), static_cast<unsigned long long>(pass.FragmentShaderInvocations));
+                }
+            }
+            if (!_hasPipelineStatistics)
+            {
+                ImGui::Text("Pipeline statistics are not supported, only samples passed are counted");
+            }
+            if (ImGui::Button("Export benchmark"))
+            {
+                _isBenchmarkExportRequested = true;
+            }
+        }
+
+        // Dynamic resolution - render scale follows GPU frame time budget
+        ImGui::Spacing();
+        ImGui::Checkbox("Dynamic resolution", &_isDynamicResolution);
+        // Quality governor - lowers quality knobs one at a time to hold the same frame time budget
+        ImGui::Checkbox("Quality governor", &_isQualityGovernor);
+        if (_isDynamicResolution || _isQualityGovernor)
+        {
+            ImGui::SliderFloat("Target frame time (ms)", &_targetFrameTime, 4.0f, 33.3f, "%.1f");
+        }
+        ImGui::Text("Render scale: %.2f", _renderScale);
+        if (_isQualityGovernor)
+        {
+            const auto level = [this](const QualityKnob knob)
+            {
+                return std::format("{}/{}", _governorLevels[static_cast<size_t>(knob)], QualityGovernor::GetMaxLevel(knob));
+            };
+            ImGui::Text("Marker LOD: %zu (step %s)", _governedQuality.MarkerLod, level(QualityKnob::MARKER_LOD).c_str());
+            ImGui::Text("Mesh LOD bias: %.1f (step %s)", _governedQuality.MeshLodBias, level(QualityKnob::MESH_LOD_BIAS).c_str());
+            ImGui::Text("Shadow updates: %zu, point shadows: %zu (step %s)", _governedQuality.ShadowUpdateBudget, _governedQuality.PointShadowSlots, level(QualityKnob::SHADOW_BUDGET).c_str());
+            ImGui::Text("Max lights per tile: %zu (step %s)", _governedQuality.MaxLightsPerTile, level(QualityKnob::MAX_LIGHTS_PER_TILE).c_str());
+            ImGui::Text("Light influence threshold: %.3f (step %s)", _governedQuality.LightInfluenceThreshold, level(QualityKnob::LIGHT_INFLUENCE_THRESHOLD).c_str());
+        }
+
+        // Rendering path - visibility buffer samples material textures only once per pixel
+        ImGui::Spacing();
+        ImGui::Text("Rendering path");
+        if (ImGui::RadioButton("G-buffer", _renderingPath == RenderingPath::G_BUFFER))
+        {
+            _renderingPath = RenderingPath::G_BUFFER;
+        }
+        if (ImGui::RadioButton("Visibility buffer", _renderingPath == RenderingPath::VISIBILITY_BUFFER))
+        {
+            _renderingPath = RenderingPath::VISIBILITY_BUFFER;
+        }
+        if (ImGui::RadioButton("Forward+", _renderingPath == RenderingPath::FORWARD_PLUS))
+        {
+            _renderingPath = RenderingPath::FORWARD_PLUS;
+        }
+
+        // Depth prepass - pays off when overdraw without it is high, forward+ always needs it
+        ImGui::Spacing();
+        if (_renderingPath == RenderingPath::G_BUFFER)
+        {
+            ImGui::Checkbox("Depth prepass", &_isDepthPrepass);
+        }
+        if (_renderingPath != RenderingPath::VISIBILITY_BUFFER)
+        {
+            ImGui::Text("Geometry pass overdraw: %.2fx", _geometryOverdraw);
+        }
+
+        // Temporal reprojection - lighting is amortized over 4 frames, forward+ has no separate lighting pass
+        if (_renderingPath != RenderingPath::FORWARD_PLUS)
+        {
+            ImGui::Checkbox("Temporal reprojection", &_isTemporalReprojection);
+        }
+
+        // Spotlight shadows - only a few atlas tiles are updated every frame
         ImGui::Spacing();
+        ImGui::Checkbox("Spotlight shadows", &_isSpotLightShadows);
+        if (_isSpotLightShadows)
+        {
+            ImGui::SliderInt("Shadow updates per frame", &_shadowUpdateBudget, 1, 16);
+            ImGui::Text("Shadow tiles updated: %zu (static redraws: %zu)", _updatedShadowTiles, _staticShadowRenders);
+        }
+        // Point light shadows - only the most important lights get one of the slots
+        ImGui::SliderInt("Shadowed point lights", &_pointShadowSlots, 0, static_cast<int>(PointShadowMaps::MAX_SLOTS));
+        if (_pointShadowSlots > 0)
+        {
+            ImGui::Text("Point lights with shadows: %zu", _shadowedPointLights);
+        }
+
+        // Debug view - replaces lit image with a heatmap, blue is low and red is high
+        ImGui::Spacing();
+        ImGui::Text("Debug view");
+        if (ImGui::RadioButton("None", _debugView == DebugView::NONE))
+        {
+            _debugView = DebugView::NONE;
+        }
+        if (ImGui::RadioButton("Light count", _debugView == DebugView::LIGHT_COUNT))
+        {
+            _debugView = DebugView::LIGHT_COUNT;
+        }
+        if (ImGui::RadioButton("Overdraw", _debugView == DebugView::OVERDRAW))
+        {
+            _debugView = DebugView::OVERDRAW;
+        }
+        if (_debugView == DebugView::LIGHT_COUNT)
+        {
+            ImGui::Text("Lights passing radius or cone test, red is 32+");
+        }
+        else if (_debugView == DebugView::OVERDRAW)
+        {
+            ImGui::Text("Geometry pass fragments per pixel, red is 8+");
+        }
 
         // Projection type
         ImGui::Spacing();
@@ -180,6 +329,9 @@ namespace Renderer3D {
             ImGui::PopStyleVar();
             ImGui::PopItemFlag();
         }
+        // Light tree - distant or dim clusters of lights are shaded as a single light
+        ImGui::SliderFloat("Light tree error", &_lightTreeErrorBound, 0.0f, 1.0f, "%.3f");
+        ImGui::SliderInt("Max lights per tile", &_maxLightsPerTile, 1, 512);
 
         // Scene mode
         ImGui::Spacing();
@@ -212,6 +364,71 @@ namespace Renderer3D {
         _canAddPointLight = canAdd;
     }
 
+    void Controls::UpdateDynamicResolutionStats(const float renderScale, const float gpuFrameTime)
+    {
+        _renderScale = renderScale;
+        _gpuFrameTime = gpuFrameTime;
+    }
+
+    void Controls::UpdateGeometryOverdraw(const float overdraw)
+    {
+        _geometryOverdraw = overdraw;
+    }
+
+    void Controls::UpdateShadowStats(const size_t updatedTiles, const size_t staticRenders)
+    {
+        _updatedShadowTiles = updatedTiles;
+        _staticShadowRenders = staticRenders;
+    }
+
+    void Controls::UpdatePointShadowStats(const size_t shadowedLights)
+    {
+        _shadowedPointLights = shadowedLights;
+    }
+
+    void Controls::UpdateGovernorStats(const QualityGovernor& governor)
+    {
+        _governedQuality = governor.GetSettings();
+        for (size_t knob = 0; knob < std::size(_governorLevels); knob++)
+        {
+            _governorLevels[knob] = governor.GetLevel(static_cast<QualityKnob>(knob));
+        }
+    }
+
+    void Controls::UpdateProfilerStats(const std::vector<PassStatistics>& passStatistics, const bool hasPipelineStatistics)
+    {
+        _passStatistics = passStatistics;
+        _hasPipelineStatistics = hasPipelineStatistics;
+    }
+
+    void Controls::UpdateLoadingStats(const size_t pendingModels, const size_t pendingTextures)
+    {
+        _pendingModels = pendingModels;
+        _pendingTextures = pendingTextures;
+    }
+
+    void Controls::UpdateTextureCacheStats(const TextureCacheStatistics& statistics)
+    {
+        _textureCacheStatistics = statistics;
+    }
+
+    void Controls::UpdateTextureStreamingStats(const TextureStreamingStatistics& statistics)
+    {
+        _textureStreamingStatistics = statistics;
+    }
+
+    void Controls::UpdateModelMemoryStats(std::vector<ModelMemoryUsage> usages)
+    {
+        _modelMemoryUsages = std::move(usages);
+    }
+
+    bool Controls::ConsumeBenchmarkExportRequest()
+    {
+        const auto isRequested = _isBenchmarkExportRequested;
+        _isBenchmarkExportRequested = false;
+        return isRequested;
+    }
+
     SceneMode Controls::GetSceneMode() const
     {
         return _sceneMode;
@@ -256,4 +473,84 @@ namespace Renderer3D {
     {
         return _selectedUfoIndex;
     }
+
+    float Controls::GetLightTreeErrorBound() const
+    {
+        return _lightTreeErrorBound;
+    }
+
+    size_t Controls::GetMaxLightsPerTile() const
+    {
+        return static_cast<size_t>(_maxLightsPerTile);
+    }
+
+    bool Controls::IsDynamicResolution() const
+    {
+        return _isDynamicResolution;
+    }
+
+    bool Controls::IsQualityGovernor() const
+    {
+        return _isQualityGovernor;
+    }
+
+    QualitySettings Controls::GetConfiguredQuality() const
+    {
+        QualitySettings quality;
+        quality.ShadowUpdateBudget = GetShadowUpdateBudget();
+        quality.PointShadowSlots = GetPointShadowSlots();
+        quality.MaxLightsPerTile = GetMaxLightsPerTile();
+        quality.MeshLodBias = GetLodBias();
+        return quality;
+    }
+
+    float Controls::GetTargetFrameTime() const
+    {
+        return _targetFrameTime;
+    }
+
+    bool Controls::IsDepthPrepass() const
+    {
+        return _isDepthPrepass;
+    }
+
+    bool Controls::IsTemporalReprojection() const
+    {
+        return _isTemporalReprojection;
+    }
+
+    RenderingPath Controls::GetRenderingPath() const
+    {
+        return _renderingPath;
+    }
+
+    bool Controls::IsSpotLightShadows() const
+    {
+        return _isSpotLightShadows;
+    }
+
+    size_t Controls::GetShadowUpdateBudget() const
+    {
+        return static_cast<size_t>(_shadowUpdateBudget);
+    }
+
+    size_t Controls::GetPointShadowSlots() const
+    {
+        return static_cast<size_t>(_pointShadowSlots);
+    }
+
+    DebugView Controls::GetDebugView() const
+    {
+        return _debugView;
+    }
+
+    size_t Controls::GetTextureBudget() const
+    {
+        return static_cast<size_t>(_textureBudget) * BYTES_PER_MEGABYTE;
+    }
+
+    float Controls::GetLodBias() const
+    {
+        return _lodBias;
+    }
 } // Renderer3D
\ No newline at end of file
@@ -5,8 +5,13 @@
 #ifndef CONTROLS_H
 #define CONTROLS_H
 
+#include "gpu_profiler.h"
+#include "models_manager.h"
+#include "quality_governor.h"
 #include "window.h"
 #include "scene.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
 
 namespace Renderer3D {
 
@@ -39,12 +44,39 @@ namespace Renderer3D {
 
     constexpr size_t CAMERA_TYPE_COUNT = 4;
 
+    enum class RenderingPath
+    {
+        G_BUFFER,
+        VISIBILITY_BUFFER,
+        FORWARD_PLUS
+    };
+
+    // IMPORTANT: order must match DEBUG_VIEW_* constants in shaders
+    enum class DebugView
+    {
+        NONE,
+        LIGHT_COUNT,
+        OVERDRAW
+    };
+
     class Controls {
     public:
         explicit Controls(const Window& window);
         ~Controls();
         void Draw(float deltaTima, const std::unique_ptr<PointLightsContainer>& pointLightsContainer);
         void UpdateCanAddPointLight(bool canAdd);
+        void UpdateDynamicResolutionStats(float renderScale, float gpuFrameTime);
+        void UpdateGeometryOverdraw(float overdraw);
+        void UpdateShadowStats(size_t updatedTiles, size_t staticRenders);
+        void UpdatePointShadowStats(size_t shadowedLights);
+        void UpdateGovernorStats(const QualityGovernor& governor);
+        void UpdateProfilerStats(const std::vector<PassStatistics>& passStatistics, bool hasPipelineStatistics);
+        void UpdateLoadingStats(size_t pendingModels, size_t pendingTextures);
+        void UpdateTextureCacheStats(const TextureCacheStatistics& statistics);
+        void UpdateTextureStreamingStats(const TextureStreamingStatistics& statistics);
+        void UpdateModelMemoryStats(std::vector<ModelMemoryUsage> usages);
+        // Returns true once after export button was pressed
+        [[nodiscard]] bool ConsumeBenchmarkExportRequest();
         [[nodiscard]] SceneMode GetSceneMode() const;
         [[nodiscard]] float GetFogStrength() const;
         [[nodiscard]] bool IsFog() const;
@@ -54,6 +86,24 @@ namespace Renderer3D {
         [[nodiscard]] FlashlightDirections GetUfosFlashlightDirection() const;
         [[nodiscard]] CameraType GetCameraType() const;
         [[nodiscard]] size_t GetSelectedUfoIndex() const;
+        [[nodiscard]] float GetLightTreeErrorBound() const;
+        [[nodiscard]] size_t GetMaxLightsPerTile() const;
+        [[nodiscard]] bool IsDynamicResolution() const;
+        [[nodiscard]] bool IsQualityGovernor() const;
+        // Quality chosen by the user, quality governor can only lower it
+        [[nodiscard]] QualitySettings GetConfiguredQuality() const;
+        [[nodiscard]] float GetTargetFrameTime() const;
+        [[nodiscard]] bool IsDepthPrepass() const;
+        [[nodiscard]] bool IsTemporalReprojection() const;
+        [[nodiscard]] RenderingPath GetRenderingPath() const;
+        [[nodiscard]] bool IsSpotLightShadows() const;
+        [[nodiscard]] size_t GetShadowUpdateBudget() const;
+        [[nodiscard]] size_t GetPointShadowSlots() const;
+        [[nodiscard]] DebugView GetDebugView() const;
+        // In bytes
+        [[nodiscard]] size_t GetTextureBudget() const;
+        // In LODs, added to the one picked from the size on screen
+        [[nodiscard]] float GetLodBias() const;
     private:
         SceneMode _sceneMode = SceneMode::Day;
         float _fogStrength = 0.0f;
@@ -63,6 +113,39 @@ namespace Renderer3D {
         CameraType _cameraType = CameraType::MOVING;
         size_t _selectedUfoIndex = 0;
         bool _canAddPointLight = true;
+        float _lightTreeErrorBound = 0.02f;
+        int _maxLightsPerTile = 128;
+        bool _isDynamicResolution = false;
+        bool _isQualityGovernor = false;
+        QualitySettings _governedQuality;
+        size_t _governorLevels[static_cast<size_t>(QualityKnob::COUNT)] = {};
+        float _targetFrameTime = 16.6f;
+        float _renderScale = 1.0f;
+        float _gpuFrameTime = 0.0f;
+        bool _isDepthPrepass = false;
+        float _geometryOverdraw = 0.0f;
+        bool _isTemporalReprojection = false;
+        RenderingPath _renderingPath = RenderingPath::G_BUFFER;
+        bool _isSpotLightShadows = false;
+        int _shadowUpdateBudget = 4;
+        size_t _updatedShadowTiles = 0;
+        size_t _staticShadowRenders = 0;
+        int _pointShadowSlots = 0;
+        size_t _shadowedPointLights = 0;
+        DebugView _debugView = DebugView::NONE;
+        bool _isPassStatisticsVisible = false;
+        std::vector<PassStatistics> _passStatistics;
+        bool _hasPipelineStatistics = false;
+        bool _isBenchmarkExportRequested = false;
+        size_t _pendingModels = 0;
+        size_t _pendingTextures = 0;
+        TextureCacheStatistics _textureCacheStatistics;
+        // In megabytes
+        int _textureBudget = 256;
+        TextureStreamingStatistics _textureStreamingStatistics;
+        bool _isModelMemoryVisible = false;
+        std::vector<ModelMemoryUsage> _modelMemoryUsages;
+        float _lodBias = 0.0f;
         // Consts
         static constexpr float MIN_X = -15.0f;
         static constexpr float MAX_X = 15.0f;
@@ -70,6 +153,9 @@ namespace Renderer3D {
         static constexpr float MAX_Y = 4.0f;
         static constexpr float MIN_Z = -15.0f;
         static constexpr float MAX_Z = 15.0f;
+        static constexpr size_t BYTES_PER_MEGABYTE = 1024 * 1024;
+        static constexpr float MIN_LOD_BIAS = -2.0f;
+        static constexpr float MAX_LOD_BIAS = 4.0f;
     };
 
 } // Renderer3D
@@ -2,6 +2,9 @@
 // Created by Kacper Trzciński on 16.01.2025.
 //
 
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/type_ptr.hpp>
 #include <spdlog/spdlog.h>
 
 #include "deferred_shaderer.h"
@@ -11,102 +14,374 @@ namespace Renderer3D {
     {
         _width = width;
         _height = height;
+        _depthPrepassShader = std::make_shared<Shader>("../assets/shaders/depth_prepass_vertex.glsl", "../assets/shaders/depth_prepass_fragment.glsl");
         _geometryPassShader = std::make_shared<Shader>("../assets/shaders/model_geometry_pass_vertex.glsl", "../assets/shaders/model_geometry_pass_fragment.glsl");
         _lightingPassShader = std::make_shared<Shader>("../assets/shaders/model_lighting_pass_vertex.glsl", "../assets/shaders/model_lighting_pass_fragment.glsl");
+        _forwardPassShader = std::make_shared<Shader>("../assets/shaders/forward_pass_vertex.glsl", "../assets/shaders/forward_pass_fragment.glsl");
+        _presentShader = std::make_shared<Shader>("../assets/shaders/present_vertex.glsl", "../assets/shaders/present_fragment.glsl");
+        _overdrawShader = std::make_shared<Shader>("../assets/shaders/depth_prepass_vertex.glsl", "../assets/shaders/overdraw_fragment.glsl");
 
         SetupQuadData();
 
-        // Generate g buffer
+        // Generate g buffer and scene buffer - scene buffer reuses gBuffer depth,
+        // so forward rendered objects are depth tested without copying depth anywhere
         glGenFramebuffers(1, &_gBuffer);
-        glBindFramebuffer(GL_FRAMEBUFFER, _gBuffer);
-
-        CreatePositionBuffer(width, height);
-        CreateNormalBuffer(width, height);
-        CreateAlbedoSpecBuffer(width, height);
-
-        // Set which color attachments are used for rendering
-        // In our case we need 3, because we have multiple render targets
-        constexpr unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
-        glDrawBuffers(3, attachments);
-
-        CreateDepthBuffer(width, height);
-
-        // Check if there was any error
-        CheckFramebufferStatus();
-
-        // Cleanup state
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glGenFramebuffers(1, &_sceneBuffer);
+        glGenFramebuffers(1, &_lightingBuffer);
+        AcquireTargets(width, height);
+        AttachTargets();
 
         // Setup gBuffer uniforms in lighting pass shader
         SetupLightingPassShader();
+        _presentShader->Activate();
+        _presentShader->SetUniform("sceneColor", 0);
+        _presentShader->SetUniform("sceneDepth", 1);
+        _presentShader->SetUniform("debugView", static_cast<int>(_debugView));
+        UpdateRenderSize();
     }
 
-    DeferredShaderer::DeferredShaderer(DeferredShaderer&& shaderer) noexcept
+    DeferredShaderer::DeferredShaderer(DeferredShaderer&& shaderer) noexcept : _visibilityBuffer(std::move(shaderer._visibilityBuffer)), _targetPool(std::move(shaderer._targetPool))
     {
         shaderer._isMoved = true;
         _gBuffer = shaderer._gBuffer;
-        _gPosition = shaderer._gPosition;
+        _gDepth = shaderer._gDepth;
         _gNormal = shaderer._gNormal;
         _gAlbedoSpec = shaderer._gAlbedoSpec;
-        _rboDepth = shaderer._rboDepth;
+        _sceneBuffer = shaderer._sceneBuffer;
+        _sceneColor = shaderer._sceneColor;
+        _lightingBuffer = shaderer._lightingBuffer;
+        _isTemporalReprojection = shaderer._isTemporalReprojection;
+        _isHistoryValid = shaderer._isHistoryValid;
+        for (size_t i = 0; i < 2; i++)
+        {
+            _historyColor[i] = shaderer._historyColor[i];
+            _historyDistance[i] = shaderer._historyDistance[i];
+        }
+        _historyIndex = shaderer._historyIndex;
+        _frameIndex = shaderer._frameIndex;
+        _previousViewProjection = shaderer._previousViewProjection;
+        _previousCameraPos = shaderer._previousCameraPos;
+        _isVisibilityBuffer = shaderer._isVisibilityBuffer;
+        _debugView = shaderer._debugView;
         _width = shaderer._width;
         _height = shaderer._height;
+        _renderScale = shaderer._renderScale;
+        _renderWidth = shaderer._renderWidth;
+        _renderHeight = shaderer._renderHeight;
         _quadVaoID = shaderer._quadVaoID;
         _quadVboID = shaderer._quadVboID;
+        _depthPrepassShader = shaderer._depthPrepassShader;
         _geometryPassShader = shaderer._geometryPassShader;
         _lightingPassShader = shaderer._lightingPassShader;
+        _forwardPassShader = shaderer._forwardPassShader;
+        _presentShader = shaderer._presentShader;
+        _overdrawShader = shaderer._overdrawShader;
     }
 
     void DeferredShaderer::Resize(const size_t width, const size_t height)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, _gBuffer);
         _width = width;
         _height = height;
-        const auto previousGPosition = _gPosition;
-        CreatePositionBuffer(width, height);
-        glDeleteTextures(1, &previousGPosition);
-        const auto previousGNormal = _gNormal;
-        CreateNormalBuffer(width, height);
-        glDeleteTextures(1, &previousGNormal);
-        const auto previousGAlbedoSpec = _gAlbedoSpec;
-        CreateAlbedoSpecBuffer(width, height);
-        glDeleteTextures(1, &previousGAlbedoSpec);
-        const auto previousDepthBuffer = _rboDepth;
-        CreateDepthBuffer(width, height);
-        glDeleteRenderbuffers(1, &previousDepthBuffer);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // Current targets are kept as long as the new size fits into them without wasting too much memory
+        if (_gDepth.Width < width || _gDepth.Height < height || RenderTargetPool::IsWastingMemory(_gDepth, width, height))
+        {
+            ReleaseTargets();
+            AcquireTargets(width, height);
+            AttachTargets();
+        }
+        UpdateRenderSize();
     }
 
-    void DeferredShaderer::BindGBuffer() const
+    void DeferredShaderer::SetRenderScale(const float scale)
     {
+        if (scale == _renderScale)
+        {
+            return;
+        }
+        _renderScale = scale;
+        UpdateRenderSize();
+    }
 
+    void DeferredShaderer::BindGBuffer() const
+    {
+        glViewport(0, 0, static_cast<GLsizei>(_renderWidth), static_cast<GLsizei>(_renderHeight));
         glBindFramebuffer(GL_FRAMEBUFFER, _gBuffer);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        EnableGeometryStencil();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+
+    void DeferredShaderer::BindForwardPass(const bool useFog) const
+    {
+        // Forward+ shades straight into scene buffer - gBuffer color targets are not touched at all,
+        // while depth and stencil are the shared ones, so forward effects and present work like in deferred path
+        glViewport(0, 0, static_cast<GLsizei>(_renderWidth), static_cast<GLsizei>(_renderHeight));
+        glBindFramebuffer(GL_FRAMEBUFFER, _sceneBuffer);
+        EnableGeometryStencil();
+        const auto clearColor = GetClearColor(useFog);
+        glClearBufferfv(GL_COLOR, 0, glm::value_ptr(clearColor));
+        glClear(GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    }
+
+    void DeferredShaderer::BeginDepthPrepass() const
+    {
+        // Only depth is written, so fragment shader cost is close to zero
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        _depthPrepassShader->Activate();
     }
 
     // ReSharper disable once CppMemberFunctionMayBeStatic
-    void DeferredShaderer::UnbindGBuffer() const
+    void DeferredShaderer::EndDepthPrepass() const // NOLINT(*-convert-member-functions-to-static)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Depth is final now - geometry pass only shades the visible fragment of every pixel
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    // ReSharper disable once CppMemberFunctionMayBeStatic
+    void DeferredShaderer::EndGeometryPass() const // NOLINT(*-convert-member-functions-to-static)
+    {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glStencilMask(0x00);
+        glDisable(GL_STENCIL_TEST);
+    }
+
+    void DeferredShaderer::SetDebugView(const DebugView debugView)
+    {
+        if (debugView == _debugView)
+        {
+            return;
+        }
+        _debugView = debugView;
+        for (const auto& shader : {_lightingPassShader, _forwardPassShader, _presentShader})
+        {
+            shader->Activate();
+            shader->SetUniform("debugView", static_cast<int>(debugView));
+        }
+    }
+
+    void DeferredShaderer::BeginOverdrawPass() const
+    {
+        // Replaces geometry pass with the same depth state, every fragment that passes depth test adds one to scene color
+        glBindFramebuffer(GL_FRAMEBUFFER, _sceneBuffer);
+        constexpr float zeros[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, zeros);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        _overdrawShader->Activate();
+    }
+
+    void DeferredShaderer::EndOverdrawPass() const
+    {
+        glDisable(GL_BLEND);
+        EndGeometryPass();
+    }
+
+    void DeferredShaderer::SetVisibilityBuffer(const bool enabled)
+    {
+        if (enabled == _isVisibilityBuffer)
+        {
+            return;
+        }
+        _isVisibilityBuffer = enabled;
+        if (enabled)
+        {
+            _visibilityBuffer.AcquireTargets(_targetPool, _gDepth.Width, _gDepth.Height);
+            _visibilityBuffer.AttachTargets(_gDepth, _gNormal, _gAlbedoSpec);
+        }
+        else
+        {
+            _visibilityBuffer.ReleaseTargets(_targetPool);
+        }
+    }
+
+    void DeferredShaderer::RenderVisibilityBuffer(const std::vector<VisibilityDraw>& draws, const glm::mat4& view, const glm::mat4& projection)
+    {
+        if (!_isVisibilityBuffer)
+        {
+            spdlog::error("Visibility buffer is rendered while it is disabled!");
+            return;
+        }
+        _visibilityBuffer.Render(draws, view, projection, _renderWidth, _renderHeight, _quadVaoID);
+    }
+
+    void DeferredShaderer::BindSceneBuffer(const bool useFog) const
+    {
+        // Lighting writes scene color through a framebuffer without depth, so it can sample gBuffer depth.
+        // Only color is cleared, sky pixels are never shaded, so in fog mode they just keep the fog color.
+        glBindFramebuffer(GL_FRAMEBUFFER, _lightingBuffer);
+        const auto clearColor = GetClearColor(useFog);
+        glClearBufferfv(GL_COLOR, 0, glm::value_ptr(clearColor));
+        if (_isTemporalReprojection)
+        {
+            // History written this frame - cleared, so sky pixels are never mistaken for valid history later
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _historyColor[_historyIndex].Texture, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, _historyDistance[_historyIndex].Texture, 0);
+            // Clearing draw buffer index without an attachment assigned does nothing, so all three are enabled for it
+            constexpr unsigned int historyAttachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+            glDrawBuffers(3, historyAttachments);
+            constexpr float zeros[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 1, zeros);
+            glClearBufferfv(GL_COLOR, 2, zeros);
+            constexpr unsigned int sceneAttachments[1] = { GL_COLOR_ATTACHMENT0 };
+            glDrawBuffers(1, sceneAttachments);
+        }
+    }
+
+    void DeferredShaderer::SetTemporalReprojection(const bool enabled)
+    {
+        if (enabled == _isTemporalReprojection)
+        {
+            return;
+        }
+        _isTemporalReprojection = enabled;
+        if (enabled)
+        {
+            AcquireHistoryTargets();
+        }
+        else
+        {
+            ReleaseHistoryTargets();
+            // Lighting buffer must not keep released textures attached
+            glBindFramebuffer(GL_FRAMEBUFFER, _lightingBuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 0, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        _lightingPassShader->Activate();
+        _lightingPassShader->SetUniform("useTemporalReprojection", enabled);
+    }
+
+    void DeferredShaderer::UpdateChangedSpotLights(const std::vector<const SpotLightSource*>& spotLights, const ShadowAtlas& shadowAtlas)
+    {
+        // Lights missing from the list were removed, which is the same as switching them off
+        std::array<SpotLightCone, MAX_NR_SPOT_LIGHTS> currentSpotLights = {};
+        for (const auto* spotLight : spotLights)
+        {
+            if (spotLight->GetId() < MAX_NR_SPOT_LIGHTS)
+            {
+                currentSpotLights[spotLight->GetId()] = {
+                    spotLight->IsActive(), spotLight->GetPosition(), glm::normalize(spotLight->GetDirection()), spotLight->GetOuterCutOff()
+                };
+            }
+        }
+
+        int conesCount = 0;
+        const auto addCone = [&](const SpotLightCone& cone) {
+            const auto index = "[" + std::to_string(conesCount++) + "]";
+            _lightingPassShader->SetUniform("changedSpotConePositions" + index, cone.Position);
+            _lightingPassShader->SetUniform("changedSpotConeDirections" + index, cone.Direction);
+            _lightingPassShader->SetUniform("changedSpotConeOuterCutOffs" + index, cone.OuterCutOff);
+        };
+        for (size_t i = 0; i < MAX_NR_SPOT_LIGHTS; i++)
+        {
+            const auto& previous = _previousSpotLights[i];
+            const auto& current = currentSpotLights[i];
+            if (previous == current)
+            {
+                // Same cone, but shadow casters inside it moved
+                if (current.IsActive && shadowAtlas.IsTileUpdated(i))
+                {
+                    addCone(current);
+                }
+                continue;
+            }
+            // Light disappeared from the old cone and appeared in the new one
+            if (previous.IsActive)
+            {
+                addCone(previous);
+            }
+            if (current.IsActive)
+            {
+                addCone(current);
+            }
+        }
+        _lightingPassShader->SetUniform("changedSpotConesCount", conesCount);
+        _previousSpotLights = currentSpotLights;
+    }
+
+    void DeferredShaderer::RenderLightingPass(const glm::mat4& viewProjection, const glm::vec3& cameraPos)
+    {
+        // IMPORTANT: lighting pass shader must be active and scene buffer bound with BindSceneBuffer
+        if (_isTemporalReprojection)
+        {
+            // Lighting is written to scene color and to history at the same time
+            constexpr unsigned int attachments[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+            glDrawBuffers(3, attachments);
+            const auto previousIndex = 1 - _historyIndex;
+            glActiveTexture(GL_TEXTURE0 + HISTORY_COLOR_TEXTURE_UNIT);
+            glBindTexture(GL_TEXTURE_2D, _historyColor[previousIndex].Texture);
+            glActiveTexture(GL_TEXTURE0 + HISTORY_DISTANCE_TEXTURE_UNIT);
+            glBindTexture(GL_TEXTURE_2D, _historyDistance[previousIndex].Texture);
+            _lightingPassShader->SetUniform("isHistoryValid", _isHistoryValid);
+            _lightingPassShader->SetUniform("previousViewProjection", _previousViewProjection);
+            _lightingPassShader->SetUniform("previousCameraPos", _previousCameraPos);
+            _lightingPassShader->SetUniform("frameIndex", _frameIndex);
+        }
+
+        // Lighting buffer has no depth-stencil, so the shader itself skips sky pixels using the depth it samples
+        RenderQuad();
+
+        if (_isTemporalReprojection)
+        {
+            // Forward rendered objects must not end up in history
+            constexpr unsigned int attachments[1] = { GL_COLOR_ATTACHMENT0 };
+            glDrawBuffers(1, attachments);
+            _historyIndex = 1 - _historyIndex;
+            _isHistoryValid = true;
+            _frameIndex = (_frameIndex + 1) % TEMPORAL_PATTERN_SIZE;
+        }
+        _previousViewProjection = viewProjection;
+        _previousCameraPos = cameraPos;
+        // Forward effects are depth tested against gBuffer depth, which is not sampled anymore
+        glBindFramebuffer(GL_FRAMEBUFFER, _sceneBuffer);
+    }
+
+    // ReSharper disable once CppMemberFunctionMayBeStatic
+    void DeferredShaderer::BeginBackgroundPass() const // NOLINT(*-convert-member-functions-to-static)
+    {
+        // Background (skybox) is drawn only where there is no geometry
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_NOTEQUAL, GEOMETRY_STENCIL_BIT, 0xFF);
+    }
+
+    // ReSharper disable once CppMemberFunctionMayBeStatic
+    void DeferredShaderer::EndBackgroundPass() const // NOLINT(*-convert-member-functions-to-static)
+    {
+        glDisable(GL_STENCIL_TEST);
     }
 
     void DeferredShaderer::BindGTextures() const
     {
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, _gPosition);
+        glBindTexture(GL_TEXTURE_2D, _gDepth.Texture);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, _gNormal);
+        glBindTexture(GL_TEXTURE_2D, _gNormal.Texture);
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, _gAlbedoSpec);
+        glBindTexture(GL_TEXTURE_2D, _gAlbedoSpec.Texture);
     }
 
-    void DeferredShaderer::CopyDepthBufferToDefaultBuffer() const
+    void DeferredShaderer::PresentSceneBuffer() const
     {
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, _gBuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBlitFramebuffer(0, 0, _width, _height, 0, 0, _width, _height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        // Single full screen pass to default framebuffer, which therefore doesn't need depth at all.
+        // It also upscales scene color to window resolution when rendering at lower scale. Scene depth is not
+        // attached to the default framebuffer, so it is sampled directly.
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, static_cast<GLsizei>(_width), static_cast<GLsizei>(_height));
+        glDisable(GL_DEPTH_TEST);
+        _presentShader->Activate();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, _sceneColor.Texture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, _gDepth.Texture);
+        RenderQuad();
+        glEnable(GL_DEPTH_TEST);
+    }
+
+    void DeferredShaderer::EndFrame()
+    {
+        _targetPool.EndFrame();
     }
 
     void DeferredShaderer::RenderQuad() const
@@ -116,6 +391,11 @@ namespace Renderer3D {
         glBindVertexArray(0);
     }
 
+    std::shared_ptr<Shader> DeferredShaderer::GetDepthPrepassShader() const
+    {
+        return _depthPrepassShader;
+    }
+
     std::shared_ptr<Shader> DeferredShaderer::GetGeometryPassShader() const
     {
         return _geometryPassShader;
@@ -126,27 +406,57 @@ namespace Renderer3D {
         return _lightingPassShader;
     }
 
-    void DeferredShaderer::UpdateSceneMode(const SceneMode sceneMode) const
+    std::shared_ptr<Shader> DeferredShaderer::GetForwardPassShader() const
+    {
+        return _forwardPassShader;
+    }
+
+    std::shared_ptr<Shader> DeferredShaderer::GetOverdrawShader() const
+    {
+        return _overdrawShader;
+    }
+
+    size_t DeferredShaderer::GetWidth() const
+    {
+        return _width;
+    }
+
+    size_t DeferredShaderer::GetHeight() const
+    {
+        return _height;
+    }
+
+    size_t DeferredShaderer::GetRenderWidth() const
+    {
+        return _renderWidth;
+    }
+
+    size_t DeferredShaderer::GetRenderHeight() const
+    {
+        return _renderHeight;
+    }
+
+    void DeferredShaderer::UpdateSceneMode(const std::shared_ptr<Shader>& shader, const SceneMode sceneMode)
     {
         switch (sceneMode) {
         case SceneMode::Day:
-            _lightingPassShader->SetUniform("ambientLevel", AMBIENT_LEVEL_DAY);
-            _lightingPassShader->SetUniform("useFog", false);
+            shader->SetUniform("ambientLevel", AMBIENT_LEVEL_DAY);
+            shader->SetUniform("useFog", false);
             break;
         case SceneMode::Night:
-            _lightingPassShader->SetUniform("ambientLevel", AMBIENT_LEVEL_NIGHT);
-            _lightingPassShader->SetUniform("useFog", false);
+            shader->SetUniform("ambientLevel", AMBIENT_LEVEL_NIGHT);
+            shader->SetUniform("useFog", false);
             break;
         case SceneMode::Fog:
-            _lightingPassShader->SetUniform("ambientLevel", AMBIENT_LEVEL_FOG);
-            _lightingPassShader->SetUniform("useFog", true);
+            shader->SetUniform("ambientLevel", AMBIENT_LEVEL_FOG);
+            shader->SetUniform("useFog", true);
             break;
         }
     }
 
-    void DeferredShaderer::UpdateFogStrength(const float fogStrength, const float cameraFar) const
+    void DeferredShaderer::UpdateFogStrength(const std::shared_ptr<Shader>& shader, const float fogStrength, const float cameraFar)
     {
-        _lightingPassShader->SetUniform("fogMaxDist", cameraFar - fogStrength);
+        shader->SetUniform("fogMaxDist", cameraFar - fogStrength);
     }
 
     DeferredShaderer::~DeferredShaderer()
@@ -159,22 +469,16 @@ namespace Renderer3D {
         {
             glDeleteFramebuffers(1, &_gBuffer);
         }
-        if (_gPosition != 0)
+        if (_sceneBuffer != 0)
         {
-            glDeleteTextures(1, &_gPosition);
+            glDeleteFramebuffers(1, &_sceneBuffer);
         }
-        if (_gNormal != 0)
+        if (_lightingBuffer != 0)
         {
-            glDeleteTextures(1, &_gNormal);
-        }
-        if (_gAlbedoSpec != 0)
-        {
-            glDeleteTextures(1, &_gAlbedoSpec);
-        }
-        if (_rboDepth != 0)
-        {
-            glDeleteRenderbuffers(1, &_rboDepth);
+            glDeleteFramebuffers(1, &_lightingBuffer);
         }
+        // Pool deletes all targets once they are back in it
+        ReleaseTargets();
         if (_quadVaoID != 0)
         {
             glDeleteVertexArrays(1, &_quadVaoID);
@@ -185,42 +489,105 @@ namespace Renderer3D {
         }
     }
 
-    void DeferredShaderer::CreatePositionBuffer(const size_t width, const size_t height)
+    void DeferredShaderer::AcquireTargets(const size_t width, const size_t height)
     {
-        glGenTextures(1, &_gPosition);
-        glBindTexture(GL_TEXTURE_2D, _gPosition);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gPosition, 0);
+        // Octahedral encoded normal fits into two 16 bit channels
+        _gNormal = _targetPool.Acquire(GL_RG16, width, height);
+        _gAlbedoSpec = _targetPool.Acquire(GL_RGBA8, width, height);
+        // Depth is sampled in lighting pass to reconstruct positions, so it must be a texture
+        _gDepth = _targetPool.Acquire(GL_DEPTH24_STENCIL8, width, height);
+        _sceneColor = _targetPool.Acquire(GL_RGBA16F, width, height);
+        if (_isTemporalReprojection)
+        {
+            AcquireHistoryTargets();
+        }
+        if (_isVisibilityBuffer)
+        {
+            _visibilityBuffer.AcquireTargets(_targetPool, width, height);
+        }
+    }
+
+    void DeferredShaderer::ReleaseTargets()
+    {
+        _targetPool.Release(_gNormal);
+        _targetPool.Release(_gAlbedoSpec);
+        _targetPool.Release(_gDepth);
+        _targetPool.Release(_sceneColor);
+        _gNormal = {};
+        _gAlbedoSpec = {};
+        _gDepth = {};
+        _sceneColor = {};
+        ReleaseHistoryTargets();
+        if (_isVisibilityBuffer)
+        {
+            _visibilityBuffer.ReleaseTargets(_targetPool);
+        }
+    }
+
+    void DeferredShaderer::AcquireHistoryTargets()
+    {
+        // History has the same size as other targets, so they share UV mapping
+        for (size_t i = 0; i < 2; i++)
+        {
+            _historyColor[i] = _targetPool.Acquire(GL_RGBA16F, _gDepth.Width, _gDepth.Height);
+            // Reprojected position rarely hits texel center - bilinear filtering avoids blocky history
+            glBindTexture(GL_TEXTURE_2D, _historyColor[i].Texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            _historyDistance[i] = _targetPool.Acquire(GL_R32F, _gDepth.Width, _gDepth.Height);
+        }
+        _isHistoryValid = false;
     }
 
-    void DeferredShaderer::CreateNormalBuffer(const size_t width, const size_t height)
+    void DeferredShaderer::ReleaseHistoryTargets()
     {
-        glGenTextures(1, &_gNormal);
-        glBindTexture(GL_TEXTURE_2D, _gNormal);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _gNormal, 0);
+        for (size_t i = 0; i < 2; i++)
+        {
+            _targetPool.Release(_historyColor[i]);
+            _targetPool.Release(_historyDistance[i]);
+            _historyColor[i] = {};
+            _historyDistance[i] = {};
+        }
+        _isHistoryValid = false;
     }
 
-    void DeferredShaderer::CreateAlbedoSpecBuffer(const size_t width, const size_t height)
+    void DeferredShaderer::AttachTargets() const
     {
-        glGenTextures(1, &_gAlbedoSpec);
-        glBindTexture(GL_TEXTURE_2D, _gAlbedoSpec);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, _gAlbedoSpec, 0);
+        glBindFramebuffer(GL_FRAMEBUFFER, _gBuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _gNormal.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, _gAlbedoSpec.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, _gDepth.Texture, 0);
+        // Set which color attachments are used for rendering
+        // In our case we need 2, because we have multiple render targets
+        constexpr unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        CheckFramebufferStatus();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, _sceneBuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _sceneColor.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, _gDepth.Texture, 0);
+        CheckFramebufferStatus();
+
+        // Same color target without depth-stencil, history targets are attached to it every frame
+        glBindFramebuffer(GL_FRAMEBUFFER, _lightingBuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _sceneColor.Texture, 0);
+        CheckFramebufferStatus();
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        if (_isVisibilityBuffer)
+        {
+            _visibilityBuffer.AttachTargets(_gDepth, _gNormal, _gAlbedoSpec);
+        }
     }
 
-    void DeferredShaderer::CreateDepthBuffer(size_t width, size_t height)
+    // ReSharper disable once CppMemberFunctionMayBeStatic
+    void DeferredShaderer::EnableGeometryStencil() const // NOLINT(*-convert-member-functions-to-static)
     {
-        glGenRenderbuffers(1, &_rboDepth);
-        glBindRenderbuffer(GL_RENDERBUFFER, _rboDepth);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _rboDepth);
+        // Every pixel covered by geometry gets stencil bit set, so later passes can tell geometry and sky apart
+        glEnable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
+        glStencilFunc(GL_ALWAYS, GEOMETRY_STENCIL_BIT, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
     }
 
     // ReSharper disable once CppMemberFunctionMayBeStatic
@@ -254,8 +621,32 @@ namespace Renderer3D {
     void DeferredShaderer::SetupLightingPassShader() const
     {
         _lightingPassShader->Activate();
-        _lightingPassShader->SetUniform("gPosition", 0);
+        _lightingPassShader->SetUniform("gDepth", 0);
         _lightingPassShader->SetUniform("gNormal", 1);
         _lightingPassShader->SetUniform("gAlbedoSpec", 2);
+        _lightingPassShader->SetUniform("historyColor", HISTORY_COLOR_TEXTURE_UNIT);
+        _lightingPassShader->SetUniform("historyDistance", HISTORY_DISTANCE_TEXTURE_UNIT);
+        _lightingPassShader->SetUniform("useTemporalReprojection", false);
+    }
+
+    glm::vec4 DeferredShaderer::GetClearColor(const bool useFog) const
+    {
+        // Debug views count from zero, so fog color must not leak into them
+        return useFog && _debugView == DebugView::NONE ? FOG_COLOR : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    void DeferredShaderer::UpdateRenderSize()
+    {
+        // Previous frame was rendered with different UV mapping
+        _isHistoryValid = false;
+        _renderWidth = std::max<size_t>(1, static_cast<size_t>(std::round(static_cast<float>(_width) * _renderScale)));
+        _renderHeight = std::max<size_t>(1, static_cast<size_t>(std::round(static_cast<float>(_height) * _renderScale)));
+        // Maps full screen quad coordinates to the rendered part of targets, which may be bigger than the window
+        const auto uvScale = glm::vec2(static_cast<float>(_renderWidth) / static_cast<float>(_gDepth.Width), static_cast<float>(_renderHeight) / static_cast<float>(_gDepth.Height));
+        _lightingPassShader->Activate();
+        _lightingPassShader->SetUniform("renderScale", uvScale);
+        _presentShader->Activate();
+        _presentShader->SetUniform("renderSize", glm::vec2(_renderWidth, _renderHeight));
+        _presentShader->SetUniform("isNativeResolution", _renderWidth == _width && _renderHeight == _height);
     }
 } // Renderer3D
\ No newline at end of file
@@ -5,10 +5,15 @@
 #ifndef DEFERRED_SHADERER_H
 #define DEFERRED_SHADERER_H
 
+#include <array>
 #include <glad/glad.h>
 
 #include "shader.h"
 #include "controls.h"
+#include "render_target_pool.h"
+#include "shadow_atlas.h"
+#include "spot_light_source.h"
+#include "visibility_buffer.h"
 
 namespace Renderer3D {
 
@@ -17,43 +22,122 @@ namespace Renderer3D {
         DeferredShaderer(size_t width, size_t height);
         DeferredShaderer(DeferredShaderer&& shaderer) noexcept;
         void Resize(size_t width, size_t height);
+        void SetRenderScale(float scale);
         void BindGBuffer() const;
-        void UnbindGBuffer() const;
+        void BindForwardPass(bool useFog) const;
+        void BeginDepthPrepass() const;
+        void EndDepthPrepass() const;
+        void EndGeometryPass() const;
+        void SetDebugView(DebugView debugView);
+        void BeginOverdrawPass() const;
+        void EndOverdrawPass() const;
+        void SetVisibilityBuffer(bool enabled);
+        void RenderVisibilityBuffer(const std::vector<VisibilityDraw>& draws, const glm::mat4& view, const glm::mat4& projection);
+        void BindSceneBuffer(bool useFog) const;
+        void SetTemporalReprojection(bool enabled);
+        // Spotlights which moved, were switched or had their shadow redrawn since the previous lighting pass make history
+        // stale inside their cones, so those pixels are shaded again. Lighting pass shader must be active.
+        void UpdateChangedSpotLights(const std::vector<const SpotLightSource*>& spotLights, const ShadowAtlas& shadowAtlas);
+        void RenderLightingPass(const glm::mat4& viewProjection, const glm::vec3& cameraPos);
+        void BeginBackgroundPass() const;
+        void EndBackgroundPass() const;
         void BindGTextures() const;
-        void CopyDepthBufferToDefaultBuffer() const;
+        void PresentSceneBuffer() const;
+        void EndFrame();
         void RenderQuad() const;
+        [[nodiscard]] std::shared_ptr<Shader> GetDepthPrepassShader() const;
         [[nodiscard]] std::shared_ptr<Shader> GetGeometryPassShader() const;
         [[nodiscard]] std::shared_ptr<Shader> GetLightingPassShader() const;
-        void UpdateSceneMode(SceneMode sceneMode) const;
-        void UpdateFogStrength(float fogStrength, float cameraFar) const;
+        [[nodiscard]] std::shared_ptr<Shader> GetForwardPassShader() const;
+        [[nodiscard]] std::shared_ptr<Shader> GetOverdrawShader() const;
+        [[nodiscard]] size_t GetWidth() const;
+        [[nodiscard]] size_t GetHeight() const;
+        [[nodiscard]] size_t GetRenderWidth() const;
+        [[nodiscard]] size_t GetRenderHeight() const;
+        static void UpdateSceneMode(const std::shared_ptr<Shader>& shader, SceneMode sceneMode);
+        static void UpdateFogStrength(const std::shared_ptr<Shader>& shader, float fogStrength, float cameraFar);
         ~DeferredShaderer();
     private:
+        // Cone of a spotlight as it was lit in the previous lighting pass
+        struct SpotLightCone
+        {
+            bool IsActive = false;
+            glm::vec3 Position = glm::vec3(0.0f);
+            glm::vec3 Direction = glm::vec3(0.0f, 0.0f, -1.0f);
+            float OuterCutOff = 1.0f;
+
+            bool operator==(const SpotLightCone&) const = default;
+        };
+
+        // Compact layout - position is reconstructed from depth, normals are octahedral encoded
         GLuint _gBuffer = 0;
-        GLuint _gPosition = 0;
-        GLuint _gNormal = 0;
-        GLuint _gAlbedoSpec = 0;
-        GLuint _rboDepth = 0;
+        RenderTarget _gDepth;
+        RenderTarget _gNormal;
+        RenderTarget _gAlbedoSpec;
+        // Lighting and forward rendering output, shares depth attachment with gBuffer
+        GLuint _sceneBuffer = 0;
+        RenderTarget _sceneColor;
+        // Scene color without depth-stencil, lighting pass samples gBuffer depth and attached texture would be a feedback loop
+        GLuint _lightingBuffer = 0;
+        // Temporal reprojection history - lit color with confidence and distance from camera, ping-ponged between frames
+        bool _isTemporalReprojection = false;
+        bool _isHistoryValid = false;
+        RenderTarget _historyColor[2];
+        RenderTarget _historyDistance[2];
+        size_t _historyIndex = 0;
+        int _frameIndex = 0;
+        glm::mat4 _previousViewProjection = glm::mat4(1.0f);
+        glm::vec3 _previousCameraPos = glm::vec3(0.0f);
+        // IMPORTANT: this value must match MAX_NR_SPOT_LIGHTS in SpotLightsFactory and shaders
+        static constexpr size_t MAX_NR_SPOT_LIGHTS = 16;
+        std::array<SpotLightCone, MAX_NR_SPOT_LIGHTS> _previousSpotLights = {};
+        // Alternative to geometry pass - fills the same gBuffer, so everything after it is shared
+        bool _isVisibilityBuffer = false;
+        VisibilityBuffer _visibilityBuffer;
+        // Debug views write raw counts into scene color, present pass turns them into a heatmap
+        DebugView _debugView = DebugView::NONE;
+        // Targets come from the pool rounded up to size buckets, so resizing mostly reuses them
+        RenderTargetPool _targetPool;
+        // Targets are at least window size, only the lower left part of them is rendered to
         size_t _width;
         size_t _height;
+        float _renderScale = 1.0f;
+        size_t _renderWidth;
+        size_t _renderHeight;
         GLuint _quadVaoID = 0;
         GLuint _quadVboID = 0;
         bool _isMoved = false;
+        std::shared_ptr<Shader> _depthPrepassShader = nullptr;
         std::shared_ptr<Shader> _geometryPassShader = nullptr;
         std::shared_ptr<Shader> _lightingPassShader = nullptr;
+        std::shared_ptr<Shader> _forwardPassShader = nullptr;
+        std::shared_ptr<Shader> _presentShader = nullptr;
+        std::shared_ptr<Shader> _overdrawShader = nullptr;
 
         // Helpers
-        void CreatePositionBuffer(size_t width, size_t height);
-        void CreateNormalBuffer(size_t width, size_t height);
-        void CreateAlbedoSpecBuffer(size_t width, size_t height);
-        void CreateDepthBuffer(size_t width, size_t height);
+        void AcquireTargets(size_t width, size_t height);
+        void ReleaseTargets();
+        void AcquireHistoryTargets();
+        void ReleaseHistoryTargets();
+        void AttachTargets() const;
         void CheckFramebufferStatus() const;
+        void EnableGeometryStencil() const;
         void SetupQuadData();
         void SetupLightingPassShader() const;
+        [[nodiscard]] glm::vec4 GetClearColor(bool useFog) const;
+        void UpdateRenderSize();
 
         // Consts
         static constexpr float AMBIENT_LEVEL_NIGHT = 0.1f;
         static constexpr float AMBIENT_LEVEL_FOG = 0.3f;
         static constexpr float AMBIENT_LEVEL_DAY = 0.6f;
+        // IMPORTANT: this value must match FOG_COLOR in shaders
+        static constexpr glm::vec4 FOG_COLOR = glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+        static constexpr GLint GEOMETRY_STENCIL_BIT = 1;
+        static constexpr int HISTORY_COLOR_TEXTURE_UNIT = 6;
+        static constexpr int HISTORY_DISTANCE_TEXTURE_UNIT = 7;
+        // IMPORTANT: this value must match constant with the same name in lighting pass shader
+        static constexpr int TEMPORAL_PATTERN_SIZE = 4;
     };
 
 } // Renderer3D
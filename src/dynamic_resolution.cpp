@@ -0,0 +1,97 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+
+#include "dynamic_resolution.h"
+
+namespace Renderer3D {
+    DynamicResolution::DynamicResolution()
+    {
+        glGenQueries(QUERY_FRAMES, _startQueries);
+        glGenQueries(QUERY_FRAMES, _endQueries);
+    }
+
+    void DynamicResolution::BeginFrame()
+    {
+        // Timestamps instead of elapsed time queries, so other passes are still free to use GL_TIME_ELAPSED
+        glQueryCounter(_startQueries[_frameIndex], GL_TIMESTAMP);
+    }
+
+    void DynamicResolution::EndFrame()
+    {
+        glQueryCounter(_endQueries[_frameIndex], GL_TIMESTAMP);
+        _isQueryIssued[_frameIndex] = true;
+        _frameIndex = (_frameIndex + 1) % QUERY_FRAMES;
+    }
+
+    void DynamicResolution::Update(const bool enabled, const float targetFrameTime, const bool canUpscale)
+    {
+        const auto hasNewSample = ReadFrameTime();
+        if (!enabled)
+        {
+            _scale = MAX_SCALE;
+            return;
+        }
+        if (!hasNewSample || _gpuFrameTime <= 0.0f)
+        {
+            return;
+        }
+
+        // Pixel cost grows with area, so scale is corrected by square root of the budget ratio
+        const auto desiredScale = _scale * std::sqrt(targetFrameTime / _gpuFrameTime);
+        // Raise resolution only when there is some headroom, otherwise scale would oscillate around the budget
+        if (desiredScale > _scale && (!canUpscale || _gpuFrameTime > targetFrameTime * UPSCALE_HEADROOM))
+        {
+            return;
+        }
+        _scale = std::clamp(_scale + (desiredScale - _scale) * ADJUST_SPEED, MIN_SCALE, MAX_SCALE);
+    }
+
+    float DynamicResolution::GetScale() const
+    {
+        return _scale;
+    }
+
+    bool DynamicResolution::IsAtMinScale() const
+    {
+        return _scale <= MIN_SCALE;
+    }
+
+    float DynamicResolution::GetGpuFrameTime() const
+    {
+        return _gpuFrameTime;
+    }
+
+    DynamicResolution::~DynamicResolution()
+    {
+        glDeleteQueries(QUERY_FRAMES, _startQueries);
+        glDeleteQueries(QUERY_FRAMES, _endQueries);
+    }
+
+    bool DynamicResolution::ReadFrameTime()
+    {
+        // Slot about to be reused holds the oldest frame
+        if (!_isQueryIssued[_frameIndex])
+        {
+            return false;
+        }
+        GLint isAvailable = 0;
+        glGetQueryObjectiv(_endQueries[_frameIndex], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+        if (!isAvailable)
+        {
+            return false;
+        }
+        GLuint64 start = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(_startQueries[_frameIndex], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(_endQueries[_frameIndex], GL_QUERY_RESULT, &end);
+        _isQueryIssued[_frameIndex] = false;
+
+        const auto frameTime = static_cast<float>(end - start) / 1000000.0f;
+        _gpuFrameTime = _gpuFrameTime <= 0.0f ? frameTime : _gpuFrameTime + (frameTime - _gpuFrameTime) * FRAME_TIME_SMOOTHING;
+        return true;
+    }
+} // Renderer3D
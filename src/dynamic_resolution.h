@@ -0,0 +1,50 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <cstddef>
+#include <glad/glad.h>
+
+namespace Renderer3D {
+
+    class DynamicResolution {
+    public:
+        DynamicResolution();
+        DynamicResolution(const DynamicResolution&) = delete;
+        DynamicResolution& operator=(const DynamicResolution&) = delete;
+        void BeginFrame();
+        void EndFrame();
+        // Upscaling waits while other quality is lowered, so it's restored before resolution
+        void Update(bool enabled, float targetFrameTime, bool canUpscale);
+        [[nodiscard]] float GetScale() const;
+        [[nodiscard]] bool IsAtMinScale() const;
+        [[nodiscard]] float GetGpuFrameTime() const;
+        ~DynamicResolution();
+    private:
+        // Timestamps are read a few frames late, so waiting for results never stalls the pipeline
+        static constexpr size_t QUERY_FRAMES = 3;
+        GLuint _startQueries[QUERY_FRAMES] = {};
+        GLuint _endQueries[QUERY_FRAMES] = {};
+        bool _isQueryIssued[QUERY_FRAMES] = {};
+        size_t _frameIndex = 0;
+        // In milliseconds
+        float _gpuFrameTime = 0.0f;
+        float _scale = MAX_SCALE;
+
+        // Helpers
+        bool ReadFrameTime();
+
+        // Consts
+        static constexpr float MIN_SCALE = 0.5f;
+        static constexpr float MAX_SCALE = 1.0f;
+        static constexpr float FRAME_TIME_SMOOTHING = 0.1f;
+        static constexpr float ADJUST_SPEED = 0.25f;
+        static constexpr float UPSCALE_HEADROOM = 0.85f;
+    };
+
+} // Renderer3D
+
+#endif //DYNAMIC_RESOLUTION_H
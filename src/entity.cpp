@@ -2,14 +2,16 @@
 // Created by Kacper Trzciński on 18.01.2025.
 //
 
+#include <algorithm>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "entity.h"
 
 namespace Renderer3D {
-    Entity::Entity(const fs::path& modelPath, bool flipTextures, const glm::vec3 position, const float rotationX, const float rotationY, const float rotationZ, const glm::vec3 scale) : _position(position), _rotationX(rotationX), _rotationY(rotationY), _rotationZ(rotationZ), _scale(scale)
+    Entity::Entity(const fs::path& modelPath, const std::shared_ptr<TextureCache>& textureCache, bool flipTextures, const glm::vec3 position, const float rotationX, const float rotationY, const float rotationZ, const glm::vec3 scale) : _position(position), _rotationX(rotationX), _rotationY(rotationY), _rotationZ(rotationZ), _scale(scale)
     {
-        _model = std::make_shared<Model>(modelPath, flipTextures);
+        _model = std::make_shared<Model>(modelPath, textureCache, flipTextures);
     }
 
     Entity::Entity(const std::shared_ptr<Model>& model, const glm::vec3 position, const float rotationX, const float rotationY, const float rotationZ, const glm::vec3 scale) : _model(model) ,_position(position), _rotationX(rotationX), _rotationY(rotationY), _rotationZ(rotationZ), _scale(scale)
@@ -89,10 +91,63 @@ namespace Renderer3D {
         return modelMatrix;
     }
 
+    void Entity::SelectLod(const glm::mat4& projection, const glm::vec3 cameraPos, const size_t renderHeight, const float lodBias)
+    {
+        const auto lodsCount = _model->GetLodsCount();
+        if (lodsCount <= 1)
+        {
+            _lod = 0;
+            return;
+        }
+        const auto modelMatrix = GetModelMatrix();
+        const auto [center, radius] = _model->GetBoundingSphere();
+        const auto scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+        const auto worldRadius = radius * scale;
+        const auto distance = glm::length(glm::vec3(modelMatrix * glm::vec4(center, 1.0f)) - cameraPos);
+        // Camera inside of the bounds
+        if (distance <= worldRadius || worldRadius <= 0.0f)
+        {
+            _lod = 0;
+            return;
+        }
+        // Clip space w at that distance - the distance itself for perspective projection and 1 for orthographic one
+        const auto w = -projection[2][3] * distance + projection[3][3];
+        const auto screenRadius = worldRadius * projection[1][1] * static_cast<float>(renderHeight) / (2.0f * w);
+        // Every LOD has half of the triangles of the previous one, so it's used once the radius on screen halves
+        const auto idealLod = std::log2(FULL_DETAIL_SCREEN_RADIUS / screenRadius) + 1.0f + lodBias;
+        const auto lod = static_cast<float>(_lod);
+        if (idealLod >= lod - LOD_HYSTERESIS && idealLod < lod + 1.0f + LOD_HYSTERESIS)
+        {
+            return;
+        }
+        _lod = static_cast<size_t>(std::clamp(std::floor(idealLod), 0.0f, static_cast<float>(lodsCount - 1)));
+    }
+
+    size_t Entity::GetLod() const
+    {
+        return _lod;
+    }
+
     void Entity::Draw(const std::shared_ptr<Shader>& shader) const
     {
         shader->SetUniform("model", GetModelMatrix());
-        _model->Draw(shader);
+        _model->Draw(shader, _lod);
+    }
+
+    void Entity::DrawDepth(const std::shared_ptr<Shader>& shader) const
+    {
+        shader->SetUniform("model", GetModelMatrix());
+        _model->DrawDepth(shader, _lod);
+    }
+
+    void Entity::CollectVisibilityDraws(std::vector<VisibilityDraw>& draws) const
+    {
+        _model->CollectVisibilityDraws(GetModelMatrix(), draws, _lod);
+    }
+
+    void Entity::RequestTextures(TextureStreamer& textureStreamer) const
+    {
+        _model->RequestTextures(GetModelMatrix(), textureStreamer);
     }
 
     void Entity::SetSpotlightUniforms(const std::shared_ptr<Shader>& shader) const
@@ -110,4 +165,9 @@ namespace Renderer3D {
             _spotLight->UpdateDirection(direction);
         }
     }
+
+    std::shared_ptr<SpotLightSource> Entity::GetSpotLight() const
+    {
+        return _spotLight;
+    }
 } // Renderer3D
\ No newline at end of file
@@ -17,7 +17,7 @@ namespace Renderer3D {
 
     class Entity {
     public:
-        explicit Entity(const fs::path& modelPath, bool flipTextures = false, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), float rotationX = 0.0f, float rotationY = 0.0f, float rotationZ = 0.0f, glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f));
+        Entity(const fs::path& modelPath, const std::shared_ptr<TextureCache>& textureCache, bool flipTextures = false, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), float rotationX = 0.0f, float rotationY = 0.0f, float rotationZ = 0.0f, glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f));
         explicit Entity(const std::shared_ptr<Model>& model, glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), float rotationX = 0.0f, float rotationY = 0.0f, float rotationZ = 0.0f, glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f));
         [[nodiscard]] glm::vec3 GetPosition() const;
         void UpdatePosition(glm::vec3 position);
@@ -31,9 +31,16 @@ namespace Renderer3D {
         void UpdateScale(glm::vec3 scale);
         void CreateSpotLight(SpotLightsFactory& spotLightsFactory, glm::vec3 position, glm::vec3 direction, float cutOff, float outerCutOff);
         [[nodiscard]] glm::mat4 GetModelMatrix() const;
+        // Picks LOD from the size of the model bounds on screen, positive `lodBias` picks coarser LODs
+        void SelectLod(const glm::mat4& projection, glm::vec3 cameraPos, size_t renderHeight, float lodBias);
+        [[nodiscard]] size_t GetLod() const;
         void Draw(const std::shared_ptr<Shader>& shader) const;
+        void DrawDepth(const std::shared_ptr<Shader>& shader) const;
+        void CollectVisibilityDraws(std::vector<VisibilityDraw>& draws) const;
+        void RequestTextures(TextureStreamer& textureStreamer) const;
         void SetSpotlightUniforms(const std::shared_ptr<Shader>& shader) const;
         void UpdateSpotlightDirection(glm::vec3 direction) const;
+        [[nodiscard]] std::shared_ptr<SpotLightSource> GetSpotLight() const;
     private:
         std::shared_ptr<Model> _model;
         glm::vec3 _position;
@@ -43,6 +50,15 @@ namespace Renderer3D {
         glm::vec3 _scale;
         std::shared_ptr<SpotLightSource> _spotLight = nullptr;
         glm::vec4 _spotLightModelPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        size_t _lod = 0;
+
+        // Consts
+        // Radius on screen in pixels below which the first simplified LOD is used, every LOD after it is used
+        // at half of the radius of the previous one
+        static constexpr float FULL_DETAIL_SCREEN_RADIUS = 256.0f;
+        // In LODs - selected LOD changes only once the ideal one is this far outside of it, so entities hovering
+        // around a threshold don't pop back and forth
+        static constexpr float LOD_HYSTERESIS = 0.25f;
     };
 
 } // Renderer3D
@@ -2,12 +2,15 @@
 // Created by Kacper Trzciński on 18.01.2025.
 //
 
+#include <iterator>
 
 #include "floor.h"
 
 namespace Renderer3D {
-    Floor::Floor()
+    Floor::Floor(TextureCache& textureCache)
     {
+        _texture = textureCache.Acquire(TEXTURE_PATH, TextureType::DIFFUSE);
+
         // Setup buffers
         glGenVertexArrays(1, &_vaoId);
         glGenBuffers(1, &_vboId);
@@ -24,17 +27,34 @@ namespace Renderer3D {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(FLOOR_INDICES), FLOOR_INDICES, GL_STATIC_DRAW);
 
         // Position attribute
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), nullptr);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, FLOOR_VERTEX_STRIDE * sizeof(float), nullptr);
         glEnableVertexAttribArray(0);
 
         // Normal attribute
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, FLOOR_VERTEX_STRIDE * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
         glEnableVertexAttribArray(1);
 
         // Texture coordinate attribute
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), reinterpret_cast<void*>(6 * sizeof(float)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, FLOOR_VERTEX_STRIDE * sizeof(float), reinterpret_cast<void*>(6 * sizeof(float)));
         glEnableVertexAttribArray(2);
 
+        // Depth prepass stream, it shares indices with main one
+        float positions[std::size(FLOOR_VERTICES) / FLOOR_VERTEX_STRIDE * 3];
+        for (size_t i = 0; i < std::size(FLOOR_VERTICES) / FLOOR_VERTEX_STRIDE; i++)
+        {
+            positions[i * 3] = FLOOR_VERTICES[i * FLOOR_VERTEX_STRIDE];
+            positions[i * 3 + 1] = FLOOR_VERTICES[i * FLOOR_VERTEX_STRIDE + 1];
+            positions[i * 3 + 2] = FLOOR_VERTICES[i * FLOOR_VERTEX_STRIDE + 2];
+        }
+        glGenVertexArrays(1, &_depthVaoId);
+        glGenBuffers(1, &_positionsVboId);
+        glBindVertexArray(_depthVaoId);
+        glBindBuffer(GL_ARRAY_BUFFER, _positionsVboId);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _eboId);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+        glEnableVertexAttribArray(0);
+
         // Cleanup
         glBindVertexArray(0);
     }
@@ -45,6 +65,10 @@ namespace Renderer3D {
         _vaoId = other._vaoId;
         _vboId = other._vboId;
         _eboId = other._eboId;
+        _depthVaoId = other._depthVaoId;
+        _positionsVboId = other._positionsVboId;
+        _geometryToken = std::move(other._geometryToken);
+        _texture = std::move(other._texture);
         _model = other._model;
     }
 
@@ -66,20 +90,56 @@ namespace Renderer3D {
         {
             glDeleteBuffers(1, &_eboId);
         }
+        if (_depthVaoId != 0)
+        {
+            glDeleteVertexArrays(1, &_depthVaoId);
+        }
+        if (_positionsVboId != 0)
+        {
+            glDeleteBuffers(1, &_positionsVboId);
+        }
     }
 
     void Floor::Draw(const std::shared_ptr<Shader>& shader) const
     {
-        // Setup model matrix
+        // Setup model matrix, floor vertices are not quantized
         shader->SetUniform("model", _model);
+        shader->SetUniform("positionOffset", glm::vec3(0.0f));
+        shader->SetUniform("positionScale", glm::vec3(1.0f));
         // Setup texture
-        shader->SetUniform("material.diffuse0", 0);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, _texture.GetId());
+        BindMaterial(shader);
         // Render
         glBindVertexArray(_vaoId);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
         // Cleanup
         glBindVertexArray(0);
     }
+
+    void Floor::DrawDepth(const std::shared_ptr<Shader>& shader) const
+    {
+        shader->SetUniform("model", _model);
+        shader->SetUniform("positionOffset", glm::vec3(0.0f));
+        shader->SetUniform("positionScale", glm::vec3(1.0f));
+        glBindVertexArray(_depthVaoId);
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        glBindVertexArray(0);
+    }
+
+    void Floor::BindMaterial(const std::shared_ptr<Shader>& shader) const
+    {
+        shader->SetUniform("material.diffuse0", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, _texture->GetId());
+    }
+
+    MeshGeometry Floor::GetGeometry() const
+    {
+        return {_vboId, _eboId, _depthVaoId, std::size(FLOOR_VERTICES) / FLOOR_VERTEX_STRIDE, std::size(FLOOR_INDICES), VertexFormat::FULL, GL_UNSIGNED_INT,
+            glm::vec3(0.0f), glm::vec3(1.0f), 0, std::size(FLOOR_INDICES), _geometryToken};
+    }
+
+    glm::mat4 Floor::GetModelMatrix() const
+    {
+        return _model;
+    }
 } // Renderer3D
\ No newline at end of file
@@ -8,27 +8,40 @@
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "mesh.h"
 #include "shader.h"
 #include "texture.h"
+#include "texture_cache.h"
 
 namespace Renderer3D {
 
 class Floor {
 public:
-    Floor();
+    explicit Floor(TextureCache& textureCache);
     Floor(Floor&& other) noexcept;
     ~Floor();
     void Draw(const std::shared_ptr<Shader>& shader) const;
+    void DrawDepth(const std::shared_ptr<Shader>& shader) const;
+    void BindMaterial(const std::shared_ptr<Shader>& shader) const;
+    [[nodiscard]] MeshGeometry GetGeometry() const;
+    [[nodiscard]] glm::mat4 GetModelMatrix() const;
 private:
     GLuint _vaoId = 0;
     GLuint _vboId = 0;
     GLuint _eboId = 0;
+    // Position only stream for depth prepass
+    GLuint _depthVaoId = 0;
+    GLuint _positionsVboId = 0;
+    std::shared_ptr<const GeometryToken> _geometryToken = std::make_shared<const GeometryToken>();
     bool _isMoved = false;
-    Texture _texture = Texture("../assets/textures/grass.jpg", TextureType::DIFFUSE);
+    std::shared_ptr<Texture> _texture = nullptr;
     glm::mat4 _model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.01f, 0.0f)), glm::vec3(Floor::SCALE_FACTOR * 1.0f, 1.0f, Floor::SCALE_FACTOR * 1.0f));;
 
     // Consts
     static constexpr unsigned int SCALE_FACTOR = 1000;
+    static constexpr auto TEXTURE_PATH = "../assets/textures/grass.jpg";
+    // Same layout as Vertex
+    static constexpr size_t FLOOR_VERTEX_STRIDE = 8;
     static constexpr float FLOOR_VERTICES[] = {
         // positions            // normals           // texture coords
         -1.0f, 0.0f, -1.0f,     0.0f, 1.0f, 0.0f,    0.0f, 0.0f,
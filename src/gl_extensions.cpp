@@ -0,0 +1,24 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <glad/glad.h>
+
+#include "gl_extensions.h"
+
+namespace Renderer3D {
+    bool isGlExtensionSupported(const std::string_view name)
+    {
+        GLint extensionsCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionsCount);
+        for (GLint i = 0; i < extensionsCount; i++)
+        {
+            const auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (extension != nullptr && std::string_view(extension) == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+} // Renderer3D
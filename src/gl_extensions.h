@@ -0,0 +1,17 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <string_view>
+
+namespace Renderer3D {
+
+    // Must be called on the thread owning GL context. Glad is generated without extensions, so they are queried by name.
+    bool isGlExtensionSupported(std::string_view name);
+
+} // Renderer3D
+
+#endif //GL_EXTENSIONS_H
@@ -0,0 +1,202 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <spdlog/spdlog.h>
+
+#include "gl_extensions.h"
+#include "gpu_profiler.h"
+
+namespace Renderer3D {
+    GpuProfiler::GpuProfiler()
+    {
+        _hasPipelineStatistics = IsPipelineStatisticsSupported();
+        if (!_hasPipelineStatistics)
+        {
+            spdlog::info("Pipeline statistics queries are not supported, profiler falls back to samples passed");
+        }
+    }
+
+    void GpuProfiler::BeginPass(const std::string_view name)
+    {
+        if (_currentPass != -1)
+        {
+            spdlog::error("Profiled pass {} started inside of pass {}!", name, _passes[_currentPass].Statistics.Name);
+            return;
+        }
+        auto it = std::ranges::find_if(_passes, [name](const PassQueries& pass) { return pass.Statistics.Name == name; });
+        if (it == _passes.end())
+        {
+            PassQueries pass;
+            pass.Statistics.Name = name;
+            for (auto& queries : pass.Queries)
+            {
+                glGenQueries(static_cast<GLsizei>(GetQueryTypesCount()), queries);
+            }
+            _passes.push_back(pass);
+            it = _passes.end() - 1;
+        }
+        const auto passIndex = static_cast<size_t>(it - _passes.begin());
+        if (std::ranges::find(_frameOrder, passIndex) != _frameOrder.end())
+        {
+            spdlog::error("Profiled pass {} started twice in one frame!", name);
+            return;
+        }
+        _frameOrder.push_back(passIndex);
+        _currentPass = static_cast<int>(passIndex);
+        for (size_t type = 0; type < GetQueryTypesCount(); type++)
+        {
+            glBeginQuery(QUERY_TARGETS[type], it->Queries[_frameIndex][type]);
+        }
+    }
+
+    void GpuProfiler::EndPass()
+    {
+        if (_currentPass == -1)
+        {
+            return;
+        }
+        for (size_t type = 0; type < GetQueryTypesCount(); type++)
+        {
+            glEndQuery(QUERY_TARGETS[type]);
+        }
+        _passes[_currentPass].IsIssued[_frameIndex] = true;
+        _currentPass = -1;
+    }
+
+    void GpuProfiler::EndFrame()
+    {
+        if (_currentPass != -1)
+        {
+            spdlog::error("Profiled pass {} was not ended!", _passes[_currentPass].Statistics.Name);
+            EndPass();
+        }
+        // Slot which will be reused next holds the oldest queries
+        _frameIndex = (_frameIndex + 1) % QUERY_FRAMES;
+        for (auto& pass : _passes)
+        {
+            if (pass.IsIssued[_frameIndex])
+            {
+                ReadResults(pass, _frameIndex);
+            }
+        }
+        _lastFrameStatistics.clear();
+        for (const auto passIndex : _frameOrder)
+        {
+            _lastFrameStatistics.push_back(_passes[passIndex].Statistics);
+        }
+        _frameOrder.clear();
+    }
+
+    bool GpuProfiler::HasPipelineStatistics() const
+    {
+        return _hasPipelineStatistics;
+    }
+
+    const std::vector<PassStatistics>& GpuProfiler::GetPassStatistics() const
+    {
+        return _lastFrameStatistics;
+    }
+
+    const PassStatistics* GpuProfiler::FindPass(const std::string_view name) const
+    {
+        const auto it = std::ranges::find_if(_lastFrameStatistics, [name](const PassStatistics& pass) { return pass.Name == name; });
+        return it == _lastFrameStatistics.end() ? nullptr : &*it;
+    }
+
+    bool GpuProfiler::ExportBenchmark(const std::filesystem::path& path, const std::string_view renderingPath, const size_t renderWidth, const size_t renderHeight, const float gpuFrameTime) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            spdlog::error("Failed to open benchmark file {}", path.string());
+            return false;
+        }
+        // Statistics missing on current hardware are exported as null, so results from different machines keep the same shape
+        const auto statistic = [this](const GLuint64 value)
+        {
+            return _hasPipelineStatistics ? std::to_string(value) : std::string("null");
+        };
+        // Pass names are fixed identifiers without characters that would need escaping
+        file << "{\n";
+        file << std::format("  \"renderingPath\": \"{}\",\n", renderingPath);
+        file << std::format("  \"renderWidth\": {},\n", renderWidth);
+        file << std::format("  \"renderHeight\": {},\n", renderHeight);
+        file << std::format("  \"gpuFrameTimeMs\": {:.3f},\n", gpuFrameTime);
+        file << std::format("  \"pipelineStatistics\": {},\n", _hasPipelineStatistics);
+        file << "  \"passes\": [\n";
+        for (size_t i = 0; i < _lastFrameStatistics.size(); i++)
+        {
+            const auto& pass = _lastFrameStatistics[i];
+            file << "    {\n";
+            file << std::format("      \"name\": \"{}\",\n", pass.Name);
+            file << std::format("      \"gpuTimeMs\": {:.3f},\n", pass.GpuTime);
+            file << std::format("      \"samplesPassed\": {},\n", pass.SamplesPassed);
+            file << std::format("      \"verticesSubmitted\": {},\n", statistic(pass.VerticesSubmitted));
+            file << std::format("      \"primitivesSubmitted\": {},\n", statistic(pass.PrimitivesSubmitted));
+            file << std::format("      \"fragmentShaderInvocations\": {}\n", statistic(pass.FragmentShaderInvocations));
+            file << (i + 1 < _lastFrameStatistics.size() ? "    },\n" : "    }\n");
+        }
+        file << "  ]\n";
+        file << "}\n";
+        spdlog::info("Benchmark exported to {}", path.string());
+        return true;
+    }
+
+    GpuProfiler::~GpuProfiler()
+    {
+        for (auto& pass : _passes)
+        {
+            for (auto& queries : pass.Queries)
+            {
+                glDeleteQueries(static_cast<GLsizei>(GetQueryTypesCount()), queries);
+            }
+        }
+    }
+
+    size_t GpuProfiler::GetQueryTypesCount() const
+    {
+        return _hasPipelineStatistics ? QUERY_TYPES : BASIC_QUERY_TYPES;
+    }
+
+    void GpuProfiler::ReadResults(PassQueries& pass, const size_t frameIndex) const
+    {
+        const auto typesCount = GetQueryTypesCount();
+        for (size_t type = 0; type < typesCount; type++)
+        {
+            GLint isAvailable = 0;
+            glGetQueryObjectiv(pass.Queries[frameIndex][type], GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+            if (!isAvailable)
+            {
+                return;
+            }
+        }
+        GLuint64 results[QUERY_TYPES] = {};
+        for (size_t type = 0; type < typesCount; type++)
+        {
+            glGetQueryObjectui64v(pass.Queries[frameIndex][type], GL_QUERY_RESULT, &results[type]);
+        }
+        auto& statistics = pass.Statistics;
+        // Nanoseconds to milliseconds
+        const auto gpuTime = static_cast<float>(results[0]) / 1000000.0f;
+        statistics.GpuTime = statistics.GpuTime == 0.0f ? gpuTime : statistics.GpuTime + (gpuTime - statistics.GpuTime) * TIME_SMOOTHING;
+        statistics.SamplesPassed = results[1];
+        statistics.VerticesSubmitted = results[2];
+        statistics.PrimitivesSubmitted = results[3];
+        statistics.FragmentShaderInvocations = results[4];
+        pass.IsIssued[frameIndex] = false;
+    }
+
+    bool GpuProfiler::IsPipelineStatisticsSupported()
+    {
+        // Core since 4.6, the window asks only for 3.3, so the extension is checked as well
+        if (GLAD_GL_VERSION_4_6)
+        {
+            return true;
+        }
+        return isGlExtensionSupported("GL_ARB_pipeline_statistics_query");
+    }
+} // Renderer3D
@@ -0,0 +1,85 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glad/glad.h>
+
+namespace Renderer3D {
+
+    struct PassStatistics
+    {
+        std::string Name;
+        // In milliseconds, smoothed over frames
+        float GpuTime = 0.0f;
+        GLuint64 SamplesPassed = 0;
+        // Only filled when pipeline statistics queries are supported
+        GLuint64 VerticesSubmitted = 0;
+        GLuint64 PrimitivesSubmitted = 0;
+        GLuint64 FragmentShaderInvocations = 0;
+    };
+
+    // Measures GPU time, samples passed and (where GL_ARB_pipeline_statistics_query is available) vertex, primitive
+    // and fragment shader invocation counts of every pass between BeginPass and EndPass. Passes must not be nested.
+    class GpuProfiler {
+    public:
+        GpuProfiler();
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+        void BeginPass(std::string_view name);
+        void EndPass();
+        void EndFrame();
+        [[nodiscard]] bool HasPipelineStatistics() const;
+        // Passes executed in the last frame, in execution order
+        [[nodiscard]] const std::vector<PassStatistics>& GetPassStatistics() const;
+        [[nodiscard]] const PassStatistics* FindPass(std::string_view name) const;
+        bool ExportBenchmark(const std::filesystem::path& path, std::string_view renderingPath, size_t renderWidth, size_t renderHeight, float gpuFrameTime) const;
+        ~GpuProfiler();
+    private:
+        // Results are read a few frames late, so waiting for them never stalls the pipeline
+        static constexpr size_t QUERY_FRAMES = 3;
+        // Time elapsed, samples passed and three pipeline statistics
+        static constexpr size_t QUERY_TYPES = 5;
+
+        struct PassQueries
+        {
+            GLuint Queries[QUERY_FRAMES][QUERY_TYPES] = {};
+            bool IsIssued[QUERY_FRAMES] = {};
+            PassStatistics Statistics;
+        };
+
+        std::vector<PassQueries> _passes;
+        // Indices into `_passes` in order of execution in current frame
+        std::vector<size_t> _frameOrder;
+        std::vector<PassStatistics> _lastFrameStatistics;
+        int _currentPass = -1;
+        size_t _frameIndex = 0;
+        bool _hasPipelineStatistics = false;
+
+        // Helpers
+        [[nodiscard]] size_t GetQueryTypesCount() const;
+        void ReadResults(PassQueries& pass, size_t frameIndex) const;
+        static bool IsPipelineStatisticsSupported();
+
+        // Consts
+        static constexpr GLenum QUERY_TARGETS[QUERY_TYPES] = {
+            GL_TIME_ELAPSED,
+            GL_SAMPLES_PASSED,
+            GL_VERTICES_SUBMITTED,
+            GL_PRIMITIVES_SUBMITTED,
+            GL_FRAGMENT_SHADER_INVOCATIONS
+        };
+        static constexpr size_t BASIC_QUERY_TYPES = 2;
+        static constexpr float TIME_SMOOTHING = 0.1f;
+    };
+
+} // Renderer3D
+
+#endif //GPU_PROFILER_H
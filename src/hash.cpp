@@ -0,0 +1,53 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <fstream>
+#include <vector>
+
+#include "hash.h"
+
+namespace Renderer3D {
+    static constexpr uint64_t HASH_PRIME = 1099511628211ull;
+    static constexpr size_t FILE_CHUNK_SIZE = 1 << 20;
+
+    uint64_t hashBytes(const std::span<const std::byte> data, uint64_t hash)
+    {
+        for (const auto byte : data)
+        {
+            hash ^= static_cast<uint64_t>(byte);
+            hash *= HASH_PRIME;
+        }
+        return hash;
+    }
+
+    std::optional<uint64_t> hashFile(const fs::path& path)
+    {
+        const auto digest = digestFile(path);
+        if (!digest)
+        {
+            return std::nullopt;
+        }
+        return digest->Hash;
+    }
+
+    std::optional<FileDigest> digestFile(const fs::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return std::nullopt;
+        }
+        // Single sequential read in chunks, so big files don't need to fit in memory
+        std::vector<std::byte> chunk(FILE_CHUNK_SIZE);
+        FileDigest digest;
+        while (file)
+        {
+            file.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+            const auto readBytes = static_cast<size_t>(file.gcount());
+            digest.Hash = hashBytes(std::span(chunk.data(), readBytes), digest.Hash);
+            digest.Size += readBytes;
+        }
+        return digest;
+    }
+} // Renderer3D
@@ -0,0 +1,39 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace fs = std::filesystem;
+
+namespace Renderer3D {
+
+    inline constexpr uint64_t HASH_OFFSET_BASIS = 14695981039346656037ull;
+
+    // Content hash together with the size it was computed from - two files are treated as identical only when both
+    // match, as 64-bit hash alone can collide
+    struct FileDigest
+    {
+        uint64_t Hash = HASH_OFFSET_BASIS;
+        uintmax_t Size = 0;
+
+        auto operator<=>(const FileDigest&) const = default;
+    };
+
+    // 64-bit FNV-1a, `hash` continues hashing of previous data
+    uint64_t hashBytes(std::span<const std::byte> data, uint64_t hash = HASH_OFFSET_BASIS);
+    // Hash of the whole file content, empty when file can't be read
+    std::optional<uint64_t> hashFile(const fs::path& path);
+    // Hash and size of the whole file content, empty when file can't be read
+    std::optional<FileDigest> digestFile(const fs::path& path);
+
+} // Renderer3D
+
+#endif //HASH_H
@@ -0,0 +1,234 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <numeric>
+
+#include "light_tree.h"
+
+namespace Renderer3D {
+    bool isSphereVisible(const TilePlanes& planes, const glm::vec3& center, const float radius)
+    {
+        // Planes are not normalized, so radius is scaled by length of the normal
+        for (const auto& plane : planes.Planes)
+        {
+            const auto normal = glm::vec3(plane);
+            if (glm::dot(normal, center) + plane.w < -radius * glm::length(normal))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LightTree::Build(const std::vector<PointLightSource>& lights, const float influenceThreshold)
+    {
+        _influenceThreshold = influenceThreshold;
+        _nodes.clear();
+        _leafNodes.assign(lights.size(), -1);
+        if (lights.empty())
+        {
+            return;
+        }
+        // Binary tree with one light per leaf always has exactly 2n - 1 nodes
+        _nodes.reserve(2 * lights.size() - 1);
+        std::vector<size_t> indices(lights.size());
+        std::iota(indices.begin(), indices.end(), 0);
+        BuildRecursive(lights, indices, 0, indices.size());
+    }
+
+    bool LightTree::IsEmpty() const
+    {
+        return _nodes.empty();
+    }
+
+    const std::vector<LightTreeNode>& LightTree::GetNodes() const
+    {
+        return _nodes;
+    }
+
+    int LightTree::GetLeafNode(const size_t lightIndex) const
+    {
+        if (lightIndex >= _leafNodes.size())
+        {
+            return -1;
+        }
+        return _leafNodes[lightIndex];
+    }
+
+    void LightTree::SelectCut(const TilePlanes& tile, const glm::vec3& cameraPos, const float errorBound, const size_t maxLights, std::vector<unsigned int>& cut) const
+    {
+        cut.clear();
+        if (_nodes.empty() || maxLights == 0 || !IsVisible(_nodes[0], tile))
+        {
+            return;
+        }
+
+        // Max heap ordered by error - we always refine the node which approximates its lights the worst.
+        // Leaves have no error, so once the top of the heap is below the bound the whole cut is.
+        std::vector<std::pair<float, int>> heap;
+        heap.emplace_back(CalculateError(_nodes[0], cameraPos), 0);
+        while (!heap.empty())
+        {
+            const auto [error, nodeIndex] = heap.front();
+            // Refining replaces one node with up to two, so stop if that could exceed the budget
+            if (error <= errorBound || heap.size() + 1 > maxLights)
+            {
+                break;
+            }
+            std::pop_heap(heap.begin(), heap.end());
+            heap.pop_back();
+            const auto& node = _nodes[nodeIndex];
+            for (const auto child : {node.Left, node.Right})
+            {
+                if (IsVisible(_nodes[child], tile))
+                {
+                    heap.emplace_back(CalculateError(_nodes[child], cameraPos), child);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        }
+
+        for (const auto& [_, nodeIndex] : heap)
+        {
+            cut.push_back(static_cast<unsigned int>(nodeIndex));
+        }
+    }
+
+    TilePlanes LightTree::CalculateTilePlanes(const glm::mat4& viewProjection, const glm::vec2 ndcMin, const glm::vec2 ndcMax)
+    {
+        // Planes are extracted directly from clip space inequalities (e.g. x >= ndcMin.x * w),
+        // so they end up in world space and work for both perspective and orthographic projection
+        const auto row = [&viewProjection](const int i)
+        {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+        const auto rowX = row(0);
+        const auto rowY = row(1);
+        const auto rowZ = row(2);
+        const auto rowW = row(3);
+        TilePlanes tile{};
+        tile.Planes[0] = rowX - ndcMin.x * rowW;
+        tile.Planes[1] = ndcMax.x * rowW - rowX;
+        tile.Planes[2] = rowY - ndcMin.y * rowW;
+        tile.Planes[3] = ndcMax.y * rowW - rowY;
+        tile.Planes[4] = rowW + rowZ;
+        tile.Planes[5] = rowW - rowZ;
+        return tile;
+    }
+
+    int LightTree::BuildRecursive(const std::vector<PointLightSource>& lights, std::vector<size_t>& indices, const size_t begin, const size_t end) // NOLINT(*-no-recursion)
+    {
+        if (end - begin == 1)
+        {
+            return CreateLeaf(lights, indices[begin]);
+        }
+
+        // Split along the longest axis of light positions
+        auto boundsMin = lights[indices[begin]].GetPosition();
+        auto boundsMax = boundsMin;
+        for (size_t i = begin + 1; i < end; i++)
+        {
+            boundsMin = glm::min(boundsMin, lights[indices[i]].GetPosition());
+            boundsMax = glm::max(boundsMax, lights[indices[i]].GetPosition());
+        }
+        const auto extent = boundsMax - boundsMin;
+        int axis = 0;
+        if (extent.y > extent[axis])
+        {
+            axis = 1;
+        }
+        if (extent.z > extent[axis])
+        {
+            axis = 2;
+        }
+        const auto mid = begin + (end - begin) / 2;
+        std::nth_element(indices.begin() + static_cast<long>(begin), indices.begin() + static_cast<long>(mid), indices.begin() + static_cast<long>(end), [&lights, axis](const size_t a, const size_t b)
+        {
+            return lights[a].GetPosition()[axis] < lights[b].GetPosition()[axis];
+        });
+
+        // Reserve node before children so the root always ends up at index 0
+        const auto nodeIndex = static_cast<int>(_nodes.size());
+        _nodes.emplace_back();
+        const auto left = BuildRecursive(lights, indices, begin, mid);
+        const auto right = BuildRecursive(lights, indices, mid, end);
+
+        const auto& leftNode = _nodes[left];
+        const auto& rightNode = _nodes[right];
+        LightTreeNode node;
+        node.Left = left;
+        node.Right = right;
+        node.BoundsMin = glm::min(leftNode.BoundsMin, rightNode.BoundsMin);
+        node.BoundsMax = glm::max(leftNode.BoundsMax, rightNode.BoundsMax);
+        node.Intensity = leftNode.Intensity + rightNode.Intensity;
+        node.Color = leftNode.Color + rightNode.Color;
+        // Representative light is placed at intensity weighted centroid of its children, black lights weigh equally
+        const auto leftWeight = node.Intensity > 0.0f ? leftNode.Intensity / node.Intensity : 0.5f;
+        const auto rightWeight = node.Intensity > 0.0f ? rightNode.Intensity / node.Intensity : 0.5f;
+        node.Position = leftNode.Position * leftWeight + rightNode.Position * rightWeight;
+        node.Linear = leftNode.Linear * leftWeight + rightNode.Linear * rightWeight;
+        node.Quadratic = leftNode.Quadratic * leftWeight + rightNode.Quadratic * rightWeight;
+        node.Radius = PointLightSource::CalculateRadius(node.Color, node.Linear, node.Quadratic, _influenceThreshold);
+        // Influence must also contain representative light, as it is what gets shaded when node is in the cut
+        node.InfluenceMin = glm::min(glm::min(leftNode.InfluenceMin, rightNode.InfluenceMin), node.Position - glm::vec3(node.Radius));
+        node.InfluenceMax = glm::max(glm::max(leftNode.InfluenceMax, rightNode.InfluenceMax), node.Position + glm::vec3(node.Radius));
+        _nodes[nodeIndex] = node;
+        return nodeIndex;
+    }
+
+    int LightTree::CreateLeaf(const std::vector<PointLightSource>& lights, const size_t lightIndex)
+    {
+        const auto& light = lights[lightIndex];
+        LightTreeNode node;
+        node.BoundsMin = light.GetPosition();
+        node.BoundsMax = light.GetPosition();
+        node.InfluenceMin = light.GetPosition() - glm::vec3(light.GetRadius());
+        node.InfluenceMax = light.GetPosition() + glm::vec3(light.GetRadius());
+        node.Position = light.GetPosition();
+        node.Color = light.GetColor();
+        node.Linear = light.GetLinear();
+        node.Quadratic = light.GetQuadratic();
+        node.Radius = light.GetRadius();
+        node.Intensity = PointLightSource::CalculateMaxBrightness(light.GetColor());
+        node.LightIndex = static_cast<int>(lightIndex);
+        const auto nodeIndex = static_cast<int>(_nodes.size());
+        _nodes.push_back(node);
+        _leafNodes[lightIndex] = nodeIndex;
+        return nodeIndex;
+    }
+
+    float LightTree::CalculateError(const LightTreeNode& node, const glm::vec3& cameraPos)
+    {
+        // Leaves are exact
+        if (node.Left == -1)
+        {
+            return 0.0f;
+        }
+        // Clusters that are small compared to their distance from the viewer (or dim) are safe to merge
+        constexpr float MIN_DISTANCE = 0.001f;
+        const auto extent = glm::length(node.BoundsMax - node.BoundsMin);
+        const auto closestPoint = glm::clamp(cameraPos, node.BoundsMin, node.BoundsMax);
+        const auto distance = std::max(glm::length(cameraPos - closestPoint), MIN_DISTANCE);
+        return node.Intensity * extent / distance;
+    }
+
+    bool LightTree::IsVisible(const LightTreeNode& node, const TilePlanes& tile)
+    {
+        for (const auto& plane : tile.Planes)
+        {
+            // Test the corner of influence bounds that lies furthest along plane normal
+            const auto corner = glm::vec3(
+                plane.x > 0.0f ? node.InfluenceMax.x : node.InfluenceMin.x,
+                plane.y > 0.0f ? node.InfluenceMax.y : node.InfluenceMin.y,
+                plane.z > 0.0f ? node.InfluenceMax.z : node.InfluenceMin.z
+            );
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+} // Renderer3D
@@ -0,0 +1,66 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef LIGHT_TREE_H
+#define LIGHT_TREE_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "point_light_source.h"
+
+namespace Renderer3D {
+
+    struct LightTreeNode
+    {
+        // Bounds of light positions inside this node
+        glm::vec3 BoundsMin;
+        glm::vec3 BoundsMax;
+        // Bounds of the area lit by lights inside this node (positions extended by radius)
+        glm::vec3 InfluenceMin;
+        glm::vec3 InfluenceMax;
+        // Representative light - for leaves it is just the light itself
+        glm::vec3 Position;
+        glm::vec3 Color;
+        float Linear;
+        float Quadratic;
+        float Radius;
+        float Intensity;
+        // -1 for leaves
+        int Left = -1;
+        int Right = -1;
+        // -1 for internal nodes
+        int LightIndex = -1;
+    };
+
+    struct TilePlanes
+    {
+        glm::vec4 Planes[6];
+    };
+
+    bool isSphereVisible(const TilePlanes& planes, const glm::vec3& center, float radius);
+
+    class LightTree {
+    public:
+        void Build(const std::vector<PointLightSource>& lights, float influenceThreshold);
+        [[nodiscard]] bool IsEmpty() const;
+        [[nodiscard]] const std::vector<LightTreeNode>& GetNodes() const;
+        [[nodiscard]] int GetLeafNode(size_t lightIndex) const;
+        void SelectCut(const TilePlanes& tile, const glm::vec3& cameraPos, float errorBound, size_t maxLights, std::vector<unsigned int>& cut) const;
+        static TilePlanes CalculateTilePlanes(const glm::mat4& viewProjection, glm::vec2 ndcMin, glm::vec2 ndcMax);
+    private:
+        std::vector<LightTreeNode> _nodes;
+        std::vector<int> _leafNodes;
+        // Used for radius of representative lights, so it matches radius of the lights themselves
+        float _influenceThreshold = PointLightSource::DEFAULT_INFLUENCE_THRESHOLD;
+        // Helpers
+        int BuildRecursive(const std::vector<PointLightSource>& lights, std::vector<size_t>& indices, size_t begin, size_t end); // NOLINT(*-no-recursion)
+        int CreateLeaf(const std::vector<PointLightSource>& lights, size_t lightIndex);
+        static float CalculateError(const LightTreeNode& node, const glm::vec3& cameraPos);
+        static bool IsVisible(const LightTreeNode& node, const TilePlanes& tile);
+    };
+
+} // Renderer3D
+
+#endif //LIGHT_TREE_H
@@ -2,49 +2,59 @@
 // Created by Kacper Trzciński on 13.01.2025.
 //
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <format>
 
 #include "mesh.h"
+#include "vertex_quantization.h"
 
 #include "spdlog/spdlog.h"
 
 namespace Renderer3D {
-    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
-        std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures)
+    GeometryToken::GeometryToken()
     {
-        _vertices = std::move(vertices);
-        _indices = std::move(indices);
-        _textures = std::move(textures);
-
-        // Generate buffers
-        _vaoID = 0;
-        glGenVertexArrays(1, &_vaoID);
-        _vboID = 0;
-        glGenBuffers(1, &_vboID);
-        _eboID = 0;
-        glGenBuffers(1, &_eboID);
-
-        glBindVertexArray(_vaoID);
-
-        // VBO data
-        glBindBuffer(GL_ARRAY_BUFFER, _vboID);
-        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(_vertices.size() * sizeof(Vertex)), _vertices.data(), GL_STATIC_DRAW);
+        static std::atomic<size_t> nextId = 0;
+        _id = nextId++;
+    }
 
-        // EBO data
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _eboID);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(_indices.size() * sizeof(unsigned int)), _indices.data(), GL_STATIC_DRAW);
+    size_t GeometryToken::GetId() const
+    {
+        return _id;
+    }
 
-        // Vertex position
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Position)));
-        glEnableVertexAttribArray(0);
-        // Vertex normal
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Normal)));
-        glEnableVertexAttribArray(1);
-        // Vertex texture coords
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, TexCoords)));
-        glEnableVertexAttribArray(2);
+    Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+        std::vector<MeshLod> lods, std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures, const VertexFormat format, const MeshDataPolicy dataPolicy)
+    {
+        _format = format;
+        _textures = std::move(textures);
+        UploadBuffers(vertices, indices);
+        SetLods(std::move(lods));
+        // Coarser LODs would only repeat the surface
+        CalculateBounds(vertices, std::span(indices).subspan(_lods[0].FirstIndex, _lods[0].IndexCount));
+        // Otherwise data is freed together with the arguments
+        if (dataPolicy == MeshDataPolicy::RETAIN)
+        {
+            _vertices = std::move(vertices);
+            _indices = std::move(indices);
+        }
+    }
 
-        glBindVertexArray(0);
+    Mesh::Mesh(const std::span<const Vertex> vertices, const std::span<const unsigned int> indices,
+        std::vector<MeshLod> lods, std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures, const VertexFormat format, const MeshDataPolicy dataPolicy)
+    {
+        _format = format;
+        _textures = std::move(textures);
+        UploadBuffers(vertices, indices);
+        SetLods(std::move(lods));
+        // Coarser LODs would only repeat the surface
+        CalculateBounds(vertices, indices.subspan(_lods[0].FirstIndex, _lods[0].IndexCount));
+        if (dataPolicy == MeshDataPolicy::RETAIN)
+        {
+            _vertices.assign(vertices.begin(), vertices.end());
+            _indices.assign(indices.begin(), indices.end());
+        }
     }
 
     Mesh::Mesh(Mesh&& mesh) noexcept
@@ -52,9 +62,23 @@ namespace Renderer3D {
         _vaoID = mesh._vaoID;
         _vboID = mesh._vboID;
         _eboID = mesh._eboID;
+        _depthVaoID = mesh._depthVaoID;
+        _positionsVboID = mesh._positionsVboID;
+        _format = mesh._format;
+        _indexType = mesh._indexType;
+        _positionOffset = mesh._positionOffset;
+        _positionScale = mesh._positionScale;
         _vertices = std::move(mesh._vertices);
         _indices = std::move(mesh._indices);
+        _verticesCount = mesh._verticesCount;
+        _indicesCount = mesh._indicesCount;
+        _lods = std::move(mesh._lods);
+        _gpuBytes = mesh._gpuBytes;
         _textures = std::move(mesh._textures);
+        _boundsCenter = mesh._boundsCenter;
+        _boundsRadius = mesh._boundsRadius;
+        _uvDensity = mesh._uvDensity;
+        _geometryToken = std::move(mesh._geometryToken);
         mesh._isMoved = true;
     }
 
@@ -76,9 +100,17 @@ namespace Renderer3D {
         {
             glDeleteBuffers(1, &_eboID);
         }
+        if (_depthVaoID != 0)
+        {
+            glDeleteVertexArrays(1, &_depthVaoID);
+        }
+        if (_positionsVboID != 0)
+        {
+            glDeleteBuffers(1, &_positionsVboID);
+        }
     }
 
-    void Mesh::Draw(const Shader& shader) const
+    void Mesh::Draw(const Shader& shader, const size_t lod) const
     {
         // Setup textures
         shader.Activate();
@@ -98,18 +130,44 @@ namespace Renderer3D {
         }
 
         // Draw mesh
+        shader.SetUniform("positionOffset", _positionOffset);
+        shader.SetUniform("positionScale", _positionScale);
         glBindVertexArray(_vaoID);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, nullptr);
+        DrawLod(lod);
 
         // Reset state
         glActiveTexture(GL_TEXTURE0);
         glBindVertexArray(0);
     }
 
-    void Mesh::Draw(const std::shared_ptr<Shader>& shader) const
+    void Mesh::Draw(const std::shared_ptr<Shader>& shader, const size_t lod) const
     {
         // Setup textures
         shader->Activate();
+        BindMaterial(shader);
+
+        // Draw mesh
+        shader->SetUniform("positionOffset", _positionOffset);
+        shader->SetUniform("positionScale", _positionScale);
+        glBindVertexArray(_vaoID);
+        DrawLod(lod);
+
+        // Reset state
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(0);
+    }
+
+    void Mesh::DrawDepth(const std::shared_ptr<Shader>& shader, const size_t lod) const
+    {
+        shader->SetUniform("positionOffset", _positionOffset);
+        shader->SetUniform("positionScale", _positionScale);
+        glBindVertexArray(_depthVaoID);
+        DrawLod(lod);
+        glBindVertexArray(0);
+    }
+
+    void Mesh::BindMaterial(const std::shared_ptr<Shader>& shader) const
+    {
         size_t textureUnit = 0;
         for (const auto& [type, textures]: _textures)
         {
@@ -124,13 +182,243 @@ namespace Renderer3D {
                 textureUnit++;
             }
         }
+    }
 
-        // Draw mesh
+    MeshGeometry Mesh::GetGeometry(const size_t lod) const
+    {
+        const auto& meshLod = GetLod(lod);
+        return {_vboID, _eboID, _depthVaoID, _verticesCount, _indicesCount, _format, _indexType, _positionOffset, _positionScale, meshLod.FirstIndex, meshLod.IndexCount, _geometryToken};
+    }
+
+    size_t Mesh::GetLodsCount() const
+    {
+        return _lods.size();
+    }
+
+    glm::vec3 Mesh::GetBoundsCenter() const
+    {
+        return _boundsCenter;
+    }
+
+    float Mesh::GetBoundsRadius() const
+    {
+        return _boundsRadius;
+    }
+
+    std::span<const Vertex> Mesh::GetVertices() const
+    {
+        return _vertices;
+    }
+
+    std::span<const unsigned int> Mesh::GetIndices() const
+    {
+        return _indices;
+    }
+
+    MeshMemoryUsage Mesh::GetMemoryUsage() const
+    {
+        return {_vertices.capacity() * sizeof(Vertex) + _indices.capacity() * sizeof(unsigned int) + _lods.capacity() * sizeof(MeshLod), _gpuBytes};
+    }
+
+    void Mesh::RequestTextures(const glm::mat4& modelMatrix, TextureStreamer& textureStreamer) const
+    {
+        const auto scale = std::max({ glm::length(glm::vec3(modelMatrix[0])), glm::length(glm::vec3(modelMatrix[1])), glm::length(glm::vec3(modelMatrix[2])) });
+        if (scale <= 0.0f)
+        {
+            return;
+        }
+        const auto center = glm::vec3(modelMatrix * glm::vec4(_boundsCenter, 1.0f));
+        const auto uvPerPixel = textureStreamer.CalculateUvPerPixel(center, _boundsRadius * scale, _uvDensity / scale);
+        if (!uvPerPixel)
+        {
+            return;
+        }
+        for (const auto& [_, textures] : _textures)
+        {
+            for (const auto& texture : textures)
+            {
+                textureStreamer.Request(texture, *uvPerPixel);
+            }
+        }
+    }
+
+    void Mesh::UploadBuffers(const std::span<const Vertex> vertices, const std::span<const unsigned int> indices)
+    {
+        // Generate buffers
+        _vaoID = 0;
+        glGenVertexArrays(1, &_vaoID);
+        _vboID = 0;
+        glGenBuffers(1, &_vboID);
+        _eboID = 0;
+        glGenBuffers(1, &_eboID);
+        _depthVaoID = 0;
+        glGenVertexArrays(1, &_depthVaoID);
+        _positionsVboID = 0;
+        glGenBuffers(1, &_positionsVboID);
+        _verticesCount = vertices.size();
+        _indicesCount = indices.size();
+        _gpuBytes = 0;
+
+        // EBO is a part of VAO state, so it is bound to both of them
         glBindVertexArray(_vaoID);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_INT, nullptr);
+        UploadIndices(indices, vertices.size());
+        glBindVertexArray(_depthVaoID);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _eboID);
 
-        // Reset state
-        glActiveTexture(GL_TEXTURE0);
+        if (_format == VertexFormat::COMPACT)
+        {
+            UploadCompactVertices(vertices);
+        }
+        else
+        {
+            UploadFullVertices(vertices);
+        }
         glBindVertexArray(0);
     }
+
+    void Mesh::UploadFullVertices(const std::span<const Vertex> vertices)
+    {
+        glBindVertexArray(_vaoID);
+        glBindBuffer(GL_ARRAY_BUFFER, _vboID);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vertices.size_bytes()), vertices.data(), GL_STATIC_DRAW);
+        _gpuBytes += vertices.size_bytes();
+        // Vertex position
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Position)));
+        glEnableVertexAttribArray(0);
+        // Vertex normal
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, Normal)));
+        glEnableVertexAttribArray(1);
+        // Vertex texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, TexCoords)));
+        glEnableVertexAttribArray(2);
+
+        // Depth prepass stream
+        std::vector<glm::vec3> positions;
+        positions.reserve(vertices.size());
+        for (const auto& vertex : vertices)
+        {
+            positions.push_back(vertex.Position);
+        }
+        glBindVertexArray(_depthVaoID);
+        glBindBuffer(GL_ARRAY_BUFFER, _positionsVboID);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(positions.size() * sizeof(glm::vec3)), positions.data(), GL_STATIC_DRAW);
+        _gpuBytes += positions.size() * sizeof(glm::vec3);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+        glEnableVertexAttribArray(0);
+    }
+
+    void Mesh::UploadCompactVertices(const std::span<const Vertex> vertices)
+    {
+        const auto quantization = calculatePositionQuantization(vertices);
+        _positionOffset = quantization.Offset;
+        _positionScale = quantization.Scale;
+        std::vector<PackedVertex> packedVertices;
+        packedVertices.reserve(vertices.size());
+        for (const auto& vertex : vertices)
+        {
+            packedVertices.push_back(packVertex(vertex, quantization));
+        }
+
+        glBindVertexArray(_vaoID);
+        glBindBuffer(GL_ARRAY_BUFFER, _vboID);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packedVertices.size() * sizeof(PackedVertex)), packedVertices.data(), GL_STATIC_DRAW);
+        _gpuBytes += packedVertices.size() * sizeof(PackedVertex);
+        // Vertex position, dequantized in shaders
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, Position)));
+        glEnableVertexAttribArray(0);
+        // Vertex normal
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, Normal)));
+        glEnableVertexAttribArray(1);
+        // Vertex texture coords
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), reinterpret_cast<void*>(offsetof(PackedVertex, TexCoords)));
+        glEnableVertexAttribArray(2);
+
+        // Depth prepass stream - 8 bytes per vertex, padding keeps every position 4 byte aligned
+        std::vector<uint16_t> positions;
+        positions.reserve(packedVertices.size() * std::size(PackedVertex{}.Position));
+        for (const auto& vertex : packedVertices)
+        {
+            positions.insert(positions.end(), std::begin(vertex.Position), std::end(vertex.Position));
+        }
+        glBindVertexArray(_depthVaoID);
+        glBindBuffer(GL_ARRAY_BUFFER, _positionsVboID);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(positions.size() * sizeof(uint16_t)), positions.data(), GL_STATIC_DRAW);
+        _gpuBytes += positions.size() * sizeof(uint16_t);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex::Position), nullptr);
+        glEnableVertexAttribArray(0);
+    }
+
+    void Mesh::UploadIndices(const std::span<const unsigned int> indices, const size_t verticesCount)
+    {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _eboID);
+        // Halves index memory and fetch whenever all vertices can be addressed
+        if (canUseShortIndices(verticesCount))
+        {
+            const std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(shortIndices.size() * sizeof(uint16_t)), shortIndices.data(), GL_STATIC_DRAW);
+            _gpuBytes += shortIndices.size() * sizeof(uint16_t);
+            _indexType = GL_UNSIGNED_SHORT;
+            return;
+        }
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(), GL_STATIC_DRAW);
+        _gpuBytes += indices.size_bytes();
+        _indexType = GL_UNSIGNED_INT;
+    }
+
+    void Mesh::CalculateBounds(const std::span<const Vertex> vertices, const std::span<const unsigned int> indices)
+    {
+        if (vertices.empty())
+        {
+            return;
+        }
+        auto boundsMin = vertices[0].Position;
+        auto boundsMax = vertices[0].Position;
+        for (const auto& vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+        _boundsCenter = (boundsMin + boundsMax) * 0.5f;
+        for (const auto& vertex : vertices)
+        {
+            _boundsRadius = std::max(_boundsRadius, glm::length(vertex.Position - _boundsCenter));
+        }
+
+        // Ratio of texture space area to surface area, tiled textures have it above 1 per unit
+        auto surfaceArea = 0.0f;
+        auto uvArea = 0.0f;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const auto& v0 = vertices[indices[i]];
+            const auto& v1 = vertices[indices[i + 1]];
+            const auto& v2 = vertices[indices[i + 2]];
+            surfaceArea += glm::length(glm::cross(v1.Position - v0.Position, v2.Position - v0.Position)) * 0.5f;
+            const auto uv1 = v1.TexCoords - v0.TexCoords;
+            const auto uv2 = v2.TexCoords - v0.TexCoords;
+            uvArea += std::abs(uv1.x * uv2.y - uv1.y * uv2.x) * 0.5f;
+        }
+        _uvDensity = surfaceArea > 0.0f ? std::sqrt(uvArea / surfaceArea) : 0.0f;
+    }
+
+    void Mesh::SetLods(std::vector<MeshLod> lods)
+    {
+        _lods = std::move(lods);
+        std::erase_if(_lods, [this](const MeshLod& lod) { return lod.FirstIndex + lod.IndexCount > _indicesCount; });
+        if (_lods.empty())
+        {
+            _lods.push_back({0, _indicesCount, 0.0f});
+        }
+    }
+
+    const MeshLod& Mesh::GetLod(const size_t lod) const
+    {
+        return _lods[std::min(lod, _lods.size() - 1)];
+    }
+
+    void Mesh::DrawLod(const size_t lod) const
+    {
+        const auto& meshLod = GetLod(lod);
+        const auto indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(meshLod.IndexCount), _indexType, reinterpret_cast<void*>(meshLod.FirstIndex * indexSize));
+    }
 } // Renderer3D
\ No newline at end of file
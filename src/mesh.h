@@ -5,10 +5,17 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
 #include <glm/glm.hpp>
 
+#include "hash.h"
 #include "shader.h"
 #include "texture.h"
+#include "texture_streamer.h"
 
 namespace Renderer3D {
 
@@ -19,22 +26,158 @@ namespace Renderer3D {
         glm::vec2 TexCoords;
     };
 
+    // Compact vertex, decoded by the vertex fetch hardware except for positions, which are dequantized in shaders
+    // as `positionOffset + position * positionScale`
+    struct PackedVertex
+    {
+        // 16-bit unsigned normalized, relative to the mesh bounds - last component is padding
+        uint16_t Position[4];
+        // Signed normalized GL_INT_2_10_10_10_REV
+        uint32_t Normal;
+        // Half floats
+        uint16_t TexCoords[2];
+    };
+
+    enum class VertexFormat
+    {
+        // Vertex as is, 32 bytes
+        FULL,
+        // PackedVertex, 16 bytes
+        COMPACT
+    };
+
+    // What happens to CPU copies of vertices and indices once they are uploaded - drawing needs only GL buffers,
+    // bounds and counts, so copies are kept only for CPU side algorithms which ask for them
+    enum class MeshDataPolicy
+    {
+        RELEASE,
+        RETAIN
+    };
+
+    struct MeshMemoryUsage
+    {
+        size_t CpuBytes = 0;
+        size_t GpuBytes = 0;
+    };
+
+    // Texture of a mesh material, path is relative to the model directory
+    struct MaterialTextureReference
+    {
+        TextureType Type;
+        std::string Path;
+        // File content computed on a loading worker, so the texture cache doesn't read the file on the GL thread
+        std::optional<FileDigest> Content;
+    };
+
+    // Range of mesh indices drawing one level of detail, LOD 0 is the full mesh
+    struct MeshLod
+    {
+        size_t FirstIndex;
+        size_t IndexCount;
+        // Largest distance, in model space units, by which the surface moved while simplifying
+        float Error;
+    };
+
+    // CPU side result of importing a mesh, ready to be uploaded to GL buffers as is
+    struct MeshData
+    {
+        std::vector<Vertex> Vertices;
+        // Indices of all LODs, one after another
+        std::vector<unsigned int> Indices;
+        // Empty means a single LOD covering all indices
+        std::vector<MeshLod> Lods;
+        std::vector<MaterialTextureReference> Textures;
+    };
+
+    // Kept next to GL buffers of a geometry. Unlike buffer names, ids are never reused and weak references expire
+    // once the buffers are deleted, so anything caching geometry can tell when its entries become stale.
+    class GeometryToken {
+    public:
+        GeometryToken();
+        [[nodiscard]] size_t GetId() const;
+    private:
+        size_t _id;
+    };
+
+    // Raw buffers of a mesh, vertices are laid out according to `Format` and indices according to `IndexType`
+    struct MeshGeometry
+    {
+        GLuint VboID;
+        GLuint EboID;
+        GLuint DepthVaoID;
+        size_t VertexCount;
+        // All indices in the buffer
+        size_t IndexCount;
+        VertexFormat Format = VertexFormat::FULL;
+        GLenum IndexType = GL_UNSIGNED_INT;
+        // Dequantization of positions, identity for full vertices
+        glm::vec3 PositionOffset = glm::vec3(0.0f);
+        glm::vec3 PositionScale = glm::vec3(1.0f);
+        // Indices of the LOD to draw
+        size_t LodFirstIndex = 0;
+        size_t LodIndexCount = 0;
+        std::weak_ptr<const GeometryToken> Token;
+    };
+
     class Mesh {
     public:
-        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures);
+        Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<MeshLod> lods, std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures, VertexFormat format, MeshDataPolicy dataPolicy);
+        // Uploads vertices and indices straight from given memory, e.g. a mapped cache file
+        Mesh(std::span<const Vertex> vertices, std::span<const unsigned int> indices, std::vector<MeshLod> lods, std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures, VertexFormat format, MeshDataPolicy dataPolicy);
         Mesh(Mesh&& mesh) noexcept;
         ~Mesh();
-        void Draw(const Shader& shader) const;
-        void Draw(const std::shared_ptr<Shader>& shader) const;
+        // LODs past the coarsest one draw the coarsest one
+        void Draw(const Shader& shader, size_t lod = 0) const;
+        void Draw(const std::shared_ptr<Shader>& shader, size_t lod = 0) const;
+        void DrawDepth(const std::shared_ptr<Shader>& shader, size_t lod = 0) const;
+        void BindMaterial(const std::shared_ptr<Shader>& shader) const;
+        [[nodiscard]] MeshGeometry GetGeometry(size_t lod = 0) const;
+        [[nodiscard]] size_t GetLodsCount() const;
+        [[nodiscard]] glm::vec3 GetBoundsCenter() const;
+        [[nodiscard]] float GetBoundsRadius() const;
+        // Empty unless the mesh was created with MeshDataPolicy::RETAIN, indices of all LODs are one after another
+        [[nodiscard]] std::span<const Vertex> GetVertices() const;
+        [[nodiscard]] std::span<const unsigned int> GetIndices() const;
+        // Textures are shared between models, so only vertex and index data is counted
+        [[nodiscard]] MeshMemoryUsage GetMemoryUsage() const;
+        void RequestTextures(const glm::mat4& modelMatrix, TextureStreamer& textureStreamer) const;
         // TODO: add support for DrawInstanced (?)
     private:
         std::vector<Vertex> _vertices;
         std::vector<unsigned int> _indices;
+        size_t _verticesCount = 0;
+        size_t _indicesCount = 0;
+        std::vector<MeshLod> _lods;
+        // Sum of sizes of all GL buffers owned by the mesh
+        size_t _gpuBytes = 0;
         std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> _textures;
         GLuint _vaoID;
         GLuint _vboID;
         GLuint _eboID;
+        // Position only stream for depth prepass - it fetches 12 (or 8 for compact meshes) bytes per vertex instead of whole Vertex
+        GLuint _depthVaoID;
+        GLuint _positionsVboID;
+        VertexFormat _format = VertexFormat::FULL;
+        GLenum _indexType = GL_UNSIGNED_INT;
+        glm::vec3 _positionOffset = glm::vec3(0.0f);
+        glm::vec3 _positionScale = glm::vec3(1.0f);
+        // Bounding sphere in model space
+        glm::vec3 _boundsCenter = glm::vec3(0.0f);
+        float _boundsRadius = 0.0f;
+        // Texture coordinate change per model space unit, averaged over the whole surface
+        float _uvDensity = 0.0f;
+        std::shared_ptr<const GeometryToken> _geometryToken = std::make_shared<const GeometryToken>();
         bool _isMoved = false;
+
+        // Helpers
+        void UploadBuffers(std::span<const Vertex> vertices, std::span<const unsigned int> indices);
+        void UploadFullVertices(std::span<const Vertex> vertices);
+        void UploadCompactVertices(std::span<const Vertex> vertices);
+        void UploadIndices(std::span<const unsigned int> indices, size_t verticesCount);
+        void CalculateBounds(std::span<const Vertex> vertices, std::span<const unsigned int> indices);
+        void SetLods(std::vector<MeshLod> lods);
+        [[nodiscard]] const MeshLod& GetLod(size_t lod) const;
+        void DrawLod(size_t lod) const;
     };
 
 } // Renderer3D
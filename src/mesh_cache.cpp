@@ -0,0 +1,418 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <spdlog/spdlog.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RENDERER3D_HAS_MMAP
+#endif
+
+#include "hash.h"
+#include "mesh_cache.h"
+
+namespace Renderer3D {
+    std::unique_ptr<MeshCache> MeshCache::Open(const fs::path& sourcePath, const uint32_t importFlags)
+    {
+        Header expected{};
+        if (!ReadSourceKey(sourcePath, importFlags, expected))
+        {
+            return nullptr;
+        }
+        const auto cachePath = GetCachePath(sourcePath, importFlags);
+        std::error_code error;
+        if (!fs::exists(cachePath, error))
+        {
+            return nullptr;
+        }
+        auto cache = std::unique_ptr<MeshCache>(new MeshCache());
+        if (!cache->MapFile(cachePath) || !cache->IsValid(expected) || !cache->AreDependenciesUpToDate(sourcePath))
+        {
+            spdlog::info("Mesh cache of {} is stale, model will be imported again", sourcePath.string());
+            return nullptr;
+        }
+        return cache;
+    }
+
+    bool MeshCache::Store(const fs::path& sourcePath, const uint32_t importFlags, const std::vector<MeshData>& meshes)
+    {
+        Header header{};
+        if (!ReadSourceKey(sourcePath, importFlags, header))
+        {
+            return false;
+        }
+        header.MeshesCount = meshes.size();
+        const auto dependencies = FindDependencies(sourcePath);
+        header.DependenciesCount = dependencies.size();
+
+        // Layout: header, mesh records, every mesh's aligned vertex blob, aligned index blob, aligned LODs and textures
+        // and at the end aligned dependencies
+        std::vector<MeshRecord> records(meshes.size());
+        auto offset = sizeof(Header) + records.size() * sizeof(MeshRecord);
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            auto& record = records[i];
+            record.VerticesOffset = Align(offset);
+            record.VerticesCount = meshes[i].Vertices.size();
+            record.IndicesOffset = Align(record.VerticesOffset + record.VerticesCount * sizeof(Vertex));
+            record.IndicesCount = meshes[i].Indices.size();
+            record.LodsOffset = Align(record.IndicesOffset + record.IndicesCount * sizeof(unsigned int));
+            record.LodsCount = meshes[i].Lods.size();
+            record.TexturesOffset = record.LodsOffset + record.LodsCount * sizeof(LodRecord);
+            record.TexturesCount = meshes[i].Textures.size();
+            offset = record.TexturesOffset;
+            for (const auto& texture : meshes[i].Textures)
+            {
+                offset += sizeof(TextureRecord) + texture.Path.size();
+            }
+        }
+        header.DependenciesOffset = Align(offset);
+
+        const auto cachePath = GetCachePath(sourcePath, importFlags);
+        std::error_code error;
+        fs::create_directories(cachePath.parent_path(), error);
+        // Written under a temporary name first, so a crash never leaves a truncated file which looks valid
+        auto temporaryPath = cachePath;
+        temporaryPath += ".tmp";
+        {
+            std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                spdlog::error("Failed to create mesh cache file {}", temporaryPath.string());
+                return false;
+            }
+            const auto pad = [&file](const uint64_t target)
+            {
+                static constexpr char zeros[BLOB_ALIGNMENT] = {};
+                file.write(zeros, static_cast<std::streamsize>(target - static_cast<uint64_t>(file.tellp())));
+            };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+            file.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(MeshRecord)));
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                const auto& mesh = meshes[i];
+                pad(records[i].VerticesOffset);
+                file.write(reinterpret_cast<const char*>(mesh.Vertices.data()), static_cast<std::streamsize>(mesh.Vertices.size() * sizeof(Vertex)));
+                pad(records[i].IndicesOffset);
+                file.write(reinterpret_cast<const char*>(mesh.Indices.data()), static_cast<std::streamsize>(mesh.Indices.size() * sizeof(unsigned int)));
+                pad(records[i].LodsOffset);
+                for (const auto& lod : mesh.Lods)
+                {
+                    const LodRecord lodRecord = { lod.FirstIndex, lod.IndexCount, lod.Error, 0 };
+                    file.write(reinterpret_cast<const char*>(&lodRecord), sizeof(LodRecord));
+                }
+                for (const auto& texture : mesh.Textures)
+                {
+                    const TextureRecord textureRecord = { static_cast<uint32_t>(texture.Type), static_cast<uint32_t>(texture.Path.size()) };
+                    file.write(reinterpret_cast<const char*>(&textureRecord), sizeof(TextureRecord));
+                    file.write(texture.Path.data(), static_cast<std::streamsize>(texture.Path.size()));
+                }
+            }
+            pad(header.DependenciesOffset);
+            for (const auto& dependency : dependencies)
+            {
+                auto dependencyRecord = ReadDependencyKey(sourcePath.parent_path() / dependency);
+                dependencyRecord.PathLength = static_cast<uint32_t>(dependency.size());
+                file.write(reinterpret_cast<const char*>(&dependencyRecord), sizeof(DependencyRecord));
+                file.write(dependency.data(), static_cast<std::streamsize>(dependency.size()));
+            }
+            if (!file)
+            {
+                spdlog::error("Failed to write mesh cache file {}", temporaryPath.string());
+                return false;
+            }
+        }
+        fs::rename(temporaryPath, cachePath, error);
+        if (error)
+        {
+            spdlog::error("Failed to move mesh cache file to {} ({})", cachePath.string(), error.message());
+            return false;
+        }
+        return true;
+    }
+
+    size_t MeshCache::GetMeshesCount() const
+    {
+        return reinterpret_cast<const Header*>(_data)->MeshesCount;
+    }
+
+    std::span<const Vertex> MeshCache::GetVertices(const size_t mesh) const
+    {
+        const auto& record = GetMeshRecord(mesh);
+        return { reinterpret_cast<const Vertex*>(_data + record.VerticesOffset), record.VerticesCount };
+    }
+
+    std::span<const unsigned int> MeshCache::GetIndices(const size_t mesh) const
+    {
+        const auto& record = GetMeshRecord(mesh);
+        return { reinterpret_cast<const unsigned int*>(_data + record.IndicesOffset), record.IndicesCount };
+    }
+
+    std::vector<MeshLod> MeshCache::GetLods(const size_t mesh) const
+    {
+        const auto& record = GetMeshRecord(mesh);
+        std::vector<MeshLod> lods;
+        lods.reserve(record.LodsCount);
+        for (size_t i = 0; i < record.LodsCount; i++)
+        {
+            LodRecord lodRecord{};
+            std::memcpy(&lodRecord, _data + record.LodsOffset + i * sizeof(LodRecord), sizeof(LodRecord));
+            lods.push_back({ lodRecord.FirstIndex, lodRecord.IndexCount, lodRecord.Error });
+        }
+        return lods;
+    }
+
+    std::vector<MaterialTextureReference> MeshCache::GetTextures(const size_t mesh) const
+    {
+        const auto& record = GetMeshRecord(mesh);
+        std::vector<MaterialTextureReference> textures;
+        auto offset = record.TexturesOffset;
+        for (size_t i = 0; i < record.TexturesCount; i++)
+        {
+            if (offset + sizeof(TextureRecord) > _size)
+            {
+                spdlog::error("Mesh cache texture list is truncated");
+                break;
+            }
+            TextureRecord textureRecord{};
+            std::memcpy(&textureRecord, _data + offset, sizeof(TextureRecord));
+            offset += sizeof(TextureRecord);
+            if (offset + textureRecord.PathLength > _size)
+            {
+                spdlog::error("Mesh cache texture list is truncated");
+                break;
+            }
+            textures.push_back({ static_cast<TextureType>(textureRecord.Type), std::string(reinterpret_cast<const char*>(_data + offset), textureRecord.PathLength) });
+            offset += textureRecord.PathLength;
+        }
+        return textures;
+    }
+
+    MeshCache::~MeshCache()
+    {
+#ifdef RENDERER3D_HAS_MMAP
+        if (_isMapped)
+        {
+            munmap(const_cast<std::byte*>(_data), _size);
+        }
+#endif
+    }
+
+    bool MeshCache::MapFile(const fs::path& path)
+    {
+#ifdef RENDERER3D_HAS_MMAP
+        const auto fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (fileDescriptor == -1)
+        {
+            return false;
+        }
+        struct stat fileStat{};
+        if (fstat(fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fileDescriptor);
+            return false;
+        }
+        // Mapping stays valid after descriptor is closed
+        const auto mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        close(fileDescriptor);
+        if (mapping == MAP_FAILED)
+        {
+            return false;
+        }
+        _data = static_cast<const std::byte*>(mapping);
+        _size = static_cast<size_t>(fileStat.st_size);
+        _isMapped = true;
+        return true;
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return false;
+        }
+        _buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+        _data = _buffer.data();
+        _size = _buffer.size();
+        return static_cast<bool>(file);
+#endif
+    }
+
+    bool MeshCache::IsValid(const Header& expected) const
+    {
+        if (_size < sizeof(Header))
+        {
+            return false;
+        }
+        const auto& header = *reinterpret_cast<const Header*>(_data);
+        if (std::memcmp(header.Magic, expected.Magic, sizeof(MAGIC)) != 0 || header.Version != expected.Version
+            || header.VertexSize != expected.VertexSize || header.ImportFlags != expected.ImportFlags
+            || header.SourceModificationTime != expected.SourceModificationTime || header.SourceSize != expected.SourceSize
+            || header.ContentHash != expected.ContentHash)
+        {
+            return false;
+        }
+        if (sizeof(Header) + header.MeshesCount * sizeof(MeshRecord) > _size)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < header.MeshesCount; i++)
+        {
+            const auto& record = GetMeshRecord(i);
+            if (record.VerticesOffset + record.VerticesCount * sizeof(Vertex) > _size
+                || record.IndicesOffset + record.IndicesCount * sizeof(unsigned int) > _size
+                || record.LodsOffset + record.LodsCount * sizeof(LodRecord) > _size
+                || record.TexturesOffset > _size)
+            {
+                return false;
+            }
+            // Buffers are uploaded and drawn as they are, so out of range indices or LODs would read past GL buffers
+            if (!std::ranges::all_of(GetIndices(i), [&record](const unsigned int index) { return index < record.VerticesCount; }))
+            {
+                return false;
+            }
+            for (const auto& lod : GetLods(i))
+            {
+                if (lod.FirstIndex > record.IndicesCount || lod.IndexCount > record.IndicesCount - lod.FirstIndex)
+                {
+                    return false;
+                }
+            }
+        }
+        return header.DependenciesOffset <= _size;
+    }
+
+    bool MeshCache::AreDependenciesUpToDate(const fs::path& sourcePath) const
+    {
+        const auto& header = *reinterpret_cast<const Header*>(_data);
+        auto offset = header.DependenciesOffset;
+        for (size_t i = 0; i < header.DependenciesCount; i++)
+        {
+            if (offset + sizeof(DependencyRecord) > _size)
+            {
+                return false;
+            }
+            DependencyRecord stored{};
+            std::memcpy(&stored, _data + offset, sizeof(DependencyRecord));
+            offset += sizeof(DependencyRecord);
+            if (offset + stored.PathLength > _size)
+            {
+                return false;
+            }
+            const std::string path(reinterpret_cast<const char*>(_data + offset), stored.PathLength);
+            offset += stored.PathLength;
+            // Missing file which appeared since, or the other way round, changes materials as well
+            const auto current = ReadDependencyKey(sourcePath.parent_path() / path);
+            if (current.Exists != stored.Exists || current.ModificationTime != stored.ModificationTime || current.Size != stored.Size)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const MeshCache::MeshRecord& MeshCache::GetMeshRecord(const size_t mesh) const
+    {
+        return reinterpret_cast<const MeshRecord*>(_data + sizeof(Header))[mesh];
+    }
+
+    bool MeshCache::ReadSourceKey(const fs::path& sourcePath, const uint32_t importFlags, Header& header)
+    {
+        std::error_code error;
+        const auto modificationTime = fs::last_write_time(sourcePath, error);
+        if (error)
+        {
+            return false;
+        }
+        const auto size = fs::file_size(sourcePath, error);
+        // Hashing is a single sequential read, which is still orders of magnitude faster than parsing
+        const auto hash = hashFile(sourcePath);
+        if (error || !hash)
+        {
+            return false;
+        }
+
+        std::memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+        header.Version = VERSION;
+        header.VertexSize = sizeof(Vertex);
+        header.ImportFlags = importFlags;
+        header.SourceModificationTime = static_cast<int64_t>(modificationTime.time_since_epoch().count());
+        header.SourceSize = size;
+        header.ContentHash = *hash;
+        return true;
+    }
+
+    MeshCache::DependencyRecord MeshCache::ReadDependencyKey(const fs::path& path)
+    {
+        DependencyRecord record{};
+        std::error_code error;
+        const auto modificationTime = fs::last_write_time(path, error);
+        if (error)
+        {
+            return record;
+        }
+        const auto size = fs::file_size(path, error);
+        if (error)
+        {
+            return record;
+        }
+        record.ModificationTime = static_cast<int64_t>(modificationTime.time_since_epoch().count());
+        record.Size = size;
+        record.Exists = 1;
+        return record;
+    }
+
+    std::vector<std::string> MeshCache::FindDependencies(const fs::path& sourcePath)
+    {
+        std::vector<std::string> dependencies;
+        auto extension = sourcePath.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (extension != ".obj")
+        {
+            return dependencies;
+        }
+        // Every `mtllib` statement lists one or more material library files
+        std::ifstream file(sourcePath);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            std::istringstream statement(line);
+            std::string keyword;
+            statement >> keyword;
+            if (keyword != "mtllib")
+            {
+                continue;
+            }
+            std::string library;
+            while (statement >> library)
+            {
+                dependencies.push_back(library);
+            }
+        }
+        return dependencies;
+    }
+
+    fs::path MeshCache::GetCachePath(const fs::path& sourcePath, const uint32_t importFlags)
+    {
+        std::error_code error;
+        const auto canonicalPath = fs::weakly_canonical(sourcePath, error).string();
+        auto hash = hashBytes(std::as_bytes(std::span(canonicalPath)));
+        hash = hashBytes(std::as_bytes(std::span(&importFlags, 1)), hash);
+        return fs::path(CACHE_DIRECTORY) / std::format("{:016x}.mesh", hash);
+    }
+
+    uint64_t MeshCache::Align(const uint64_t offset)
+    {
+        return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+    }
+} // Renderer3D
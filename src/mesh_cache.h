@@ -0,0 +1,121 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+
+namespace fs = std::filesystem;
+
+namespace Renderer3D {
+
+    // Binary cache of imported models. Every source file gets one cache file keyed by its path, modification time,
+    // content hash and import flags, and by modification time and size of material libraries it references. Vertex
+    // and index blobs are stored exactly as full vertex meshes lay them out in GL buffers, so a cache hit maps the file
+    // into memory and uploads them without any parsing. Compact meshes only pack vertices on the way.
+    class MeshCache {
+    public:
+        MeshCache(const MeshCache&) = delete;
+        MeshCache& operator=(const MeshCache&) = delete;
+        // Returns nullptr when there is no cache entry or it is stale
+        [[nodiscard]] static std::unique_ptr<MeshCache> Open(const fs::path& sourcePath, uint32_t importFlags);
+        static bool Store(const fs::path& sourcePath, uint32_t importFlags, const std::vector<MeshData>& meshes);
+        [[nodiscard]] size_t GetMeshesCount() const;
+        // Spans point into the mapped file and stay valid as long as the cache object lives
+        [[nodiscard]] std::span<const Vertex> GetVertices(size_t mesh) const;
+        [[nodiscard]] std::span<const unsigned int> GetIndices(size_t mesh) const;
+        [[nodiscard]] std::vector<MeshLod> GetLods(size_t mesh) const;
+        [[nodiscard]] std::vector<MaterialTextureReference> GetTextures(size_t mesh) const;
+        ~MeshCache();
+    private:
+        struct Header
+        {
+            char Magic[4];
+            uint32_t Version;
+            uint32_t VertexSize;
+            uint32_t ImportFlags;
+            int64_t SourceModificationTime;
+            uint64_t SourceSize;
+            uint64_t ContentHash;
+            uint64_t MeshesCount;
+            uint64_t DependenciesOffset;
+            uint64_t DependenciesCount;
+        };
+
+        // Offsets are in bytes from the beginning of the file
+        struct MeshRecord
+        {
+            uint64_t VerticesOffset;
+            uint64_t VerticesCount;
+            uint64_t IndicesOffset;
+            uint64_t IndicesCount;
+            uint64_t LodsOffset;
+            uint64_t LodsCount;
+            uint64_t TexturesOffset;
+            uint64_t TexturesCount;
+        };
+
+        struct LodRecord
+        {
+            uint64_t FirstIndex;
+            uint64_t IndexCount;
+            float Error;
+            uint32_t Padding;
+        };
+
+        struct TextureRecord
+        {
+            uint32_t Type;
+            uint32_t PathLength;
+        };
+
+        // File read by the importer besides the source itself, path is relative to the source directory and follows the record
+        struct DependencyRecord
+        {
+            int64_t ModificationTime;
+            uint64_t Size;
+            uint32_t Exists;
+            uint32_t PathLength;
+        };
+
+        MeshCache() = default;
+
+        const std::byte* _data = nullptr;
+        size_t _size = 0;
+        // Used instead of a mapping on platforms without mmap
+        std::vector<std::byte> _buffer;
+        bool _isMapped = false;
+
+        // Helpers
+        [[nodiscard]] bool MapFile(const fs::path& path);
+        [[nodiscard]] bool IsValid(const Header& expected) const;
+        [[nodiscard]] bool AreDependenciesUpToDate(const fs::path& sourcePath) const;
+        [[nodiscard]] const MeshRecord& GetMeshRecord(size_t mesh) const;
+        static bool ReadSourceKey(const fs::path& sourcePath, uint32_t importFlags, Header& header);
+        static DependencyRecord ReadDependencyKey(const fs::path& path);
+        // Material libraries referenced by an OBJ file, the only format with external files the importer is built with
+        static std::vector<std::string> FindDependencies(const fs::path& sourcePath);
+        static fs::path GetCachePath(const fs::path& sourcePath, uint32_t importFlags);
+        static uint64_t Align(uint64_t offset);
+
+        // Consts
+        static constexpr char MAGIC[4] = { 'R', '3', 'D', 'M' };
+        // IMPORTANT: bump this whenever layout of the file or of Vertex changes, or import produces different meshes
+        static constexpr uint32_t VERSION = 4;
+        static constexpr uint64_t BLOB_ALIGNMENT = 16;
+        static constexpr auto CACHE_DIRECTORY = "cache/meshes";
+    };
+
+} // Renderer3D
+
+#endif //MESH_CACHE_H
@@ -0,0 +1,782 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <span>
+#include <unordered_map>
+
+#include "hash.h"
+#include "mesh_optimizer.h"
+
+namespace Renderer3D {
+    MeshOptimizationStatistics MeshOptimizer::Optimize(MeshData& mesh)
+    {
+        MeshOptimizationStatistics statistics;
+        statistics.VerticesBefore = mesh.Vertices.size();
+        statistics.TrianglesCount = mesh.Indices.size() / 3;
+        statistics.AcmrBefore = CalculateAcmr(mesh.Indices, mesh.Vertices.size());
+        statistics.OverdrawBefore = CalculateOverdraw(mesh.Indices, mesh.Vertices);
+
+        WeldVertices(mesh);
+        OptimizeVertexCache(mesh.Indices, mesh.Vertices.size());
+        OptimizeOverdraw(mesh.Indices, mesh.Vertices, OVERDRAW_ACMR_THRESHOLD);
+        // Last, as it renumbers vertices without changing triangle order
+        OptimizeVertexFetch(mesh);
+
+        statistics.VerticesAfter = mesh.Vertices.size();
+        statistics.AcmrAfter = CalculateAcmr(mesh.Indices, mesh.Vertices.size());
+        statistics.OverdrawAfter = CalculateOverdraw(mesh.Indices, mesh.Vertices);
+        return statistics;
+    }
+
+    void MeshOptimizer::Merge(MeshData& target, const MeshData& source)
+    {
+        const auto offset = static_cast<unsigned int>(target.Vertices.size());
+        target.Vertices.insert(target.Vertices.end(), source.Vertices.begin(), source.Vertices.end());
+        target.Indices.reserve(target.Indices.size() + source.Indices.size());
+        for (const auto index : source.Indices)
+        {
+            target.Indices.push_back(index + offset);
+        }
+    }
+
+    void MeshOptimizer::Transform(MeshData& mesh, const glm::mat4& transform)
+    {
+        if (transform == glm::mat4(1.0f))
+        {
+            return;
+        }
+        const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+        // Mirroring transforms flip winding, which is restored so front faces stay front faces
+        const auto isMirrored = glm::determinant(glm::mat3(transform)) < 0.0f;
+        for (auto& vertex : mesh.Vertices)
+        {
+            vertex.Position = glm::vec3(transform * glm::vec4(vertex.Position, 1.0f));
+            const auto normal = normalMatrix * vertex.Normal;
+            vertex.Normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : normal;
+        }
+        if (isMirrored)
+        {
+            for (size_t i = 0; i + 2 < mesh.Indices.size(); i += 3)
+            {
+                std::swap(mesh.Indices[i + 1], mesh.Indices[i + 2]);
+            }
+        }
+    }
+
+    void MeshOptimizer::WeldVertices(MeshData& mesh)
+    {
+        // Buckets by content hash, vertices in a bucket are compared byte by byte
+        std::unordered_map<uint64_t, std::vector<unsigned int>> buckets;
+        buckets.reserve(mesh.Vertices.size());
+        std::vector<Vertex> vertices;
+        vertices.reserve(mesh.Vertices.size());
+        std::vector<unsigned int> remap(mesh.Vertices.size());
+        for (size_t i = 0; i < mesh.Vertices.size(); i++)
+        {
+            const auto& vertex = mesh.Vertices[i];
+            auto& bucket = buckets[hashBytes(std::as_bytes(std::span(&vertex, 1)))];
+            const auto it = std::ranges::find_if(bucket, [&vertices, &vertex](const unsigned int index)
+            {
+                return std::memcmp(&vertices[index], &vertex, sizeof(Vertex)) == 0;
+            });
+            if (it != bucket.end())
+            {
+                remap[i] = *it;
+                continue;
+            }
+            remap[i] = static_cast<unsigned int>(vertices.size());
+            bucket.push_back(remap[i]);
+            vertices.push_back(vertex);
+        }
+        for (auto& index : mesh.Indices)
+        {
+            index = remap[index];
+        }
+        mesh.Vertices = std::move(vertices);
+    }
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, const size_t verticesCount)
+    {
+        const auto trianglesCount = indices.size() / 3;
+        if (trianglesCount == 0)
+        {
+            return;
+        }
+
+        // Triangles using every vertex, live ones are kept at the front of each vertex's range
+        std::vector<unsigned int> remainingTriangles(verticesCount, 0);
+        for (size_t i = 0; i < trianglesCount * 3; i++)
+        {
+            remainingTriangles[indices[i]]++;
+        }
+        std::vector<size_t> adjacencyOffsets(verticesCount + 1, 0);
+        for (size_t vertex = 0; vertex < verticesCount; vertex++)
+        {
+            adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingTriangles[vertex];
+        }
+        std::vector<unsigned int> adjacency(adjacencyOffsets.back());
+        std::vector<size_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                adjacency[fill[indices[triangle * 3 + corner]]++] = static_cast<unsigned int>(triangle);
+            }
+        }
+
+        std::vector<int> cachePositions(verticesCount, -1);
+        std::vector<float> vertexScores(verticesCount);
+        for (size_t vertex = 0; vertex < verticesCount; vertex++)
+        {
+            vertexScores[vertex] = CalculateVertexScore(-1, remainingTriangles[vertex]);
+        }
+        std::vector<float> triangleScores(trianglesCount);
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+        }
+        std::vector<bool> isEmitted(trianglesCount, false);
+
+        std::vector<unsigned int> result;
+        result.reserve(trianglesCount * 3);
+        std::vector<unsigned int> cache;
+        std::vector<unsigned int> nextCache;
+        auto bestTriangle = static_cast<int>(std::distance(triangleScores.begin(), std::ranges::max_element(triangleScores)));
+        size_t cursor = 0;
+        while (result.size() < trianglesCount * 3)
+        {
+            if (bestTriangle < 0)
+            {
+                // Nothing in cache has live triangles, so continue with the next unused one
+                while (isEmitted[cursor])
+                {
+                    cursor++;
+                }
+                bestTriangle = static_cast<int>(cursor);
+            }
+            const auto triangle = static_cast<size_t>(bestTriangle);
+            isEmitted[triangle] = true;
+            nextCache.clear();
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const auto vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                nextCache.push_back(vertex);
+                // Triangle is removed from the live part of vertex's adjacency
+                const auto begin = adjacency.begin() + static_cast<long>(adjacencyOffsets[vertex]);
+                const auto end = begin + remainingTriangles[vertex];
+                std::iter_swap(std::find(begin, end, static_cast<unsigned int>(triangle)), end - 1);
+                remainingTriangles[vertex]--;
+            }
+            for (const auto vertex : cache)
+            {
+                if (std::ranges::find(nextCache, vertex) == nextCache.end())
+                {
+                    nextCache.push_back(vertex);
+                }
+            }
+            // Vertices pushed out of the cache lose their position, but still need their scores updated
+            for (size_t i = 0; i < nextCache.size(); i++)
+            {
+                cachePositions[nextCache[i]] = i < OPTIMIZER_CACHE_SIZE ? static_cast<int>(i) : -1;
+            }
+
+            bestTriangle = -1;
+            auto bestScore = -std::numeric_limits<float>::max();
+            for (const auto vertex : nextCache)
+            {
+                vertexScores[vertex] = CalculateVertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+            }
+            for (const auto vertex : nextCache)
+            {
+                for (size_t i = 0; i < remainingTriangles[vertex]; i++)
+                {
+                    const auto adjacent = adjacency[adjacencyOffsets[vertex] + i];
+                    const auto score = vertexScores[indices[adjacent * 3]] + vertexScores[indices[adjacent * 3 + 1]] + vertexScores[indices[adjacent * 3 + 2]];
+                    triangleScores[adjacent] = score;
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        bestTriangle = static_cast<int>(adjacent);
+                    }
+                }
+            }
+            if (nextCache.size() > OPTIMIZER_CACHE_SIZE)
+            {
+                nextCache.resize(OPTIMIZER_CACHE_SIZE);
+            }
+            std::swap(cache, nextCache);
+        }
+        indices = std::move(result);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const float threshold)
+    {
+        const auto trianglesCount = indices.size() / 3;
+        if (trianglesCount == 0)
+        {
+            return;
+        }
+        const auto acmr = CalculateAcmr(indices, vertices.size());
+
+        // Clusters start where the cache is cold anyway - at triangles missing all of their vertices - so reordering
+        // whole clusters costs almost no cache efficiency
+        std::vector<size_t> clusterStarts;
+        std::vector<size_t> cacheTimestamps(vertices.size(), 0);
+        size_t timestamp = ANALYSIS_CACHE_SIZE + 1;
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            size_t misses = 0;
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                const auto vertex = indices[triangle * 3 + corner];
+                if (timestamp - cacheTimestamps[vertex] > ANALYSIS_CACHE_SIZE)
+                {
+                    cacheTimestamps[vertex] = timestamp++;
+                    misses++;
+                }
+            }
+            if (misses == 3 || triangle == 0)
+            {
+                clusterStarts.push_back(triangle);
+            }
+        }
+        if (clusterStarts.size() < 2)
+        {
+            return;
+        }
+        clusterStarts.push_back(trianglesCount);
+
+        // Clusters facing away from the mesh center are likely on its outside and occlude the rest
+        auto meshCentroid = glm::vec3(0.0f);
+        for (const auto& vertex : vertices)
+        {
+            meshCentroid += vertex.Position;
+        }
+        meshCentroid /= static_cast<float>(std::max<size_t>(vertices.size(), 1));
+        const auto clustersCount = clusterStarts.size() - 1;
+        std::vector<float> sortKeys(clustersCount);
+        for (size_t cluster = 0; cluster < clustersCount; cluster++)
+        {
+            auto centroid = glm::vec3(0.0f);
+            auto normal = glm::vec3(0.0f);
+            auto area = 0.0f;
+            for (auto triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+            {
+                const auto& p0 = vertices[indices[triangle * 3]].Position;
+                const auto& p1 = vertices[indices[triangle * 3 + 1]].Position;
+                const auto& p2 = vertices[indices[triangle * 3 + 2]].Position;
+                const auto weightedNormal = glm::cross(p1 - p0, p2 - p0);
+                const auto triangleArea = glm::length(weightedNormal);
+                centroid += (p0 + p1 + p2) / 3.0f * triangleArea;
+                normal += weightedNormal;
+                area += triangleArea;
+            }
+            centroid = area > 0.0f ? centroid / area : vertices[indices[clusterStarts[cluster] * 3]].Position;
+            const auto normalLength = glm::length(normal);
+            sortKeys[cluster] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+        }
+        std::vector<size_t> order(clustersCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::ranges::stable_sort(order, [&sortKeys](const size_t a, const size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (const auto cluster : order)
+        {
+            result.insert(result.end(), indices.begin() + static_cast<long>(clusterStarts[cluster] * 3), indices.begin() + static_cast<long>(clusterStarts[cluster + 1] * 3));
+        }
+        if (CalculateAcmr(result, vertices.size()) <= acmr * threshold)
+        {
+            indices = std::move(result);
+        }
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch(MeshData& mesh)
+    {
+        // Vertices are stored in order of first use, unused ones are dropped
+        constexpr auto UNUSED = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> remap(mesh.Vertices.size(), UNUSED);
+        std::vector<Vertex> vertices;
+        vertices.reserve(mesh.Vertices.size());
+        for (auto& index : mesh.Indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = static_cast<unsigned int>(vertices.size());
+                vertices.push_back(mesh.Vertices[index]);
+            }
+            index = remap[index];
+        }
+        mesh.Vertices = std::move(vertices);
+    }
+
+    float MeshOptimizer::CalculateAcmr(const std::vector<unsigned int>& indices, const size_t verticesCount)
+    {
+        const auto trianglesCount = indices.size() / 3;
+        if (trianglesCount == 0)
+        {
+            return 0.0f;
+        }
+        // FIFO cache simulated with timestamps - vertex is a hit if it entered the cache less than cache size misses ago
+        std::vector<size_t> cacheTimestamps(verticesCount, 0);
+        size_t timestamp = ANALYSIS_CACHE_SIZE + 1;
+        size_t misses = 0;
+        for (size_t i = 0; i < trianglesCount * 3; i++)
+        {
+            if (timestamp - cacheTimestamps[indices[i]] > ANALYSIS_CACHE_SIZE)
+            {
+                cacheTimestamps[indices[i]] = timestamp++;
+                misses++;
+            }
+        }
+        return static_cast<float>(misses) / static_cast<float>(trianglesCount);
+    }
+
+    float MeshOptimizer::CalculateOverdraw(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices)
+    {
+        if (indices.size() < 3 || vertices.empty())
+        {
+            return 0.0f;
+        }
+        auto boundsMin = vertices[0].Position;
+        auto boundsMax = vertices[0].Position;
+        for (const auto& vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+        const auto center = (boundsMin + boundsMax) * 0.5f;
+        const auto extent = std::max(glm::length(boundsMax - boundsMin) * 0.5f, std::numeric_limits<float>::epsilon());
+
+        // Right, up and towards the viewer for views along both directions of every axis
+        static constexpr glm::vec3 views[6][3] = {
+            { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } },
+            { { -1, 0, 0 }, { 0, 1, 0 }, { 0, 0, -1 } },
+            { { 0, 0, -1 }, { 0, 1, 0 }, { 1, 0, 0 } },
+            { { 0, 0, 1 }, { 0, 1, 0 }, { -1, 0, 0 } },
+            { { 1, 0, 0 }, { 0, 0, -1 }, { 0, 1, 0 } },
+            { { 1, 0, 0 }, { 0, 0, 1 }, { 0, -1, 0 } }
+        };
+        std::vector<float> depth(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+        size_t shadedCount = 0;
+        size_t coveredCount = 0;
+        for (const auto& [right, up, towards] : views)
+        {
+            std::ranges::fill(depth, std::numeric_limits<float>::max());
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                glm::vec3 corners[3];
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    const auto position = (vertices[indices[i + corner]].Position - center) / extent;
+                    // Screen position in pixels and depth, which grows away from the viewer
+                    corners[corner] = glm::vec3((glm::dot(position, right) * 0.5f + 0.5f) * OVERDRAW_RESOLUTION, (glm::dot(position, up) * 0.5f + 0.5f) * OVERDRAW_RESOLUTION, -glm::dot(position, towards));
+                }
+                const auto edge = [](const glm::vec3& a, const glm::vec3& b, const float x, const float y)
+                {
+                    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+                };
+                const auto area = edge(corners[0], corners[1], corners[2].x, corners[2].y);
+                // Back faces are culled, as they are when drawing
+                if (area <= 0.0f)
+                {
+                    continue;
+                }
+                const auto minX = std::max(static_cast<int>(std::floor(std::min({ corners[0].x, corners[1].x, corners[2].x }))), 0);
+                const auto maxX = std::min(static_cast<int>(std::ceil(std::max({ corners[0].x, corners[1].x, corners[2].x }))), OVERDRAW_RESOLUTION - 1);
+                const auto minY = std::max(static_cast<int>(std::floor(std::min({ corners[0].y, corners[1].y, corners[2].y }))), 0);
+                const auto maxY = std::min(static_cast<int>(std::ceil(std::max({ corners[0].y, corners[1].y, corners[2].y }))), OVERDRAW_RESOLUTION - 1);
+                for (auto y = minY; y <= maxY; y++)
+                {
+                    for (auto x = minX; x <= maxX; x++)
+                    {
+                        const auto sampleX = static_cast<float>(x) + 0.5f;
+                        const auto sampleY = static_cast<float>(y) + 0.5f;
+                        const auto w0 = edge(corners[1], corners[2], sampleX, sampleY);
+                        const auto w1 = edge(corners[2], corners[0], sampleX, sampleY);
+                        const auto w2 = edge(corners[0], corners[1], sampleX, sampleY);
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        {
+                            continue;
+                        }
+                        const auto sampleDepth = (w0 * corners[0].z + w1 * corners[1].z + w2 * corners[2].z) / area;
+                        auto& storedDepth = depth[y * OVERDRAW_RESOLUTION + x];
+                        if (sampleDepth < storedDepth)
+                        {
+                            coveredCount += storedDepth == std::numeric_limits<float>::max() ? 1 : 0;
+                            storedDepth = sampleDepth;
+                            shadedCount++;
+                        }
+                    }
+                }
+            }
+        }
+        return coveredCount == 0 ? 0.0f : static_cast<float>(shadedCount) / static_cast<float>(coveredCount);
+    }
+
+    void MeshOptimizer::GenerateLods(MeshData& mesh)
+    {
+        mesh.Lods = { {0, mesh.Indices.size(), 0.0f} };
+        auto previousIndices = mesh.Indices;
+        auto previousError = 0.0f;
+        while (mesh.Lods.size() < MAX_LODS)
+        {
+            const auto targetTriangles = static_cast<size_t>(static_cast<float>(previousIndices.size() / 3) * LOD_TRIANGLES_RATIO);
+            if (targetTriangles < MIN_LOD_TRIANGLES)
+            {
+                break;
+            }
+            auto error = 0.0f;
+            auto lodIndices = Simplify(previousIndices, mesh.Vertices, targetTriangles * 3, error);
+            // Locked borders don't let the mesh get any simpler
+            if (static_cast<float>(lodIndices.size()) > static_cast<float>(previousIndices.size()) * (1.0f - MIN_LOD_REDUCTION))
+            {
+                break;
+            }
+            OptimizeVertexCache(lodIndices, mesh.Vertices.size());
+            // Every LOD is simplified from the previous one, so errors add up
+            previousError += error;
+            mesh.Lods.push_back({mesh.Indices.size(), lodIndices.size(), previousError});
+            mesh.Indices.insert(mesh.Indices.end(), lodIndices.begin(), lodIndices.end());
+            previousIndices = std::move(lodIndices);
+        }
+    }
+
+    std::vector<unsigned int> MeshOptimizer::Simplify(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const size_t targetIndexCount, float& error)
+    {
+        error = 0.0f;
+        const auto trianglesCount = indices.size() / 3;
+
+        // Vertices sharing a position form a group, collapses move whole groups
+        std::unordered_map<uint64_t, std::vector<unsigned int>> buckets;
+        buckets.reserve(vertices.size());
+        std::vector<unsigned int> vertexGroups(vertices.size());
+        std::vector<std::vector<unsigned int>> groupVertices;
+        std::vector<glm::vec3> positions;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const auto& position = vertices[i].Position;
+            auto& bucket = buckets[hashBytes(std::as_bytes(std::span(&position, 1)))];
+            const auto it = std::ranges::find_if(bucket, [&positions, &position](const unsigned int group)
+            {
+                return std::memcmp(&positions[group], &position, sizeof(glm::vec3)) == 0;
+            });
+            if (it != bucket.end())
+            {
+                vertexGroups[i] = *it;
+                groupVertices[*it].push_back(static_cast<unsigned int>(i));
+                continue;
+            }
+            vertexGroups[i] = static_cast<unsigned int>(positions.size());
+            bucket.push_back(vertexGroups[i]);
+            groupVertices.push_back({static_cast<unsigned int>(i)});
+            positions.push_back(position);
+        }
+        const auto groupsCount = positions.size();
+
+        // Corners keep both the group and the vertex, the latter is what ends up in the result
+        std::vector<unsigned int> cornerGroups(trianglesCount * 3);
+        std::vector<unsigned int> cornerVertices(indices.begin(), indices.begin() + static_cast<std::ptrdiff_t>(trianglesCount * 3));
+        std::vector<bool> isTriangleAlive(trianglesCount, false);
+        std::vector<std::vector<unsigned int>> groupTriangles(groupsCount);
+        std::vector<Quadric> quadrics(groupsCount);
+        size_t aliveTrianglesCount = 0;
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            const auto g0 = vertexGroups[indices[triangle * 3]];
+            const auto g1 = vertexGroups[indices[triangle * 3 + 1]];
+            const auto g2 = vertexGroups[indices[triangle * 3 + 2]];
+            cornerGroups[triangle * 3] = g0;
+            cornerGroups[triangle * 3 + 1] = g1;
+            cornerGroups[triangle * 3 + 2] = g2;
+            if (g0 == g1 || g1 == g2 || g0 == g2)
+            {
+                continue;
+            }
+            isTriangleAlive[triangle] = true;
+            aliveTrianglesCount++;
+            const auto quadric = CalculateTriangleQuadric(positions[g0], positions[g1], positions[g2]);
+            for (const auto group : {g0, g1, g2})
+            {
+                groupTriangles[group].push_back(static_cast<unsigned int>(triangle));
+                AddQuadric(quadrics[group], quadric);
+            }
+        }
+
+        // Vertices of open and non-manifold edges stay in place, so silhouettes and holes keep their shape
+        const auto edgeKey = [](const unsigned int a, const unsigned int b)
+        {
+            return static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+        };
+        std::unordered_map<uint64_t, unsigned int> edgeTriangles;
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            if (!isTriangleAlive[triangle])
+            {
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; corner++)
+            {
+                edgeTriangles[edgeKey(cornerGroups[triangle * 3 + corner], cornerGroups[triangle * 3 + (corner + 1) % 3])]++;
+            }
+        }
+        std::vector<bool> isLocked(groupsCount, false);
+        for (const auto& [key, count] : edgeTriangles)
+        {
+            if (count != 2)
+            {
+                isLocked[key >> 32] = true;
+                isLocked[key & 0xFFFFFFFF] = true;
+            }
+        }
+
+        // Cheapest collapse first, entries become stale once any of their groups changes
+        struct Collapse
+        {
+            float Cost;
+            unsigned int Source;
+            unsigned int Target;
+            unsigned int SourceVersion;
+            unsigned int TargetVersion;
+        };
+        const auto isMoreExpensive = [](const Collapse& a, const Collapse& b) { return a.Cost > b.Cost; };
+        std::priority_queue<Collapse, std::vector<Collapse>, decltype(isMoreExpensive)> collapses(isMoreExpensive);
+        std::vector<unsigned int> versions(groupsCount, 0);
+        std::vector<bool> isGroupAlive(groupsCount, true);
+        const auto pushCollapse = [&](const unsigned int a, const unsigned int b)
+        {
+            if (isLocked[a] && isLocked[b])
+            {
+                return;
+            }
+            // Source moves onto the target, so its position is where the merged quadric is evaluated
+            auto quadric = quadrics[a];
+            AddQuadric(quadric, quadrics[b]);
+            const auto costToB = isLocked[a] ? std::numeric_limits<float>::max() : EvaluateQuadric(quadric, positions[b]);
+            const auto costToA = isLocked[b] ? std::numeric_limits<float>::max() : EvaluateQuadric(quadric, positions[a]);
+            if (costToB <= costToA)
+            {
+                collapses.push({costToB, a, b, versions[a], versions[b]});
+            }
+            else
+            {
+                collapses.push({costToA, b, a, versions[b], versions[a]});
+            }
+        };
+        for (const auto& [key, count] : edgeTriangles)
+        {
+            if (count == 2)
+            {
+                pushCollapse(static_cast<unsigned int>(key >> 32), static_cast<unsigned int>(key & 0xFFFFFFFF));
+            }
+        }
+
+        const auto collectNeighbours = [&](const unsigned int group)
+        {
+            std::vector<unsigned int> neighbours;
+            for (const auto triangle : groupTriangles[group])
+            {
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    if (cornerGroups[triangle * 3 + corner] != group)
+                    {
+                        neighbours.push_back(cornerGroups[triangle * 3 + corner]);
+                    }
+                }
+            }
+            std::ranges::sort(neighbours);
+            neighbours.erase(std::ranges::unique(neighbours).begin(), neighbours.end());
+            return neighbours;
+        };
+        // Vertex of the group with attributes closest to `vertex`, so seams follow the collapse
+        const auto findClosestVertex = [&](const unsigned int group, const unsigned int vertex)
+        {
+            auto closestVertex = groupVertices[group][0];
+            auto closestDistance = std::numeric_limits<float>::max();
+            for (const auto candidate : groupVertices[group])
+            {
+                const auto distance = 1.0f - glm::dot(vertices[candidate].Normal, vertices[vertex].Normal) + glm::length(vertices[candidate].TexCoords - vertices[vertex].TexCoords);
+                if (distance < closestDistance)
+                {
+                    closestDistance = distance;
+                    closestVertex = candidate;
+                }
+            }
+            return closestVertex;
+        };
+
+        while (aliveTrianglesCount * 3 > targetIndexCount && !collapses.empty())
+        {
+            const auto collapse = collapses.top();
+            collapses.pop();
+            const auto source = collapse.Source;
+            const auto target = collapse.Target;
+            if (!isGroupAlive[source] || !isGroupAlive[target] || versions[source] != collapse.SourceVersion || versions[target] != collapse.TargetVersion)
+            {
+                continue;
+            }
+            // Edge endpoints sharing more than the two opposite vertices would fold the surface onto itself
+            const auto sourceNeighbours = collectNeighbours(source);
+            const auto targetNeighbours = collectNeighbours(target);
+            std::vector<unsigned int> sharedNeighbours;
+            std::ranges::set_intersection(sourceNeighbours, targetNeighbours, std::back_inserter(sharedNeighbours));
+            if (sharedNeighbours.size() != 2)
+            {
+                continue;
+            }
+            // Remaining triangles of the source must not flip
+            auto isFlipping = false;
+            for (const auto triangle : groupTriangles[source])
+            {
+                glm::vec3 before[3];
+                glm::vec3 after[3];
+                auto hasTarget = false;
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    const auto group = cornerGroups[triangle * 3 + corner];
+                    hasTarget = hasTarget || group == target;
+                    before[corner] = positions[group];
+                    after[corner] = group == source ? positions[target] : positions[group];
+                }
+                if (hasTarget)
+                {
+                    continue;
+                }
+                const auto normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+                const auto normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+                if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+                {
+                    isFlipping = true;
+                    break;
+                }
+            }
+            if (isFlipping)
+            {
+                continue;
+            }
+
+            for (const auto triangle : groupTriangles[source])
+            {
+                const auto corners = std::span(cornerGroups).subspan(triangle * 3, 3);
+                if (std::ranges::find(corners, target) != corners.end())
+                {
+                    isTriangleAlive[triangle] = false;
+                    aliveTrianglesCount--;
+                    continue;
+                }
+                for (size_t corner = 0; corner < 3; corner++)
+                {
+                    if (corners[corner] == source)
+                    {
+                        corners[corner] = target;
+                        cornerVertices[triangle * 3 + corner] = findClosestVertex(target, cornerVertices[triangle * 3 + corner]);
+                    }
+                }
+                groupTriangles[target].push_back(triangle);
+            }
+            std::erase_if(groupTriangles[target], [&isTriangleAlive](const unsigned int triangle) { return !isTriangleAlive[triangle]; });
+            groupTriangles[source].clear();
+            isGroupAlive[source] = false;
+            AddQuadric(quadrics[target], quadrics[source]);
+            error = std::max(error, std::sqrt(collapse.Cost));
+            versions[target]++;
+            for (const auto neighbour : collectNeighbours(target))
+            {
+                pushCollapse(target, neighbour);
+            }
+        }
+
+        std::vector<unsigned int> result;
+        result.reserve(aliveTrianglesCount * 3);
+        for (size_t triangle = 0; triangle < trianglesCount; triangle++)
+        {
+            if (isTriangleAlive[triangle])
+            {
+                const auto corners = std::span(cornerVertices).subspan(triangle * 3, 3);
+                result.insert(result.end(), corners.begin(), corners.end());
+            }
+        }
+        return result;
+    }
+
+    float MeshOptimizer::CalculateVertexScore(const int cachePosition, const unsigned int remainingTriangles)
+    {
+        // Vertex without live triangles can't contribute to any choice
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;
+        }
+        auto score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            // Vertices of the last triangle get a fixed score, so the next triangle doesn't simply reuse its edge
+            score = cachePosition < 3 ? LAST_TRIANGLE_SCORE
+                : std::pow(1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+        }
+        // Vertices with few triangles left are preferred, so lone triangles are not left behind
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+    }
+
+    MeshOptimizer::Quadric MeshOptimizer::CalculateTriangleQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+    {
+        Quadric quadric;
+        const auto cross = glm::cross(p1 - p0, p2 - p0);
+        const auto length = glm::length(cross);
+        if (length <= 0.0f)
+        {
+            return quadric;
+        }
+        const auto normal = cross / length;
+        const auto d = -glm::dot(normal, p0);
+        // Larger triangles pull harder, so small details give way first
+        const auto area = static_cast<double>(length) * 0.5;
+        const double plane[4] = { normal.x, normal.y, normal.z, d };
+        size_t value = 0;
+        for (size_t row = 0; row < 4; row++)
+        {
+            for (size_t column = row; column < 4; column++)
+            {
+                quadric.Values[value++] = plane[row] * plane[column] * area;
+            }
+        }
+        quadric.Weight = area;
+        return quadric;
+    }
+
+    void MeshOptimizer::AddQuadric(Quadric& target, const Quadric& source)
+    {
+        for (size_t i = 0; i < std::size(target.Values); i++)
+        {
+            target.Values[i] += source.Values[i];
+        }
+        target.Weight += source.Weight;
+    }
+
+    float MeshOptimizer::EvaluateQuadric(const Quadric& quadric, const glm::vec3& position)
+    {
+        if (quadric.Weight <= 0.0)
+        {
+            return 0.0f;
+        }
+        // Upper triangle of the matrix, off-diagonal values count twice
+        const double point[4] = { position.x, position.y, position.z, 1.0 };
+        auto sum = 0.0;
+        size_t value = 0;
+        for (size_t row = 0; row < 4; row++)
+        {
+            for (size_t column = row; column < 4; column++)
+            {
+                sum += quadric.Values[value++] * point[row] * point[column] * (row == column ? 1.0 : 2.0);
+            }
+        }
+        return static_cast<float>(std::max(sum / quadric.Weight, 0.0));
+    }
+} // Renderer3D
\ No newline at end of file
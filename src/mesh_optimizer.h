@@ -0,0 +1,92 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+namespace Renderer3D {
+
+    struct MeshOptimizationStatistics
+    {
+        size_t VerticesBefore = 0;
+        size_t VerticesAfter = 0;
+        size_t TrianglesCount = 0;
+        // Average post-transform cache misses per triangle, 0.5 is the best possible and 3 the worst
+        float AcmrBefore = 0.0f;
+        float AcmrAfter = 0.0f;
+        // Shaded to covered pixels ratio averaged over six axis aligned views, 1 means no overdraw
+        float OverdrawBefore = 0.0f;
+        float OverdrawAfter = 0.0f;
+    };
+
+    // Import time processing of mesh data, runs on the CPU only and results end up in the mesh cache, so its cost
+    // is paid once per model. Optimize runs the stages in order, each of them keeps the mesh renderable.
+    class MeshOptimizer {
+    public:
+        // Welds vertices, orders triangles for the post-transform vertex cache and then for overdraw,
+        // and finally orders vertices by first use
+        static MeshOptimizationStatistics Optimize(MeshData& mesh);
+        // Appends `source` to `target`, meshes must share the material
+        static void Merge(MeshData& target, const MeshData& source);
+        // Moves vertices and rotates normals to the space of `transform`
+        static void Transform(MeshData& mesh, const glm::mat4& transform);
+        // Merges bitwise identical vertices
+        static void WeldVertices(MeshData& mesh);
+        // Tom Forsyth's linear-speed vertex cache optimization
+        static void OptimizeVertexCache(std::vector<unsigned int>& indices, size_t verticesCount);
+        // Sorts clusters of the cache optimized order so outer, outward facing ones are drawn first. Result is kept only
+        // when ACMR grows by less than `threshold` times.
+        static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold);
+        static void OptimizeVertexFetch(MeshData& mesh);
+        [[nodiscard]] static float CalculateAcmr(const std::vector<unsigned int>& indices, size_t verticesCount);
+        [[nodiscard]] static float CalculateOverdraw(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+        // Appends simplified versions of an optimized mesh to its indices, each with about half of the triangles
+        // of the previous one. All LODs share vertices, so only indices are added.
+        static void GenerateLods(MeshData& mesh);
+        // Quadric error metric edge collapses, run on positions so attribute seams don't stop them. Vertices collapse
+        // onto their neighbours, so result indexes the same `vertices`. `error` is set to the largest distance
+        // the surface moved by.
+        [[nodiscard]] static std::vector<unsigned int> Simplify(const std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, size_t targetIndexCount, float& error);
+    private:
+        // Symmetric 4x4 matrix of summed squared distances to planes, with total area of the planes' triangles
+        struct Quadric
+        {
+            double Values[10] = {};
+            double Weight = 0.0;
+        };
+
+        // Helpers
+        static float CalculateVertexScore(int cachePosition, unsigned int remainingTriangles);
+        static Quadric CalculateTriangleQuadric(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2);
+        static void AddQuadric(Quadric& target, const Quadric& source);
+        // Area weighted mean squared distance from `position` to the planes
+        static float EvaluateQuadric(const Quadric& quadric, const glm::vec3& position);
+
+        // Consts
+        // FIFO cache used for statistics and cluster boundaries, typical for current GPUs
+        static constexpr size_t ANALYSIS_CACHE_SIZE = 16;
+        // Forsyth's constants, tuned by him for a LRU cache of this size
+        static constexpr size_t OPTIMIZER_CACHE_SIZE = 32;
+        static constexpr float CACHE_DECAY_POWER = 1.5f;
+        static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+        static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+        static constexpr float VALENCE_BOOST_POWER = 0.5f;
+        static constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f;
+        static constexpr int OVERDRAW_RESOLUTION = 256;
+        static constexpr size_t MAX_LODS = 6;
+        static constexpr float LOD_TRIANGLES_RATIO = 0.5f;
+        // LOD is dropped when simplification stops before removing at least this share of triangles
+        static constexpr float MIN_LOD_REDUCTION = 0.2f;
+        static constexpr size_t MIN_LOD_TRIANGLES = 64;
+    };
+
+} // Renderer3D
+
+#endif //MESH_OPTIMIZER_H
@@ -0,0 +1,48 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <bit>
+
+#include "mip_chain.h"
+
+namespace Renderer3D {
+    size_t mipLevelsCount(const uint32_t width, const uint32_t height)
+    {
+        return static_cast<size_t>(std::bit_width(std::max({ width, height, 1u })));
+    }
+
+    uint32_t mipLevelDimension(const uint32_t dimension, const size_t level)
+    {
+        return std::max(dimension >> level, 1u);
+    }
+
+    std::vector<uint8_t> downsampleImage(const uint8_t* pixels, const uint32_t width, const uint32_t height, const int components)
+    {
+        const auto nextWidth = mipLevelDimension(width, 1);
+        const auto nextHeight = mipLevelDimension(height, 1);
+        const auto texelSize = static_cast<size_t>(components);
+        std::vector<uint8_t> result(static_cast<size_t>(nextWidth) * nextHeight * texelSize);
+        const auto texel = [pixels, width, texelSize](const uint32_t x, const uint32_t y, const size_t channel)
+        {
+            return static_cast<uint32_t>(pixels[(static_cast<size_t>(y) * width + x) * texelSize + channel]);
+        };
+        for (uint32_t y = 0; y < nextHeight; y++)
+        {
+            const auto y0 = std::min(2 * y, height - 1);
+            const auto y1 = std::min(2 * y + 1, height - 1);
+            for (uint32_t x = 0; x < nextWidth; x++)
+            {
+                const auto x0 = std::min(2 * x, width - 1);
+                const auto x1 = std::min(2 * x + 1, width - 1);
+                for (size_t channel = 0; channel < texelSize; channel++)
+                {
+                    const auto sum = texel(x0, y0, channel) + texel(x1, y0, channel) + texel(x0, y1, channel) + texel(x1, y1, channel);
+                    result[(static_cast<size_t>(y) * nextWidth + x) * texelSize + channel] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        return result;
+    }
+} // Renderer3D
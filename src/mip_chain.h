@@ -0,0 +1,23 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Renderer3D {
+
+    // Number of levels of a full chain, down to 1x1
+    size_t mipLevelsCount(uint32_t width, uint32_t height);
+    uint32_t mipLevelDimension(uint32_t dimension, size_t level);
+    // Next level of a tightly packed 8-bit image using a box filter, the last row or column of odd sized images
+    // is averaged with itself. Doesn't depend on GL, so it is used by workers and the texture baker alike.
+    std::vector<uint8_t> downsampleImage(const uint8_t* pixels, uint32_t width, uint32_t height, int components);
+
+} // Renderer3D
+
+#endif //MIP_CHAIN_H
@@ -2,63 +2,301 @@
 // Created by Kacper Trzciński on 14.01.2025.
 //
 
-#include <assimp/postprocess.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
-#include <stb_image/stb_image.h>
 
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
 #include "model.h"
 
 namespace Renderer3D {
-    Model::Model(const fs::path& path, const bool flipTextures)
+    Model::Model(const fs::path& path, std::shared_ptr<TextureCache> textureCache, const bool flipTextures, const VertexFormat vertexFormat, const MeshDataPolicy dataPolicy)
     {
-        stbi_set_flip_vertically_on_load(flipTextures);
-        Assimp::Importer importer;
-        const auto scene = importer.ReadFile(path.string().c_str(), aiProcess_Triangulate | aiProcess_FlipUVs);
-        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        _directory = path.parent_path();
+        _textureCache = std::move(textureCache);
+        _flipTextures = flipTextures;
+        _vertexFormat = vertexFormat;
+        _dataPolicy = dataPolicy;
+
+        // Warm start - buffers are uploaded straight from the mapped cache file and Assimp is not touched at all
+        if (const auto cache = MeshCache::Open(path, IMPORT_FLAGS))
         {
-            spdlog::error("Failed to load model from {} ({})", path.string(), importer.GetErrorString());
+            for (size_t i = 0; i < cache->GetMeshesCount(); i++)
+            {
+                _meshes.emplace_back(cache->GetVertices(i), cache->GetIndices(i), cache->GetLods(i), LoadMaterialTextures(cache->GetTextures(i)), _vertexFormat, _dataPolicy);
+            }
             return;
         }
+
+        std::vector<MeshData> meshes;
+        if (!Import(path, meshes))
+        {
+            return;
+        }
+        for (auto& mesh : meshes)
+        {
+            auto textures = LoadMaterialTextures(mesh.Textures);
+            _meshes.emplace_back(std::move(mesh.Vertices), std::move(mesh.Indices), std::move(mesh.Lods), std::move(textures), _vertexFormat, _dataPolicy);
+        }
+    }
+
+    Model::Model(const fs::path& path, std::shared_ptr<TextureCache> textureCache, const bool flipTextures, const VertexFormat vertexFormat, const MeshDataPolicy dataPolicy, std::shared_ptr<Model> placeholder)
+    {
         _directory = path.parent_path();
-        ProcessNode(scene->mRootNode, scene);
+        _textureCache = std::move(textureCache);
+        _placeholder = std::move(placeholder);
+        _flipTextures = flipTextures;
+        _vertexFormat = vertexFormat;
+        _dataPolicy = dataPolicy;
+        _isReady = false;
+    }
+
+    std::vector<MeshData> Model::LoadMeshData(const fs::path& path)
+    {
+        std::vector<MeshData> meshes;
+        if (const auto cache = MeshCache::Open(path, IMPORT_FLAGS))
+        {
+            // Copy is made on the calling worker thread, so the main thread only uploads
+            for (size_t i = 0; i < cache->GetMeshesCount(); i++)
+            {
+                const auto vertices = cache->GetVertices(i);
+                const auto indices = cache->GetIndices(i);
+                meshes.push_back({{vertices.begin(), vertices.end()}, {indices.begin(), indices.end()}, cache->GetLods(i), cache->GetTextures(i)});
+            }
+        }
+        else
+        {
+            Import(path, meshes);
+        }
+        // Texture files are hashed here as well, as reading them whole is too slow for the main thread
+        for (auto& mesh : meshes)
+        {
+            for (auto& reference : mesh.Textures)
+            {
+                reference.Content = digestFile(path.parent_path() / reference.Path);
+            }
+        }
+        return meshes;
+    }
+
+    void Model::UploadMesh(MeshData mesh, TextureLoader& textureLoader)
+    {
+        auto textures = LoadMaterialTextures(mesh.Textures, &textureLoader);
+        _meshes.emplace_back(std::move(mesh.Vertices), std::move(mesh.Indices), std::move(mesh.Lods), std::move(textures), _vertexFormat, _dataPolicy);
+    }
+
+    void Model::FinishLoading()
+    {
+        _isReady = true;
+        _placeholder = nullptr;
+    }
+
+    bool Model::IsReady() const
+    {
+        return _isReady;
+    }
+
+    void Model::Draw(const Shader& shader, const size_t lod) const
+    {
+        if (!_isReady)
+        {
+            if (_placeholder)
+            {
+                _placeholder->Draw(shader, lod);
+            }
+            return;
+        }
+        for (auto &mesh: _meshes)
+        {
+            mesh.Draw(shader, lod);
+        }
+    }
+
+    void Model::Draw(const std::shared_ptr<Shader>& shader, const size_t lod) const
+    {
+        if (!_isReady)
+        {
+            if (_placeholder)
+            {
+                _placeholder->Draw(shader, lod);
+            }
+            return;
+        }
+        for (auto &mesh: _meshes)
+        {
+            mesh.Draw(shader, lod);
+        }
     }
 
-    void Model::Draw(const Shader& shader) const
+    void Model::DrawDepth(const std::shared_ptr<Shader>& shader, const size_t lod) const
     {
+        if (!_isReady)
+        {
+            if (_placeholder)
+            {
+                _placeholder->DrawDepth(shader, lod);
+            }
+            return;
+        }
         for (auto &mesh: _meshes)
         {
-            mesh.Draw(shader);
+            mesh.DrawDepth(shader, lod);
         }
     }
 
-    void Model::Draw(const std::shared_ptr<Shader>& shader) const
+    void Model::CollectVisibilityDraws(const glm::mat4& modelMatrix, std::vector<VisibilityDraw>& draws, const size_t lod) const
     {
+        if (!_isReady)
+        {
+            if (_placeholder)
+            {
+                _placeholder->CollectVisibilityDraws(modelMatrix, draws, lod);
+            }
+            return;
+        }
         for (auto &mesh: _meshes)
         {
-            mesh.Draw(shader);
+            draws.push_back({mesh.GetGeometry(lod), modelMatrix, [&mesh](const std::shared_ptr<Shader>& shader) { mesh.BindMaterial(shader); }});
+        }
+    }
+
+    void Model::RequestTextures(const glm::mat4& modelMatrix, TextureStreamer& textureStreamer) const
+    {
+        // Placeholder has no textures
+        if (!_isReady)
+        {
+            return;
+        }
+        for (const auto& mesh : _meshes)
+        {
+            mesh.RequestTextures(modelMatrix, textureStreamer);
+        }
+    }
+
+    const std::vector<Mesh>& Model::GetMeshes() const
+    {
+        return _meshes;
+    }
+
+    size_t Model::GetLodsCount() const
+    {
+        if (!_isReady)
+        {
+            return 1;
+        }
+        size_t lodsCount = 1;
+        for (const auto& mesh : _meshes)
+        {
+            lodsCount = std::max(lodsCount, mesh.GetLodsCount());
+        }
+        return lodsCount;
+    }
+
+    std::pair<glm::vec3, float> Model::GetBoundingSphere() const
+    {
+        if (!_isReady)
+        {
+            return _placeholder ? _placeholder->GetBoundingSphere() : std::pair(glm::vec3(0.0f), 0.0f);
+        }
+        if (_meshes.empty())
+        {
+            return {glm::vec3(0.0f), 0.0f};
+        }
+        // Grown sphere by sphere - not the tightest one, but it always encloses all of them
+        auto center = _meshes[0].GetBoundsCenter();
+        auto radius = _meshes[0].GetBoundsRadius();
+        for (const auto& mesh : _meshes)
+        {
+            const auto offset = mesh.GetBoundsCenter() - center;
+            const auto distance = glm::length(offset);
+            if (distance + mesh.GetBoundsRadius() <= radius)
+            {
+                continue;
+            }
+            if (distance + radius <= mesh.GetBoundsRadius())
+            {
+                center = mesh.GetBoundsCenter();
+                radius = mesh.GetBoundsRadius();
+                continue;
+            }
+            const auto newRadius = (distance + radius + mesh.GetBoundsRadius()) * 0.5f;
+            center += offset * ((newRadius - radius) / distance);
+            radius = newRadius;
+        }
+        return {center, radius};
+    }
+
+    MeshMemoryUsage Model::GetMemoryUsage() const
+    {
+        MeshMemoryUsage usage;
+        for (const auto& mesh : _meshes)
+        {
+            const auto meshUsage = mesh.GetMemoryUsage();
+            usage.CpuBytes += meshUsage.CpuBytes;
+            usage.GpuBytes += meshUsage.GpuBytes;
         }
+        return usage;
     }
 
-    void Model::ProcessNode(const aiNode* node, const aiScene* scene) // NOLINT(*-no-recursion)
+    bool Model::Import(const fs::path& path, std::vector<MeshData>& meshes)
     {
+        Assimp::Importer importer;
+        const auto scene = importer.ReadFile(path.string().c_str(), IMPORT_FLAGS);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            spdlog::error("Failed to load model from {} ({})", path.string(), importer.GetErrorString());
+            return false;
+        }
+        std::unordered_map<unsigned int, size_t> materialMeshes;
+        ProcessNode(scene->mRootNode, scene, glm::mat4(1.0f), materialMeshes, meshes);
+        // Optimized and simplified once here, cache hits get the optimized buffers and LODs for free
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const auto statistics = MeshOptimizer::Optimize(meshes[i]);
+            spdlog::info("Optimized mesh {} of {}: {} -> {} vertices, {} triangles, ACMR {:.3f} -> {:.3f}, overdraw {:.3f} -> {:.3f}",
+                i, path.filename().string(), statistics.VerticesBefore, statistics.VerticesAfter, statistics.TrianglesCount,
+                statistics.AcmrBefore, statistics.AcmrAfter, statistics.OverdrawBefore, statistics.OverdrawAfter);
+            MeshOptimizer::GenerateLods(meshes[i]);
+            const auto& coarsestLod = meshes[i].Lods.back();
+            spdlog::info("Simplified mesh {} of {}: {} LODs, coarsest has {} triangles and error {:.4f}",
+                i, path.filename().string(), meshes[i].Lods.size(), coarsestLod.IndexCount / 3, coarsestLod.Error);
+        }
+        if (!MeshCache::Store(path, IMPORT_FLAGS, meshes))
+        {
+            spdlog::warn("Failed to store mesh cache of {}", path.string());
+        }
+        return true;
+    }
+
+    void Model::ProcessNode(const aiNode* node, const aiScene* scene, const glm::mat4& parentTransform, std::unordered_map<unsigned int, size_t>& materialMeshes, std::vector<MeshData>& meshes) // NOLINT(*-no-recursion)
+    {
+        const auto transform = parentTransform * ConvertMatrix(node->mTransformation);
         for (size_t i = 0; i < node->mNumMeshes; i++)
         {
             const auto mesh = scene->mMeshes[node->mMeshes[i]];
-            auto processedMesh = ProcessMesh(mesh, scene);
-            _meshes.emplace_back(std::move(processedMesh));
+            auto meshData = ProcessMesh(mesh, scene);
+            MeshOptimizer::Transform(meshData, transform);
+            const auto it = materialMeshes.find(mesh->mMaterialIndex);
+            if (it == materialMeshes.end())
+            {
+                materialMeshes.emplace(mesh->mMaterialIndex, meshes.size());
+                meshes.emplace_back(std::move(meshData));
+                continue;
+            }
+            MeshOptimizer::Merge(meshes[it->second], meshData);
         }
         for (size_t i = 0; i < node->mNumChildren; i++)
         {
             const auto childNode = node->mChildren[i];
-            ProcessNode(childNode, scene);
+            ProcessNode(childNode, scene, transform, materialMeshes, meshes);
         }
     }
 
-    Mesh Model::ProcessMesh(const aiMesh* mesh, const aiScene* scene)
+    MeshData Model::ProcessMesh(const aiMesh* mesh, const aiScene* scene)
     {
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
-        std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures;
+        std::vector<MaterialTextureReference> textures;
 
         // Vertices
         for (size_t i = 0; i < mesh->mNumVertices; i++)
@@ -105,38 +343,46 @@ namespace Renderer3D {
         }
 
         // Textures
-        auto material = scene->mMaterials[mesh->mMaterialIndex];
-        auto diffuseMaps = LoadMaterialTextures(material, aiTextureType_DIFFUSE);
-        textures.insert(std::pair(TextureType::DIFFUSE, diffuseMaps));
-        auto specularMaps = LoadMaterialTextures(material, aiTextureType_SPECULAR);
-        textures.insert(std::pair(TextureType::SPECULAR, specularMaps));
+        const auto material = scene->mMaterials[mesh->mMaterialIndex];
+        CollectMaterialTextures(material, aiTextureType_DIFFUSE, textures);
+        CollectMaterialTextures(material, aiTextureType_SPECULAR, textures);
 
-        return {vertices, indices, textures};
+        return {std::move(vertices), std::move(indices), {}, std::move(textures)};
+    }
+
+    glm::mat4 Model::ConvertMatrix(const aiMatrix4x4& matrix)
+    {
+        // Assimp matrices are row major, glm ones are column major
+        return {
+            glm::vec4(matrix.a1, matrix.b1, matrix.c1, matrix.d1),
+            glm::vec4(matrix.a2, matrix.b2, matrix.c2, matrix.d2),
+            glm::vec4(matrix.a3, matrix.b3, matrix.c3, matrix.d3),
+            glm::vec4(matrix.a4, matrix.b4, matrix.c4, matrix.d4)
+        };
     }
 
-    std::vector<std::shared_ptr<Texture>> Model::LoadMaterialTextures(const aiMaterial* material, const aiTextureType assimpType)
+    void Model::CollectMaterialTextures(const aiMaterial* material, const aiTextureType assimpType, std::vector<MaterialTextureReference>& textures)
     {
-        std::vector<std::shared_ptr<Texture>> textures;
         for (size_t i = 0; i < material->GetTextureCount(assimpType); i++)
         {
             aiString str;
             material->GetTexture(assimpType, i, &str);
-            fs::path path(_directory);
-            path.append(str.C_Str());
+            textures.push_back({textureTypeFromAssimp(assimpType), str.C_Str()});
+        }
+    }
 
-            // ReSharper disable once CppTooWideScopeInitStatement
-            const auto loadedId = _loadedTextures.find(path);
-            if (loadedId != _loadedTextures.end())
-            {
-                textures.push_back(loadedId->second);
-            }
-            else
-            {
-                const auto type = textureTypeFromAssimp(assimpType);
-                auto texture = std::make_shared<Texture>(Texture(path, type));
-                textures.push_back(texture);
-                _loadedTextures.insert(std::pair(path, texture));
-            }
+    std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> Model::LoadMaterialTextures(const std::vector<MaterialTextureReference>& references, TextureLoader* textureLoader)
+    {
+        std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> textures;
+        // Every material has both lists, even when they are empty
+        textures[TextureType::DIFFUSE];
+        textures[TextureType::SPECULAR];
+        for (const auto& reference : references)
+        {
+            fs::path path(_directory);
+            path.append(reference.Path);
+            // Cache shares textures with every other model using the same or an identical image
+            textures[reference.Type].push_back(_textureCache->Acquire(path, reference.Type, _flipTextures, textureLoader, reference.Content));
         }
         return textures;
     }
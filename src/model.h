@@ -7,10 +7,14 @@
 
 #include <filesystem>
 #include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include "mesh.h"
 #include "shader.h"
+#include "texture_cache.h"
+#include "texture_loader.h"
+#include "visibility_buffer.h"
 
 namespace fs = std::filesystem;
 
@@ -18,16 +22,50 @@ namespace Renderer3D {
 
     class Model {
     public:
-        explicit Model(const fs::path& path, bool flipTextures = false);
-        void Draw(const Shader& shader) const;
-        void Draw(const std::shared_ptr<Shader>& shader) const;
+        // Compact vertices fit nearly every model, full ones are kept for meshes too big for 16-bit positions
+        Model(const fs::path& path, std::shared_ptr<TextureCache> textureCache, bool flipTextures = false, VertexFormat vertexFormat = VertexFormat::COMPACT, MeshDataPolicy dataPolicy = MeshDataPolicy::RELEASE);
+        // Empty model, which is filled mesh by mesh with UploadMesh - placeholder is drawn instead until FinishLoading
+        Model(const fs::path& path, std::shared_ptr<TextureCache> textureCache, bool flipTextures, VertexFormat vertexFormat, MeshDataPolicy dataPolicy, std::shared_ptr<Model> placeholder);
+        // Reads meshes from cache or imports them, doesn't touch GL so it can be called from any thread
+        [[nodiscard]] static std::vector<MeshData> LoadMeshData(const fs::path& path);
+        // Textures are decoded and uploaded in the background by `textureLoader`
+        void UploadMesh(MeshData mesh, TextureLoader& textureLoader);
+        void FinishLoading();
+        [[nodiscard]] bool IsReady() const;
+        // Every mesh draws given LOD or its coarsest one, whichever is finer
+        void Draw(const Shader& shader, size_t lod = 0) const;
+        void Draw(const std::shared_ptr<Shader>& shader, size_t lod = 0) const;
+        void DrawDepth(const std::shared_ptr<Shader>& shader, size_t lod = 0) const;
+        void CollectVisibilityDraws(const glm::mat4& modelMatrix, std::vector<VisibilityDraw>& draws, size_t lod = 0) const;
+        void RequestTextures(const glm::mat4& modelMatrix, TextureStreamer& textureStreamer) const;
+        [[nodiscard]] const std::vector<Mesh>& GetMeshes() const;
+        // Most LODs of any mesh, 1 until the model is ready
+        [[nodiscard]] size_t GetLodsCount() const;
+        // Sphere enclosing bounds of all meshes in model space, center and radius
+        [[nodiscard]] std::pair<glm::vec3, float> GetBoundingSphere() const;
+        // Sum over meshes uploaded so far, the placeholder is not included
+        [[nodiscard]] MeshMemoryUsage GetMemoryUsage() const;
     private:
         std::vector<Mesh> _meshes;
         fs::path _directory;
-        std::unordered_map<fs::path, std::shared_ptr<Texture>> _loadedTextures;
-        void ProcessNode(const aiNode *node, const aiScene *scene);
-        Mesh ProcessMesh(const aiMesh *mesh, const aiScene *scene);
-        std::vector<std::shared_ptr<Texture>> LoadMaterialTextures(const aiMaterial *material, aiTextureType assimpType);
+        std::shared_ptr<TextureCache> _textureCache = nullptr;
+        std::shared_ptr<Model> _placeholder = nullptr;
+        bool _flipTextures = false;
+        VertexFormat _vertexFormat = VertexFormat::COMPACT;
+        MeshDataPolicy _dataPolicy = MeshDataPolicy::RELEASE;
+        bool _isReady = true;
+        static bool Import(const fs::path& path, std::vector<MeshData>& meshes);
+        // Node transforms are baked into vertices and meshes sharing a material are merged, so the hierarchy is flattened
+        // to one mesh per material. `materialMeshes` maps material indices to positions in `meshes`.
+        static void ProcessNode(const aiNode *node, const aiScene *scene, const glm::mat4& parentTransform, std::unordered_map<unsigned int, size_t>& materialMeshes, std::vector<MeshData>& meshes);
+        static MeshData ProcessMesh(const aiMesh *mesh, const aiScene *scene);
+        static glm::mat4 ConvertMatrix(const aiMatrix4x4& matrix);
+        static void CollectMaterialTextures(const aiMaterial *material, aiTextureType assimpType, std::vector<MaterialTextureReference>& textures);
+        std::unordered_map<TextureType, std::vector<std::shared_ptr<Texture>>> LoadMaterialTextures(const std::vector<MaterialTextureReference>& references, TextureLoader* textureLoader = nullptr);
+
+        // Consts
+        // IMPORTANT: changing these invalidates mesh cache entries, as flags are a part of their key
+        static constexpr unsigned int IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
     };
 
 } // Renderer3D
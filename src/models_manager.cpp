@@ -2,14 +2,100 @@
 // Created by Kacper Trzciński on 21.01.2025.
 //
 
+#include <algorithm>
+#include <chrono>
+
 #include "models_manager.h"
 
 namespace Renderer3D {
+    ModelsManager::ModelsManager(std::shared_ptr<TextureCache> textureCache) : _textureCache(std::move(textureCache))
+    {
+    }
+
     void ModelsManager::AddModel(const std::string& name, const std::shared_ptr<Model>& model)
     {
         _models.insert(std::pair(name, model));
     }
 
+    std::shared_ptr<Model> ModelsManager::LoadModelAsync(const std::string& name, const fs::path& path, const bool flipTextures, const VertexFormat vertexFormat, const MeshDataPolicy dataPolicy)
+    {
+        auto model = std::make_shared<Model>(path, _textureCache, flipTextures, vertexFormat, dataPolicy, GetPlaceholder());
+        PendingModel pendingModel;
+        pendingModel.Target = model;
+        pendingModel.ImportResult = _threadPool.Submit([path]() { return Model::LoadMeshData(path); });
+        _pendingModels.push_back(std::move(pendingModel));
+        AddModel(name, model);
+        return model;
+    }
+
+    size_t ModelsManager::Update(const float uploadBudget)
+    {
+        _textureLoader.Update(uploadBudget * TEXTURE_BUDGET_SHARE);
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto isOverBudget = [start, uploadBudget]()
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= uploadBudget * (1.0f - TEXTURE_BUDGET_SHARE);
+        };
+
+        size_t readyModelsCount = 0;
+        for (auto it = _pendingModels.begin(); it != _pendingModels.end() && !isOverBudget();)
+        {
+            auto& pendingModel = *it;
+            if (!pendingModel.IsImported)
+            {
+                if (pendingModel.ImportResult.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                {
+                    ++it;
+                    continue;
+                }
+                pendingModel.Meshes = pendingModel.ImportResult.get();
+                pendingModel.IsImported = true;
+            }
+            // Single mesh is the smallest unit of work, so at least one is uploaded whenever budget isn't spent yet
+            while (pendingModel.UploadedMeshesCount < pendingModel.Meshes.size() && !isOverBudget())
+            {
+                pendingModel.Target->UploadMesh(std::move(pendingModel.Meshes[pendingModel.UploadedMeshesCount]), _textureLoader);
+                pendingModel.UploadedMeshesCount++;
+            }
+            if (pendingModel.UploadedMeshesCount < pendingModel.Meshes.size())
+            {
+                break;
+            }
+            pendingModel.Target->FinishLoading();
+            readyModelsCount++;
+            it = _pendingModels.erase(it);
+        }
+        return readyModelsCount;
+    }
+
+    size_t ModelsManager::GetPendingModelsCount() const
+    {
+        return _pendingModels.size();
+    }
+
+    size_t ModelsManager::GetPendingTexturesCount() const
+    {
+        return _textureLoader.GetPendingTexturesCount();
+    }
+
+    std::vector<ModelMemoryUsage> ModelsManager::GetMemoryUsage() const
+    {
+        std::vector<ModelMemoryUsage> usages;
+        usages.reserve(_models.size());
+        for (const auto& [name, model] : _models)
+        {
+            usages.push_back({name, model->GetMemoryUsage()});
+        }
+        std::ranges::sort(usages, [](const ModelMemoryUsage& a, const ModelMemoryUsage& b) { return a.Usage.GpuBytes > b.Usage.GpuBytes; });
+        return usages;
+    }
+
+    TextureStreamer& ModelsManager::GetTextureStreamer()
+    {
+        return _textureStreamer;
+    }
+
     std::shared_ptr<Model> ModelsManager::GetModel(const std::string& name)
     {
         const auto it = _models.find(name);
@@ -19,4 +105,45 @@ namespace Renderer3D {
         }
         return it->second;
     }
-} // Renderer3D
\ No newline at end of file
+
+    const std::shared_ptr<Model>& ModelsManager::GetPlaceholder()
+    {
+        // Created on first use, when GL context surely exists
+        if (!_placeholder)
+        {
+            _placeholder = std::make_shared<Model>(fs::path(), _textureCache, false, VertexFormat::COMPACT, MeshDataPolicy::RELEASE, nullptr);
+            _placeholder->UploadMesh(CreatePlaceholderMesh(), _textureLoader);
+            _placeholder->FinishLoading();
+        }
+        return _placeholder;
+    }
+
+    MeshData ModelsManager::CreatePlaceholderMesh()
+    {
+        // Untextured cube, every face has its own vertices so normals stay flat
+        MeshData mesh;
+        const glm::vec3 normals[] = {
+            glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f),
+            glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+            glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+        };
+        for (const auto& normal : normals)
+        {
+            // Tangent and bitangent are picked so that corners below are counter-clockwise seen from outside
+            const auto tangent = normal.x != 0.0f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+            const auto bitangent = glm::cross(normal, tangent);
+            const auto firstVertex = static_cast<unsigned int>(mesh.Vertices.size());
+            const glm::vec2 corners[] = { glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec2(-1.0f, 1.0f) };
+            for (const auto& corner : corners)
+            {
+                const auto position = (normal + corner.x * tangent + corner.y * bitangent) * PLACEHOLDER_HALF_SIZE;
+                mesh.Vertices.push_back({position, normal, corner * 0.5f + 0.5f});
+            }
+            for (const auto index : {0u, 1u, 2u, 0u, 2u, 3u})
+            {
+                mesh.Indices.push_back(firstVertex + index);
+            }
+        }
+        return mesh;
+    }
+} // Renderer3D
@@ -5,20 +5,69 @@
 #ifndef MODELS_MANAGER_H
 #define MODELS_MANAGER_H
 
+#include <future>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "model.h"
+#include "texture_cache.h"
+#include "texture_streamer.h"
+#include "thread_pool.h"
 
 namespace Renderer3D {
 
+    struct ModelMemoryUsage
+    {
+        std::string Name;
+        MeshMemoryUsage Usage;
+    };
+
     class ModelsManager {
     public:
+        explicit ModelsManager(std::shared_ptr<TextureCache> textureCache);
         void AddModel(const std::string& name, const std::shared_ptr<Model>& model);
+        // Model is returned and registered right away, it is imported on a worker thread and drawn as a placeholder
+        // until Update uploads all of its meshes
+        std::shared_ptr<Model> LoadModelAsync(const std::string& name, const fs::path& path, bool flipTextures = false, VertexFormat vertexFormat = VertexFormat::COMPACT, MeshDataPolicy dataPolicy = MeshDataPolicy::RELEASE);
+        // Uploads imported meshes and decoded textures on the GL thread until `uploadBudget` milliseconds pass,
+        // returns how many models became ready
+        size_t Update(float uploadBudget);
+        [[nodiscard]] size_t GetPendingModelsCount() const;
+        [[nodiscard]] size_t GetPendingTexturesCount() const;
+        // Mesh memory of every registered model, biggest GPU users first
+        [[nodiscard]] std::vector<ModelMemoryUsage> GetMemoryUsage() const;
+        TextureStreamer& GetTextureStreamer();
         std::shared_ptr<Model> GetModel(const std::string& name);
     private:
+        struct PendingModel
+        {
+            std::shared_ptr<Model> Target;
+            std::future<std::vector<MeshData>> ImportResult;
+            std::vector<MeshData> Meshes;
+            size_t UploadedMeshesCount = 0;
+            bool IsImported = false;
+        };
+
         std::unordered_map<std::string, std::shared_ptr<Model>> _models =  std::unordered_map<std::string, std::shared_ptr<Model>>();
+        std::vector<PendingModel> _pendingModels;
+        std::shared_ptr<Model> _placeholder = nullptr;
+        std::shared_ptr<TextureCache> _textureCache = nullptr;
+        // Worker tasks capture only their inputs by value, results are handed back through futures
+        ThreadPool _threadPool = ThreadPool(ThreadPool::GetDefaultThreadsCount());
+        // Shares workers with model imports
+        TextureLoader _textureLoader = TextureLoader(_threadPool);
+        TextureStreamer _textureStreamer = TextureStreamer(_textureLoader);
+
+        // Helpers
+        const std::shared_ptr<Model>& GetPlaceholder();
+        static MeshData CreatePlaceholderMesh();
+
+        // Consts
+        static constexpr float PLACEHOLDER_HALF_SIZE = 1.0f;
+        // Part of the upload budget reserved for textures, meshes get the rest
+        static constexpr float TEXTURE_BUDGET_SHARE = 0.5f;
     };
 
 } // Renderer3D
@@ -11,22 +11,17 @@
 namespace Renderer3D {
     PointLightSource::PointLightSource(const glm::vec3 position, const glm::vec3 color, const float linear, const float quadratic)
     {
+        _id = _nextId++;
         _position = position;
         _color = color;
         _linear = linear;
         _quadratic = quadratic;
-        const auto maxBrightness = std::fmaxf(std::fmaxf(_color.r, _color.g), _color.b);
-        _radius = (-_linear + std::sqrt(_linear * _linear - 4 * _quadratic * (1.0f - (256.0f / 5.0f) * maxBrightness))) / (2.0f * _quadratic);
+        _radius = CalculateRadius(_color, _linear, _quadratic);
     }
 
-    void PointLightSource::SetUniforms(const std::shared_ptr<Shader>& shader, const size_t idx) const
+    size_t PointLightSource::GetId() const
     {
-        const auto name = std::format("pointLights[{}]", idx);
-        shader->SetUniform(std::format("{}.position", name), _position);
-        shader->SetUniform(std::format("{}.color", name), _color);
-        shader->SetUniform(std::format("{}.linear", name), _linear);
-        shader->SetUniform(std::format("{}.quadratic", name), _quadratic);
-        shader->SetUniform(std::format("{}.radius", name), _radius);
+        return _id;
     }
 
     glm::vec3 PointLightSource::GetPosition() const
@@ -39,6 +34,21 @@ namespace Renderer3D {
         return _color;
     }
 
+    float PointLightSource::GetLinear() const
+    {
+        return _linear;
+    }
+
+    float PointLightSource::GetQuadratic() const
+    {
+        return _quadratic;
+    }
+
+    float PointLightSource::GetRadius() const
+    {
+        return _radius;
+    }
+
     PointLightSource PointLightSource::GenerateRandom(const float minX, const float maxX, const float minY, const float maxY, const float minZ, const float maxZ)
     {
         // Random offsets
@@ -56,4 +66,26 @@ namespace Renderer3D {
         return PointLightSource(position, color);
     }
 
+    void PointLightSource::UpdateRadius(const float influenceThreshold)
+    {
+        _radius = CalculateRadius(_color, _linear, _quadratic, influenceThreshold);
+    }
+
+    float PointLightSource::CalculateMaxBrightness(const glm::vec3 color)
+    {
+        return std::fmaxf(std::fmaxf(color.r, color.g), color.b);
+    }
+
+    float PointLightSource::CalculateRadius(const glm::vec3 color, const float linear, const float quadratic, const float influenceThreshold)
+    {
+        // Distance at which attenuated light drops below influence threshold (5/256 by default) of its max brightness
+        const auto maxBrightness = CalculateMaxBrightness(color);
+        // Lights that never exceed the threshold (e.g. black ones) would take a square root of a negative number
+        if (maxBrightness <= influenceThreshold)
+        {
+            return 0.0f;
+        }
+        return (-linear + std::sqrt(linear * linear - 4 * quadratic * (1.0f - maxBrightness / influenceThreshold))) / (2.0f * quadratic);
+    }
+
 } // Renderer3D
\ No newline at end of file
@@ -15,16 +15,28 @@ namespace Renderer3D {
     class PointLightSource {
     public:
         PointLightSource(glm::vec3 position, glm::vec3 color, float linear = PointLightSource::DEFAULT_LINEAR, float quadratic = PointLightSource::DEFAULT_QUADRATIC);
-        void SetUniforms(const std::shared_ptr<Shader>& shader, size_t idx) const;
+        // Unique per created light and kept by copies, unlike its index in a container, which changes on removal
+        [[nodiscard]] size_t GetId() const;
         [[nodiscard]] glm::vec3 GetPosition() const;
         [[nodiscard]] glm::vec3 GetColor() const;
+        [[nodiscard]] float GetLinear() const;
+        [[nodiscard]] float GetQuadratic() const;
+        [[nodiscard]] float GetRadius() const;
+        void UpdateRadius(float influenceThreshold);
         static PointLightSource GenerateRandom(float minX, float maxX, float minY, float maxY, float minZ, float maxZ);
+        static float CalculateMaxBrightness(glm::vec3 color);
+        static float CalculateRadius(glm::vec3 color, float linear, float quadratic, float influenceThreshold = PointLightSource::DEFAULT_INFLUENCE_THRESHOLD);
+        // Consts
+        // Part of max brightness below which light is treated as having no effect
+        static constexpr float DEFAULT_INFLUENCE_THRESHOLD = 5.0f / 256.0f;
     private:
+        size_t _id;
         glm::vec3 _position;
         glm::vec3 _color;
         float _linear;
         float _quadratic;
         float _radius;
+        inline static size_t _nextId = 0;
 
         // Consts
         static constexpr float DEFAULT_LINEAR = 0.7f;
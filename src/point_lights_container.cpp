@@ -2,6 +2,7 @@
 // Created by Kacper Trzciński on 17.01.2025.
 //
 
+#include <algorithm>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "point_lights_container.h"
@@ -13,6 +14,7 @@ namespace Renderer3D {
         _pointLights = pointLights;
         GenerateVertices();
         GenerateBuffers();
+        GenerateLightBuffers();
         _pointLightSourceShader = std::make_shared<Shader>("../assets/shaders/light_source_vertex.glsl", "../assets/shaders/light_source_fragment.glsl");
     }
 
@@ -23,8 +25,22 @@ namespace Renderer3D {
         _sphereVaoID = other._sphereVaoID;
         _sphereVboID = other._sphereVboID;
         _sphereEboID = other._sphereEboID;
+        _instancesVboID = other._instancesVboID;
+        _areInstancesDirty = other._areInstancesDirty;
+        _lightTree = std::move(other._lightTree);
+        _isLightTreeDirty = other._isLightTreeDirty;
+        _lightsDataBufferID = other._lightsDataBufferID;
+        _lightsDataTextureID = other._lightsDataTextureID;
+        _tileRangesBufferID = other._tileRangesBufferID;
+        _tileRangesTextureID = other._tileRangesTextureID;
+        _tileIndicesBufferID = other._tileIndicesBufferID;
+        _tileIndicesTextureID = other._tileIndicesTextureID;
+        _shadowSlotLights = std::move(other._shadowSlotLights);
         _sphereVertices = std::move(other._sphereVertices);
         _sphereIndices = std::move(other._sphereIndices);
+        std::ranges::copy(other._markerLodRanges, _markerLodRanges);
+        _markerLod = other._markerLod;
+        _influenceThreshold = other._influenceThreshold;
         _pointLightSourceShader = std::move(other._pointLightSourceShader);
     }
 
@@ -46,6 +62,26 @@ namespace Renderer3D {
         {
             glDeleteBuffers(1, &_sphereEboID);
         }
+        if (_instancesVboID != 0)
+        {
+            glDeleteBuffers(1, &_instancesVboID);
+        }
+        const GLuint textures[] = { _lightsDataTextureID, _tileRangesTextureID, _tileIndicesTextureID };
+        for (const auto texture : textures)
+        {
+            if (texture != 0)
+            {
+                glDeleteTextures(1, &texture);
+            }
+        }
+        const GLuint buffers[] = { _lightsDataBufferID, _tileRangesBufferID, _tileIndicesBufferID };
+        for (const auto buffer : buffers)
+        {
+            if (buffer != 0)
+            {
+                glDeleteBuffers(1, &buffer);
+            }
+        }
     }
 
     bool PointLightsContainer::CanAddPointLight() const
@@ -63,11 +99,19 @@ namespace Renderer3D {
         return _pointLights.size();
     }
 
+    const std::vector<PointLightSource>& PointLightsContainer::GetPointLights() const
+    {
+        return _pointLights;
+    }
+
     void PointLightsContainer::AddPointLight(const PointLightSource& pointLight)
     {
         if (CanAddPointLight())
         {
             _pointLights.push_back(pointLight);
+            _pointLights.back().UpdateRadius(_influenceThreshold);
+            _isLightTreeDirty = true;
+            _areInstancesDirty = true;
         }
     }
 
@@ -75,12 +119,24 @@ namespace Renderer3D {
     {
         if (CanRemovePointLight() && idx < _pointLights.size())
         {
-            _pointLights.erase(_pointLights.begin() + idx);
+            // Order of lights doesn't matter, so avoid shifting the whole vector
+            std::swap(_pointLights[idx], _pointLights.back());
+            _pointLights.pop_back();
+            _isLightTreeDirty = true;
+            _areInstancesDirty = true;
         }
     }
 
-    void PointLightsContainer::RenderPointLights(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, const bool useFog, const float fogStrength, const float cameraFarZ) const
+    void PointLightsContainer::RenderPointLights(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, const bool useFog, const float fogStrength, const float cameraFarZ)
     {
+        if (_pointLights.empty())
+        {
+            return;
+        }
+        if (_areInstancesDirty)
+        {
+            UpdateInstances();
+        }
         // Render light sources using forward rendering
         _pointLightSourceShader->Activate();
         _pointLightSourceShader->SetUniform("view", view);
@@ -88,67 +144,122 @@ namespace Renderer3D {
         _pointLightSourceShader->SetUniform("cameraPos", cameraPos);
         _pointLightSourceShader->SetUniform("useFog", useFog);
         _pointLightSourceShader->SetUniform("fogMaxDist", cameraFarZ - fogStrength);
-        for (const auto & _pointLight : _pointLights)
+        RenderSpheres();
+    }
+
+    void PointLightsContainer::UpdateShadowSlots(const std::vector<size_t>& slotLights)
+    {
+        if (slotLights == _shadowSlotLights)
+        {
+            return;
+        }
+        const auto previousSlotLights = std::move(_shadowSlotLights);
+        _shadowSlotLights = slotLights;
+        // Dirty tree writes all slots while rebuilding light data
+        if (_isLightTreeDirty)
+        {
+            return;
+        }
+        for (const auto lightIndex : previousSlotLights)
+        {
+            WriteShadowSlot(lightIndex, -1);
+        }
+        for (size_t slot = 0; slot < _shadowSlotLights.size(); slot++)
         {
-            auto model = glm::mat4(1.0f);
-            model = glm::translate(model, _pointLight.GetPosition());
-            model = glm::scale(model, glm::vec3(0.125f));
-            _pointLightSourceShader->SetUniform("model", model);
-            _pointLightSourceShader->SetUniform("lightColor", _pointLight.GetColor());
-            RenderSphere();
+            WriteShadowSlot(_shadowSlotLights[slot], static_cast<int>(slot));
         }
     }
 
-    void PointLightsContainer::SetLightingPassPointLightsData(const std::shared_ptr<Shader>& lightingPassShader) const
+    void PointLightsContainer::SetInfluenceThreshold(const float influenceThreshold)
     {
-        lightingPassShader->SetUniform("nrPointLights", static_cast<int>(_pointLights.size()));
-        for (size_t i = 0; i < _pointLights.size(); i++)
+        if (influenceThreshold == _influenceThreshold)
         {
-            _pointLights[i].SetUniforms(lightingPassShader, i);
+            return;
+        }
+        // Every radius changes, so the whole tree is rebuilt
+        _influenceThreshold = influenceThreshold;
+        for (auto& pointLight : _pointLights)
+        {
+            pointLight.UpdateRadius(influenceThreshold);
         }
+        _isLightTreeDirty = true;
+    }
+
+    void PointLightsContainer::SetMarkerLod(const size_t markerLod)
+    {
+        _markerLod = std::min(markerLod, MARKER_LOD_COUNT - 1);
+    }
+
+    void PointLightsContainer::SetLightingPassPointLightsData(const std::shared_ptr<Shader>& lightingPassShader, const glm::mat4& viewProjection, const glm::vec3& cameraPos, const size_t width, const size_t height, const float errorBound, const size_t maxLightsPerTile)
+    {
+        if (_isLightTreeDirty)
+        {
+            UpdateLightTree();
+        }
+        SelectTileLights(viewProjection, cameraPos, width, height, errorBound, maxLightsPerTile);
+
+        lightingPassShader->SetUniform("tilesCountX", static_cast<int>((width + TILE_SIZE - 1) / TILE_SIZE));
+        lightingPassShader->SetUniform("pointLightsData", LIGHTS_DATA_TEXTURE_UNIT);
+        lightingPassShader->SetUniform("tileLightRanges", TILE_RANGES_TEXTURE_UNIT);
+        lightingPassShader->SetUniform("tileLightIndices", TILE_INDICES_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + LIGHTS_DATA_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _lightsDataTextureID);
+        glActiveTexture(GL_TEXTURE0 + TILE_RANGES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _tileRangesTextureID);
+        glActiveTexture(GL_TEXTURE0 + TILE_INDICES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _tileIndicesTextureID);
+        glActiveTexture(GL_TEXTURE0);
     }
 
     void PointLightsContainer::GenerateVertices()
     {
-        // Generate vertices
-        for (unsigned int y = 0; y <= PointLightsContainer::Y_SEGMENTS; ++y)
+        for (size_t lod = 0; lod < MARKER_LOD_COUNT; lod++)
         {
-            for (unsigned int x = 0; x <= PointLightsContainer::X_SEGMENTS; ++x)
+            const auto segments = MARKER_LOD_SEGMENTS[lod];
+            const auto baseVertex = static_cast<unsigned int>(_sphereVertices.size() / 6);
+            _markerLodRanges[lod].first = _sphereIndices.size();
+
+            // Generate vertices
+            for (unsigned int y = 0; y <= segments; ++y)
             {
-                const auto xSegment = static_cast<float>(x) / PointLightsContainer::X_SEGMENTS;
-                const auto ySegment = static_cast<float>(y) / PointLightsContainer::Y_SEGMENTS;
-                const auto xPos = static_cast<float>(std::cos(xSegment * 2.0f * std::numbers::pi) * std::sin(ySegment * std::numbers::pi));
-                const auto yPos = static_cast<float>(std::cos(ySegment * std::numbers::pi));
-                const auto zPos = static_cast<float>(std::sin(xSegment * 2.0f * std::numbers::pi) * std::sin(ySegment * std::numbers::pi));
-
-                // Vertex position
-                _sphereVertices.push_back(xPos);
-                _sphereVertices.push_back(yPos);
-                _sphereVertices.push_back(zPos);
-
-                // Normal (same as position for unit sphere)
-                _sphereVertices.push_back(xPos);
-                _sphereVertices.push_back(yPos);
-                _sphereVertices.push_back(zPos);
+                for (unsigned int x = 0; x <= segments; ++x)
+                {
+                    const auto xSegment = static_cast<float>(x) / static_cast<float>(segments);
+                    const auto ySegment = static_cast<float>(y) / static_cast<float>(segments);
+                    const auto xPos = static_cast<float>(std::cos(xSegment * 2.0f * std::numbers::pi) * std::sin(ySegment * std::numbers::pi));
+                    const auto yPos = static_cast<float>(std::cos(ySegment * std::numbers::pi));
+                    const auto zPos = static_cast<float>(std::sin(xSegment * 2.0f * std::numbers::pi) * std::sin(ySegment * std::numbers::pi));
+
+                    // Vertex position
+                    _sphereVertices.push_back(xPos);
+                    _sphereVertices.push_back(yPos);
+                    _sphereVertices.push_back(zPos);
+
+                    // Normal (same as position for unit sphere)
+                    _sphereVertices.push_back(xPos);
+                    _sphereVertices.push_back(yPos);
+                    _sphereVertices.push_back(zPos);
+                }
             }
-        }
 
-        // Generate indices
-        for (unsigned int y = 0; y < Y_SEGMENTS; ++y)
-        {
-            for (unsigned int x = 0; x < X_SEGMENTS; ++x)
+            // Generate indices - already offset by vertices of previous LODs
+            for (unsigned int y = 0; y < segments; ++y)
             {
-                unsigned int first = (y * (X_SEGMENTS + 1)) + x;
-                unsigned int second = first + X_SEGMENTS + 1;
+                for (unsigned int x = 0; x < segments; ++x)
+                {
+                    unsigned int first = baseVertex + (y * (segments + 1)) + x;
+                    unsigned int second = first + segments + 1;
 
-                _sphereIndices.push_back(first);
-                _sphereIndices.push_back(second);
-                _sphereIndices.push_back(first + 1);
+                    _sphereIndices.push_back(first);
+                    _sphereIndices.push_back(second);
+                    _sphereIndices.push_back(first + 1);
 
-                _sphereIndices.push_back(second);
-                _sphereIndices.push_back(second + 1);
-                _sphereIndices.push_back(first + 1);
+                    _sphereIndices.push_back(second);
+                    _sphereIndices.push_back(second + 1);
+                    _sphereIndices.push_back(first + 1);
+                }
             }
+            _markerLodRanges[lod].second = _sphereIndices.size() - _markerLodRanges[lod].first;
         }
     }
 
@@ -179,15 +290,169 @@ namespace Renderer3D {
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
 
+        // Per instance data - position and color of each light
+        glGenBuffers(1, &_instancesVboID);
+        glBindBuffer(GL_ARRAY_BUFFER, _instancesVboID);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
+        glVertexAttribDivisor(3, 1);
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), reinterpret_cast<void*>(3 * sizeof(float)));
+        glVertexAttribDivisor(4, 1);
+
         // Cleanup
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
     }
 
-    void PointLightsContainer::RenderSphere() const
+    void PointLightsContainer::GenerateLightBuffers()
+    {
+        const std::pair<GLuint*, GLuint*> buffers[] = {
+            { &_lightsDataBufferID, &_lightsDataTextureID },
+            { &_tileRangesBufferID, &_tileRangesTextureID },
+            { &_tileIndicesBufferID, &_tileIndicesTextureID },
+        };
+        const GLenum formats[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+        for (size_t i = 0; i < std::size(buffers); i++)
+        {
+            const auto [bufferID, textureID] = buffers[i];
+            glGenBuffers(1, bufferID);
+            glBindBuffer(GL_TEXTURE_BUFFER, *bufferID);
+            // Buffer textures can't be empty, so start with a single zeroed element
+            constexpr float empty[4] = {};
+            glBufferData(GL_TEXTURE_BUFFER, sizeof(empty), empty, GL_DYNAMIC_DRAW);
+            glGenTextures(1, textureID);
+            glBindTexture(GL_TEXTURE_BUFFER, *textureID);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], *bufferID);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void PointLightsContainer::UpdateInstances()
+    {
+        std::vector<float> instances;
+        instances.reserve(_pointLights.size() * 6);
+        for (const auto& pointLight : _pointLights)
+        {
+            const auto position = pointLight.GetPosition();
+            const auto color = pointLight.GetColor();
+            instances.insert(instances.end(), { position.x, position.y, position.z, color.r, color.g, color.b });
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, _instancesVboID);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(instances.size() * sizeof(float)), instances.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        _areInstancesDirty = false;
+    }
+
+    void PointLightsContainer::UpdateLightTree()
+    {
+        _lightTree.Build(_pointLights, _influenceThreshold);
+
+        // Every node of the tree (not only leaves) is a light that can be shaded,
+        // layout must match `fetchPointLight` in lighting pass fragment shader
+        const auto& nodes = _lightTree.GetNodes();
+        std::vector<glm::vec4> data;
+        data.reserve(std::max<size_t>(nodes.size(), 1) * LIGHT_DATA_STRIDE);
+        for (const auto& node : nodes)
+        {
+            data.emplace_back(node.Position, node.Radius);
+            data.emplace_back(node.Color, node.Linear);
+            data.emplace_back(node.Quadratic, 0.0f, 0.0f, 0.0f);
+        }
+        // Shadow slot is stored shifted by one, so zero means no shadow
+        for (size_t slot = 0; slot < _shadowSlotLights.size(); slot++)
+        {
+            if (const auto node = _lightTree.GetLeafNode(_shadowSlotLights[slot]); node != -1)
+            {
+                data[static_cast<size_t>(node) * LIGHT_DATA_STRIDE + 2].y = static_cast<float>(slot + 1);
+            }
+        }
+        if (data.empty())
+        {
+            data.emplace_back(0.0f);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, _lightsDataBufferID);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(data.size() * sizeof(glm::vec4)), data.data(), GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        _isLightTreeDirty = false;
+        // Node indices changed, so cuts of the old tree are meaningless
+        _tileLightsInputs.reset();
+    }
+
+    void PointLightsContainer::WriteShadowSlot(const size_t lightIndex, const int slot) const
+    {
+        const auto node = _lightTree.GetLeafNode(lightIndex);
+        if (node == -1)
+        {
+            return;
+        }
+        // Only the slot component of the leaf is touched, see `UpdateLightTree` for the layout
+        const auto value = static_cast<float>(slot + 1);
+        const auto offset = (static_cast<size_t>(node) * LIGHT_DATA_STRIDE + 2) * sizeof(glm::vec4) + sizeof(float);
+        glBindBuffer(GL_TEXTURE_BUFFER, _lightsDataBufferID);
+        glBufferSubData(GL_TEXTURE_BUFFER, static_cast<GLintptr>(offset), sizeof(float), &value);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void PointLightsContainer::SelectTileLights(const glm::mat4& viewProjection, const glm::vec3& cameraPos, const size_t width, const size_t height, const float errorBound, const size_t maxLightsPerTile)
+    {
+        // Tile buffers still hold cuts of the same tree seen from the same place
+        const TileLightsInputs inputs = {viewProjection, cameraPos, width, height, errorBound, maxLightsPerTile};
+        if (_tileLightsInputs == inputs)
+        {
+            return;
+        }
+        _tileLightsInputs = inputs;
+
+        const auto tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        const auto tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        _tileRanges.assign(tilesX * tilesY * 2, 0);
+        _tileIndices.clear();
+
+        if (!_lightTree.IsEmpty())
+        {
+            for (size_t y = 0; y < tilesY; y++)
+            {
+                for (size_t x = 0; x < tilesX; x++)
+                {
+                    // Tile bounds in NDC
+                    const auto ndcMin = glm::vec2(
+                        static_cast<float>(x * TILE_SIZE) / static_cast<float>(width) * 2.0f - 1.0f,
+                        static_cast<float>(y * TILE_SIZE) / static_cast<float>(height) * 2.0f - 1.0f
+                    );
+                    const auto ndcMax = glm::vec2(
+                        std::min(static_cast<float>((x + 1) * TILE_SIZE) / static_cast<float>(width) * 2.0f - 1.0f, 1.0f),
+                        std::min(static_cast<float>((y + 1) * TILE_SIZE) / static_cast<float>(height) * 2.0f - 1.0f, 1.0f)
+                    );
+                    const auto tile = LightTree::CalculateTilePlanes(viewProjection, ndcMin, ndcMax);
+                    _lightTree.SelectCut(tile, cameraPos, errorBound, maxLightsPerTile, _cut);
+
+                    const auto tileIndex = y * tilesX + x;
+                    _tileRanges[tileIndex * 2] = static_cast<unsigned int>(_tileIndices.size());
+                    _tileRanges[tileIndex * 2 + 1] = static_cast<unsigned int>(_cut.size());
+                    _tileIndices.insert(_tileIndices.end(), _cut.begin(), _cut.end());
+                }
+            }
+        }
+        if (_tileIndices.empty())
+        {
+            _tileIndices.push_back(0);
+        }
+
+        // Orphan previous storage so we don't wait for the previous frame to finish using it
+        glBindBuffer(GL_TEXTURE_BUFFER, _tileRangesBufferID);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_tileRanges.size() * sizeof(unsigned int)), _tileRanges.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, _tileIndicesBufferID);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_tileIndices.size() * sizeof(unsigned int)), _tileIndices.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void PointLightsContainer::RenderSpheres() const
     {
         glBindVertexArray(_sphereVaoID);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(_sphereIndices.size()), GL_UNSIGNED_INT, nullptr);
+        const auto [firstIndex, indexCount] = _markerLodRanges[_markerLod];
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, reinterpret_cast<void*>(firstIndex * sizeof(unsigned int)), static_cast<GLsizei>(_pointLights.size()));
         glBindVertexArray(0);
     }
 
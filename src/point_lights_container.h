@@ -5,9 +5,11 @@
 #ifndef POINT_LIGHTS_CONTAINER_H
 #define POINT_LIGHTS_CONTAINER_H
 
+#include <optional>
 #include <vector>
 #include <glad/glad.h>
 
+#include "light_tree.h"
 #include "point_light_source.h"
 
 namespace Renderer3D {
@@ -20,11 +22,30 @@ namespace Renderer3D {
         [[nodiscard]] bool CanAddPointLight() const;
         [[nodiscard]] bool CanRemovePointLight() const;
         [[nodiscard]] size_t GetPointLightCount() const;
+        [[nodiscard]] const std::vector<PointLightSource>& GetPointLights() const;
         void AddPointLight(const PointLightSource& pointLight);
         void RemovePointLight(size_t idx);
-        void RenderPointLights(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, bool useFog, float fogStrength, float cameraFarZ) const;
-        void SetLightingPassPointLightsData(const std::shared_ptr<Shader>& lightingPassShader) const;
+        void RenderPointLights(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, bool useFog, float fogStrength, float cameraFarZ);
+        void UpdateShadowSlots(const std::vector<size_t>& slotLights);
+        void SetInfluenceThreshold(float influenceThreshold);
+        void SetMarkerLod(size_t markerLod);
+        void SetLightingPassPointLightsData(const std::shared_ptr<Shader>& lightingPassShader, const glm::mat4& viewProjection, const glm::vec3& cameraPos, size_t width, size_t height, float errorBound, size_t maxLightsPerTile);
+        // Consts
+        static constexpr size_t MARKER_LOD_COUNT = 4;
     private:
+        // Everything tile cuts depend on besides the tree itself
+        struct TileLightsInputs
+        {
+            glm::mat4 ViewProjection;
+            glm::vec3 CameraPos;
+            size_t Width;
+            size_t Height;
+            float ErrorBound;
+            size_t MaxLightsPerTile;
+
+            bool operator==(const TileLightsInputs&) const = default;
+        };
+
         std::vector<PointLightSource> _pointLights;
         bool _isMoved = false;
         std::shared_ptr<Shader> _pointLightSourceShader = nullptr;
@@ -32,17 +53,50 @@ namespace Renderer3D {
         GLuint _sphereVaoID = 0;
         GLuint _sphereVboID = 0;
         GLuint _sphereEboID = 0;
+        GLuint _instancesVboID = 0;
         std::vector<float> _sphereVertices;
         std::vector<unsigned int> _sphereIndices;
+        // First index and index count of every marker LOD, all of them share one vertex and index buffer
+        std::pair<size_t, size_t> _markerLodRanges[MARKER_LOD_COUNT] = {};
+        size_t _markerLod = 0;
+        float _influenceThreshold = PointLightSource::DEFAULT_INFLUENCE_THRESHOLD;
+        bool _areInstancesDirty = true;
+        // Light tree and data passed to lighting pass through buffer textures
+        LightTree _lightTree;
+        bool _isLightTreeDirty = true;
+        GLuint _lightsDataBufferID = 0;
+        GLuint _lightsDataTextureID = 0;
+        GLuint _tileRangesBufferID = 0;
+        GLuint _tileRangesTextureID = 0;
+        GLuint _tileIndicesBufferID = 0;
+        GLuint _tileIndicesTextureID = 0;
+        std::vector<unsigned int> _tileRanges;
+        std::vector<unsigned int> _tileIndices;
+        std::vector<unsigned int> _cut;
+        // Cuts are reused while the tree and these inputs stay the same, e.g. with still camera. Empty means they must be selected again.
+        std::optional<TileLightsInputs> _tileLightsInputs;
+        // Index of the light owning every point shadow slot, passed to the shader with light data
+        std::vector<size_t> _shadowSlotLights;
         // Helpers
         void GenerateVertices();
         void GenerateBuffers();
-        void RenderSphere() const;
+        void GenerateLightBuffers();
+        void UpdateInstances();
+        void UpdateLightTree();
+        void WriteShadowSlot(size_t lightIndex, int slot) const;
+        void SelectTileLights(const glm::mat4& viewProjection, const glm::vec3& cameraPos, size_t width, size_t height, float errorBound, size_t maxLightsPerTile);
+        void RenderSpheres() const;
         // Consts
-        // IMPORTANT: this value must match constant with the same name in lighting pass fragment shader
-        static constexpr unsigned int MAX_NR_POINT_LIGHTS = 256;
-        static constexpr int X_SEGMENTS = 64;
-        static constexpr int Y_SEGMENTS = 64;
+        static constexpr unsigned int MAX_NR_POINT_LIGHTS = 65536;
+        // IMPORTANT: these values must match constants with the same name in lighting pass fragment shader
+        static constexpr int TILE_SIZE = 32;
+        static constexpr int LIGHT_DATA_STRIDE = 3;
+        // Texture units used by lighting pass (0 - 2 are taken by gBuffer)
+        static constexpr int LIGHTS_DATA_TEXTURE_UNIT = 3;
+        static constexpr int TILE_RANGES_TEXTURE_UNIT = 4;
+        static constexpr int TILE_INDICES_TEXTURE_UNIT = 5;
+        // Sphere segments in both directions, from the most detailed marker LOD
+        static constexpr unsigned int MARKER_LOD_SEGMENTS[MARKER_LOD_COUNT] = { 64, 32, 16, 8 };
     };
 
 } // Renderer3D
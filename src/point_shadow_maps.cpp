@@ -0,0 +1,174 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#include "point_shadow_maps.h"
+
+namespace Renderer3D {
+    PointShadowMaps::PointShadowMaps()
+    {
+        // Two layers per slot - front and back hemisphere, sampled with hardware depth comparison
+        glGenTextures(1, &_texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, MAP_SIZE, MAP_SIZE, static_cast<GLsizei>(MAX_SLOTS * LAYERS_PER_SLOT), 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &_framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, _texture, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            spdlog::error("Failed to create point shadow maps framebuffer!");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        _depthShader = std::make_shared<Shader>("../assets/shaders/point_shadow_vertex.glsl", "../assets/shaders/depth_prepass_fragment.glsl");
+    }
+
+    PointShadowMaps::PointShadowMaps(PointShadowMaps&& pointShadowMaps) noexcept
+    {
+        pointShadowMaps._isMoved = true;
+        _slotLights = std::move(pointShadowMaps._slotLights);
+        _slotLightIndices = std::move(pointShadowMaps._slotLightIndices);
+        _candidates = std::move(pointShadowMaps._candidates);
+        _depthShader = std::move(pointShadowMaps._depthShader);
+        _texture = pointShadowMaps._texture;
+        _framebuffer = pointShadowMaps._framebuffer;
+        _shadowedLightsCount = pointShadowMaps._shadowedLightsCount;
+    }
+
+    void PointShadowMaps::Update(const size_t slotsCount, const Scene& scene, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPos)
+    {
+        const auto& pointLightsContainer = scene.GetPointLightContainer();
+        const auto& pointLights = pointLightsContainer->GetPointLights();
+        SelectLights(std::min(slotsCount, MAX_SLOTS), pointLights, cameraViewProjection, cameraPos);
+        pointLightsContainer->UpdateShadowSlots(_slotLightIndices);
+
+        _shadowedLightsCount = std::ranges::count_if(_slotLightIndices, [](const size_t light) { return light != NO_LIGHT; });
+        if (_shadowedLightsCount == 0)
+        {
+            return;
+        }
+
+        // Every occupied slot is redrawn each frame - their count is what bounds the cost
+        glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+        glViewport(0, 0, MAP_SIZE, MAP_SIZE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_CLIP_DISTANCE0);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+        _depthShader->Activate();
+        for (size_t slot = 0; slot < MAX_SLOTS; slot++)
+        {
+            if (_slotLightIndices[slot] != NO_LIGHT)
+            {
+                RenderSlot(slot, pointLights[_slotLightIndices[slot]], scene);
+            }
+        }
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_CLIP_DISTANCE0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void PointShadowMaps::SetUniforms(const std::shared_ptr<Shader>& shader) const
+    {
+        shader->SetUniform("pointShadowMaps", SHADOW_MAPS_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + SHADOW_MAPS_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, _texture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    size_t PointShadowMaps::GetShadowedLightsCount() const
+    {
+        return _shadowedLightsCount;
+    }
+
+    PointShadowMaps::~PointShadowMaps()
+    {
+        if (_isMoved)
+        {
+            return;
+        }
+        glDeleteFramebuffers(1, &_framebuffer);
+        glDeleteTextures(1, &_texture);
+    }
+
+    void PointShadowMaps::SelectLights(const size_t slotsCount, const std::vector<PointLightSource>& pointLights, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPos)
+    {
+        // Only visible lights compete for slots. Screen coverage of light's sphere grows with its radius
+        // and falls with distance to the camera, so radius / distance ranks lights by all three.
+        const auto frustum = LightTree::CalculateTilePlanes(cameraViewProjection, glm::vec2(-1.0f), glm::vec2(1.0f));
+        _candidates.clear();
+        for (size_t i = 0; i < pointLights.size(); i++)
+        {
+            const auto& pointLight = pointLights[i];
+            if (slotsCount == 0 || !isSphereVisible(frustum, pointLight.GetPosition(), pointLight.GetRadius()))
+            {
+                continue;
+            }
+            auto importance = pointLight.GetRadius() / std::max(glm::length(pointLight.GetPosition() - cameraPos), MIN_DISTANCE);
+            if (std::ranges::find(_slotLights, pointLight.GetId()) != _slotLights.end())
+            {
+                importance *= SLOT_HYSTERESIS;
+            }
+            _candidates.emplace_back(importance, i);
+        }
+        const auto selectedCount = std::min(slotsCount, _candidates.size());
+        std::partial_sort(_candidates.begin(), _candidates.begin() + static_cast<long>(selectedCount), _candidates.end(), std::greater());
+        _candidates.resize(selectedCount);
+
+        // Lights that stay selected keep their slots, the rest is placed into freed ones.
+        // Slots remember light ids, as indices shift whenever a light is removed from the container.
+        const auto findCandidate = [this, &pointLights](const size_t lightId)
+        {
+            return std::ranges::find_if(_candidates, [&pointLights, lightId](const auto& candidate) { return pointLights[candidate.second].GetId() == lightId; });
+        };
+        for (size_t slot = 0; slot < MAX_SLOTS; slot++)
+        {
+            const auto candidate = findCandidate(_slotLights[slot]);
+            if (slot >= slotsCount || candidate == _candidates.end())
+            {
+                _slotLights[slot] = NO_LIGHT;
+                _slotLightIndices[slot] = NO_LIGHT;
+                continue;
+            }
+            _slotLightIndices[slot] = candidate->second;
+        }
+        for (const auto& [_, light] : _candidates)
+        {
+            const auto lightId = pointLights[light].GetId();
+            if (std::ranges::find(_slotLights, lightId) != _slotLights.end())
+            {
+                continue;
+            }
+            const auto slot = std::ranges::find(_slotLights, NO_LIGHT) - _slotLights.begin();
+            _slotLights[slot] = lightId;
+            _slotLightIndices[slot] = light;
+        }
+    }
+
+    void PointShadowMaps::RenderSlot(const size_t slot, const PointLightSource& pointLight, const Scene& scene) const
+    {
+        _depthShader->SetUniform("lightPos", pointLight.GetPosition());
+        _depthShader->SetUniform("farPlane", pointLight.GetRadius());
+        for (int layer = 0; layer < LAYERS_PER_SLOT; layer++)
+        {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, _texture, 0, static_cast<GLint>(slot * LAYERS_PER_SLOT) + layer);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            // Back hemisphere is rendered as the front one of a light looking the other way
+            _depthShader->SetUniform("hemisphere", layer == 0 ? 1.0f : -1.0f);
+            scene.RenderEntitiesToPointShadowMap(_depthShader);
+        }
+    }
+} // Renderer3D
@@ -0,0 +1,65 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef POINT_SHADOW_MAPS_H
+#define POINT_SHADOW_MAPS_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "shader.h"
+
+namespace Renderer3D {
+
+    // Dual-paraboloid shadow maps of the few most important point lights. Every slot takes two layers of a single
+    // depth array texture (front and back hemisphere), so shadow cost depends only on the slot count and never
+    // on how many lights the container holds - lights without a slot stay unshadowed.
+    class PointShadowMaps {
+    public:
+        PointShadowMaps();
+        PointShadowMaps(const PointShadowMaps&) = delete;
+        PointShadowMaps& operator=(const PointShadowMaps&) = delete;
+        PointShadowMaps(PointShadowMaps&& pointShadowMaps) noexcept;
+        void Update(size_t slotsCount, const Scene& scene, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPos);
+        void SetUniforms(const std::shared_ptr<Shader>& shader) const;
+        [[nodiscard]] size_t GetShadowedLightsCount() const;
+        ~PointShadowMaps();
+        // Consts
+        static constexpr size_t MAX_SLOTS = 8;
+        static constexpr size_t NO_LIGHT = std::numeric_limits<size_t>::max();
+    private:
+        // Id of the light stored in every slot, `NO_LIGHT` for free slots - indices change when lights are removed
+        std::vector<size_t> _slotLights = std::vector<size_t>(MAX_SLOTS, NO_LIGHT);
+        // Current index of every slot's light in the container, rebuilt each frame
+        std::vector<size_t> _slotLightIndices = std::vector<size_t>(MAX_SLOTS, NO_LIGHT);
+        std::vector<std::pair<float, size_t>> _candidates;
+        std::shared_ptr<Shader> _depthShader = nullptr;
+        GLuint _texture = 0;
+        GLuint _framebuffer = 0;
+        size_t _shadowedLightsCount = 0;
+        bool _isMoved = false;
+
+        // Helpers
+        void SelectLights(size_t slotsCount, const std::vector<PointLightSource>& pointLights, const glm::mat4& cameraViewProjection, const glm::vec3& cameraPos);
+        void RenderSlot(size_t slot, const PointLightSource& pointLight, const Scene& scene) const;
+
+        // IMPORTANT: this value must match POINT_SHADOW_MAP_SIZE in shaders
+        static constexpr int MAP_SIZE = 512;
+        static constexpr int LAYERS_PER_SLOT = 2;
+        // Lights that already own a slot are preferred a bit, so slots don't flicker between lights of similar importance
+        static constexpr float SLOT_HYSTERESIS = 1.25f;
+        static constexpr float MIN_DISTANCE = 0.001f;
+        static constexpr float POLYGON_OFFSET_FACTOR = 2.0f;
+        static constexpr float POLYGON_OFFSET_UNITS = 4.0f;
+        static constexpr int SHADOW_MAPS_TEXTURE_UNIT = 13;
+    };
+
+} // Renderer3D
+
+#endif //POINT_SHADOW_MAPS_H
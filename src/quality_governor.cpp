@@ -0,0 +1,114 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+
+#include "quality_governor.h"
+
+namespace Renderer3D {
+    void QualityGovernor::Update(const bool enabled, const float gpuFrameTime, const float targetFrameTime, const float deltaTime, const QualitySettings& configured, const bool canLower)
+    {
+        if (!enabled)
+        {
+            std::ranges::fill(_levels, 0);
+            _timeSinceAdjustment = 0.0f;
+            ApplyLevels(configured);
+            return;
+        }
+        _timeSinceAdjustment += deltaTime;
+        if (gpuFrameTime > 0.0f && _timeSinceAdjustment >= ADJUST_INTERVAL)
+        {
+            // Raise quality only when there is some headroom, otherwise knobs would oscillate around the budget
+            if (gpuFrameTime > targetFrameTime)
+            {
+                if (canLower)
+                {
+                    Lower();
+                }
+            }
+            else if (gpuFrameTime < targetFrameTime * RAISE_HEADROOM)
+            {
+                Raise();
+            }
+            _timeSinceAdjustment = 0.0f;
+        }
+        // Configured values may change at any time, so settings are recalculated every frame
+        ApplyLevels(configured);
+    }
+
+    const QualitySettings& QualityGovernor::GetSettings() const
+    {
+        return _settings;
+    }
+
+    bool QualityGovernor::IsLowered() const
+    {
+        return std::ranges::any_of(_levels, [](const size_t level) { return level > 0; });
+    }
+
+    size_t QualityGovernor::GetLevel(const QualityKnob knob) const
+    {
+        return _levels[static_cast<size_t>(knob)];
+    }
+
+    size_t QualityGovernor::GetMaxLevel(const QualityKnob knob)
+    {
+        switch (knob)
+        {
+        case QualityKnob::MARKER_LOD:
+            return PointLightsContainer::MARKER_LOD_COUNT - 1;
+        case QualityKnob::MESH_LOD_BIAS:
+            return MESH_LOD_BIAS_LEVELS;
+        case QualityKnob::SHADOW_BUDGET:
+            return SHADOW_BUDGET_LEVELS;
+        case QualityKnob::MAX_LIGHTS_PER_TILE:
+            return MAX_LIGHTS_PER_TILE_LEVELS;
+        case QualityKnob::LIGHT_INFLUENCE_THRESHOLD:
+            return std::size(INFLUENCE_THRESHOLDS);
+        case QualityKnob::COUNT:
+            break;
+        }
+        return 0;
+    }
+
+    void QualityGovernor::Lower()
+    {
+        for (size_t knob = 0; knob < std::size(_levels); knob++)
+        {
+            if (_levels[knob] < GetMaxLevel(static_cast<QualityKnob>(knob)))
+            {
+                _levels[knob]++;
+                return;
+            }
+        }
+    }
+
+    void QualityGovernor::Raise()
+    {
+        // The most recently lowered knob is the last one which is not at full quality
+        for (size_t knob = std::size(_levels); knob-- > 0;)
+        {
+            if (_levels[knob] > 0)
+            {
+                _levels[knob]--;
+                return;
+            }
+        }
+    }
+
+    void QualityGovernor::ApplyLevels(const QualitySettings& configured)
+    {
+        // Every step halves shadow updates and lights per tile, but never goes below their minimum
+        const auto shadowLevel = GetLevel(QualityKnob::SHADOW_BUDGET);
+        _settings.ShadowUpdateBudget = std::max<size_t>(configured.ShadowUpdateBudget >> shadowLevel, 1);
+        _settings.PointShadowSlots = configured.PointShadowSlots >> shadowLevel;
+        _settings.MaxLightsPerTile = std::max(configured.MaxLightsPerTile >> GetLevel(QualityKnob::MAX_LIGHTS_PER_TILE), std::min(configured.MaxLightsPerTile, MIN_LIGHTS_PER_TILE));
+        // Higher threshold gives lights smaller radius, so they touch fewer tiles and pixels
+        const auto thresholdLevel = GetLevel(QualityKnob::LIGHT_INFLUENCE_THRESHOLD);
+        _settings.LightInfluenceThreshold = thresholdLevel == 0 ? configured.LightInfluenceThreshold : std::max(configured.LightInfluenceThreshold, INFLUENCE_THRESHOLDS[thresholdLevel - 1]);
+        _settings.MarkerLod = std::max(configured.MarkerLod, GetLevel(QualityKnob::MARKER_LOD));
+        // Every step moves entities one LOD coarser, which halves their triangles
+        _settings.MeshLodBias = configured.MeshLodBias + static_cast<float>(GetLevel(QualityKnob::MESH_LOD_BIAS)) * MESH_LOD_BIAS_STEP;
+    }
+} // Renderer3D
@@ -0,0 +1,74 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <cstddef>
+
+#include "point_light_source.h"
+#include "point_lights_container.h"
+
+namespace Renderer3D {
+
+    // Values of all knobs controlled by the governor
+    struct QualitySettings
+    {
+        size_t ShadowUpdateBudget = 4;
+        size_t PointShadowSlots = 0;
+        size_t MaxLightsPerTile = 128;
+        float LightInfluenceThreshold = PointLightSource::DEFAULT_INFLUENCE_THRESHOLD;
+        size_t MarkerLod = 0;
+        // In LODs, added to the one every entity picks from its size on screen
+        float MeshLodBias = 0.0f;
+    };
+
+    // Knobs in order in which they are lowered - the ones with the least visible effect go first
+    enum class QualityKnob
+    {
+        MARKER_LOD,
+        MESH_LOD_BIAS,
+        SHADOW_BUDGET,
+        MAX_LIGHTS_PER_TILE,
+        LIGHT_INFLUENCE_THRESHOLD,
+        COUNT
+    };
+
+    // Holds a target frame time by lowering quality knobs one step at a time in priority order when frame is over budget,
+    // and raising them back in reverse order when there is enough headroom. Every knob stays within its configured range.
+    // Knobs are lowered only when `canLower` is set - e.g. once dynamic resolution, which reacts to the same budget, can't go lower.
+    class QualityGovernor {
+    public:
+        void Update(bool enabled, float gpuFrameTime, float targetFrameTime, float deltaTime, const QualitySettings& configured, bool canLower);
+        [[nodiscard]] const QualitySettings& GetSettings() const;
+        // Whether any knob is below full quality
+        [[nodiscard]] bool IsLowered() const;
+        [[nodiscard]] size_t GetLevel(QualityKnob knob) const;
+        [[nodiscard]] static size_t GetMaxLevel(QualityKnob knob);
+    private:
+        // 0 is full quality for every knob
+        size_t _levels[static_cast<size_t>(QualityKnob::COUNT)] = {};
+        float _timeSinceAdjustment = 0.0f;
+        QualitySettings _settings;
+
+        // Helpers
+        void Lower();
+        void Raise();
+        void ApplyLevels(const QualitySettings& configured);
+
+        // Consts
+        // Knobs change slowly, so effect of the last step shows up in frame time before the next one
+        static constexpr float ADJUST_INTERVAL = 0.5f;
+        static constexpr float RAISE_HEADROOM = 0.8f;
+        static constexpr size_t MESH_LOD_BIAS_LEVELS = 2;
+        static constexpr float MESH_LOD_BIAS_STEP = 1.0f;
+        static constexpr size_t SHADOW_BUDGET_LEVELS = 3;
+        static constexpr size_t MAX_LIGHTS_PER_TILE_LEVELS = 3;
+        static constexpr size_t MIN_LIGHTS_PER_TILE = 16;
+        static constexpr float INFLUENCE_THRESHOLDS[] = { 8.0f / 256.0f, 12.0f / 256.0f, 16.0f / 256.0f };
+    };
+
+} // Renderer3D
+
+#endif //QUALITY_GOVERNOR_H
@@ -0,0 +1,160 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#include "render_target_pool.h"
+
+namespace Renderer3D {
+    RenderTargetPool::RenderTargetPool(RenderTargetPool&& pool) noexcept
+    {
+        pool._isMoved = true;
+        _freeTargets = std::move(pool._freeTargets);
+        _allocatedTargetsCount = pool._allocatedTargetsCount;
+        _frame = pool._frame;
+    }
+
+    RenderTarget RenderTargetPool::Acquire(const GLenum internalFormat, const size_t width, const size_t height)
+    {
+        const auto bucketWidth = ToBucket(width);
+        const auto bucketHeight = ToBucket(height);
+        for (size_t i = 0; i < _freeTargets.size(); i++)
+        {
+            const auto& target = _freeTargets[i].Target;
+            if (target.InternalFormat == internalFormat && target.Width == bucketWidth && target.Height == bucketHeight)
+            {
+                const auto result = target;
+                _freeTargets[i] = _freeTargets.back();
+                _freeTargets.pop_back();
+                return result;
+            }
+        }
+        _allocatedTargetsCount++;
+        spdlog::info("Allocating render target {}x{} (format 0x{:x})", bucketWidth, bucketHeight, internalFormat);
+        return Allocate(internalFormat, bucketWidth, bucketHeight);
+    }
+
+    void RenderTargetPool::Release(const RenderTarget& target)
+    {
+        if (target.Texture == 0)
+        {
+            return;
+        }
+        _freeTargets.push_back({target, _frame});
+    }
+
+    void RenderTargetPool::EndFrame()
+    {
+        _frame++;
+        // Trim targets which weren't needed for a while, e.g. sizes passed during window drag
+        for (size_t i = 0; i < _freeTargets.size();)
+        {
+            if (_frame - _freeTargets[i].ReleaseFrame > MAX_FREE_FRAMES)
+            {
+                glDeleteTextures(1, &_freeTargets[i].Target.Texture);
+                _allocatedTargetsCount--;
+                _freeTargets[i] = _freeTargets.back();
+                _freeTargets.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    size_t RenderTargetPool::GetAllocatedTargetsCount() const
+    {
+        return _allocatedTargetsCount;
+    }
+
+    size_t RenderTargetPool::GetFreeTargetsCount() const
+    {
+        return _freeTargets.size();
+    }
+
+    bool RenderTargetPool::IsWastingMemory(const RenderTarget& target, const size_t width, const size_t height)
+    {
+        // Target which is bigger than needed is still reused, unless it is at least a whole bucket too big
+        return target.Width > ToBucket(width) || target.Height > ToBucket(height);
+    }
+
+    RenderTargetPool::~RenderTargetPool()
+    {
+        if (_isMoved)
+        {
+            return;
+        }
+        for (const auto& freeTarget : _freeTargets)
+        {
+            glDeleteTextures(1, &freeTarget.Target.Texture);
+        }
+    }
+
+    RenderTarget RenderTargetPool::Allocate(const GLenum internalFormat, const size_t width, const size_t height)
+    {
+        GLenum format;
+        GLenum type;
+        if (!GetPixelFormat(internalFormat, format, type))
+        {
+            spdlog::error("Unsupported render target format: 0x{:x}", internalFormat);
+            return {};
+        }
+        RenderTarget target;
+        target.InternalFormat = internalFormat;
+        target.Width = width;
+        target.Height = height;
+        glGenTextures(1, &target.Texture);
+        glBindTexture(GL_TEXTURE_2D, target.Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(internalFormat), static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return target;
+    }
+
+    size_t RenderTargetPool::ToBucket(const size_t size)
+    {
+        return std::max<size_t>(1, (size + SIZE_BUCKET - 1) / SIZE_BUCKET) * SIZE_BUCKET;
+    }
+
+    bool RenderTargetPool::GetPixelFormat(const GLenum internalFormat, GLenum& format, GLenum& type)
+    {
+        switch (internalFormat)
+        {
+        case GL_RG16:
+            format = GL_RG;
+            type = GL_UNSIGNED_SHORT;
+            return true;
+        case GL_RGBA8:
+            format = GL_RGBA;
+            type = GL_UNSIGNED_BYTE;
+            return true;
+        case GL_RGBA16F:
+            format = GL_RGBA;
+            type = GL_FLOAT;
+            return true;
+        case GL_R32F:
+            format = GL_RED;
+            type = GL_FLOAT;
+            return true;
+        case GL_R32UI:
+            format = GL_RED_INTEGER;
+            type = GL_UNSIGNED_INT;
+            return true;
+        case GL_DEPTH_COMPONENT32F:
+            format = GL_DEPTH_COMPONENT;
+            type = GL_FLOAT;
+            return true;
+        case GL_DEPTH24_STENCIL8:
+            format = GL_DEPTH_STENCIL;
+            type = GL_UNSIGNED_INT_24_8;
+            return true;
+        default:
+            return false;
+        }
+    }
+} // Renderer3D
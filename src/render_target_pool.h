@@ -0,0 +1,61 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef RENDER_TARGET_POOL_H
+#define RENDER_TARGET_POOL_H
+
+#include <vector>
+#include <glad/glad.h>
+
+namespace Renderer3D {
+
+    struct RenderTarget
+    {
+        GLuint Texture = 0;
+        GLenum InternalFormat = GL_NONE;
+        // Allocated size, it is always at least the requested one
+        size_t Width = 0;
+        size_t Height = 0;
+    };
+
+    class RenderTargetPool {
+    public:
+        RenderTargetPool() = default;
+        RenderTargetPool(const RenderTargetPool&) = delete;
+        RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+        RenderTargetPool(RenderTargetPool&& pool) noexcept;
+        [[nodiscard]] RenderTarget Acquire(GLenum internalFormat, size_t width, size_t height);
+        void Release(const RenderTarget& target);
+        void EndFrame();
+        [[nodiscard]] size_t GetAllocatedTargetsCount() const;
+        [[nodiscard]] size_t GetFreeTargetsCount() const;
+        static bool IsWastingMemory(const RenderTarget& target, size_t width, size_t height);
+        ~RenderTargetPool();
+    private:
+        struct FreeTarget
+        {
+            RenderTarget Target;
+            size_t ReleaseFrame;
+        };
+        // Released targets waiting to be reused
+        std::vector<FreeTarget> _freeTargets;
+        size_t _allocatedTargetsCount = 0;
+        size_t _frame = 0;
+        bool _isMoved = false;
+
+        // Helpers
+        static RenderTarget Allocate(GLenum internalFormat, size_t width, size_t height);
+        static size_t ToBucket(size_t size);
+        static bool GetPixelFormat(GLenum internalFormat, GLenum& format, GLenum& type);
+
+        // Consts
+        // Sizes are rounded up to multiples of this, so small resizes keep hitting the same targets
+        static constexpr size_t SIZE_BUCKET = 256;
+        // Free targets not reused for this many frames are deleted
+        static constexpr size_t MAX_FREE_FRAMES = 120;
+    };
+
+} // Renderer3D
+
+#endif //RENDER_TARGET_POOL_H
@@ -12,7 +12,7 @@
 #include "shader.h"
 
 namespace Renderer3D {
-    Renderer::Renderer() : _window(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT), _deferredShader(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT), _scene(std::make_unique<Scene>(Scene()))
+    Renderer::Renderer() : _window(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT), _deferredShader(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT), _scene(std::make_unique<Scene>(*_textureCache))
     {
         // We store pointer to renderer inside window so we could easily set up callbacks
         _window.SetUserPointer(this);
@@ -44,6 +44,7 @@ namespace Renderer3D {
 
             // Handle input
             ProcessInput();
+            ApplyPendingResize();
 
             // Update camera mode
             _cameras[GetCameraId(_controls->GetCameraType())].UpdateProjectionType(_controls->GetProjectionType());
@@ -57,42 +58,174 @@ namespace Renderer3D {
                 _cameras[GetCameraId(CameraType::MOVING)].UpdateUseFlashlight(false);
             }
 
+            // Dynamic resolution - scale is chosen based on GPU time of previous frames. It goes down before quality knobs
+            // and comes back up after them, so the two don't fight over the same budget.
+            _dynamicResolution.Update(_controls->IsDynamicResolution(), _controls->GetTargetFrameTime(), !_qualityGovernor.IsLowered());
+            _deferredShader.SetRenderScale(_dynamicResolution.GetScale());
+            const auto renderingPath = _controls->GetRenderingPath();
+            const auto debugView = _controls->GetDebugView();
+            // Forward+ has no lighting pass, which would keep history up to date. Debug views must count every pixel of the current frame.
+            _deferredShader.SetTemporalReprojection(_controls->IsTemporalReprojection() && renderingPath != RenderingPath::FORWARD_PLUS && debugView == DebugView::NONE);
+            _deferredShader.SetDebugView(debugView);
+            _deferredShader.SetVisibilityBuffer(renderingPath == RenderingPath::VISIBILITY_BUFFER);
+            _controls->UpdateDynamicResolutionStats(_dynamicResolution.GetScale(), _dynamicResolution.GetGpuFrameTime());
+
+            // Quality governor - knobs chosen in controls are lowered while GPU frame time is over the same budget
+            // and resolution can't go any lower
+            const auto canLowerQuality = !_controls->IsDynamicResolution() || _dynamicResolution.IsAtMinScale();
+            _qualityGovernor.Update(_controls->IsQualityGovernor(), _dynamicResolution.GetGpuFrameTime(), _controls->GetTargetFrameTime(), _deltaTime, _controls->GetConfiguredQuality(), canLowerQuality);
+            const auto& quality = _qualityGovernor.GetSettings();
+            _scene->GetPointLightContainer()->SetInfluenceThreshold(quality.LightInfluenceThreshold);
+            _scene->GetPointLightContainer()->SetMarkerLod(quality.MarkerLod);
+            _controls->UpdateGovernorStats(_qualityGovernor);
+
             // Render
+            _dynamicResolution.BeginFrame();
             glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
             // Camera matrices
             const auto projection = _cameras[GetCameraId(_controls->GetCameraType())].GetProjectionMatrix();
             const auto view = _cameras[GetCameraId(_controls->GetCameraType())].GetViewMatrix();
 
-            // Geometry pass - render data into gBuffer
-            _deferredShader.BindGBuffer();
-            _deferredShader.GetGeometryPassShader()->Activate();
             _scene->UpdateEntities(_deltaTime);
-            _scene->RenderEntitiesToGeometryPass(_deferredShader.GetGeometryPassShader(), view, projection);
+            if (_scene->SelectLods(projection, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition(), _deferredShader.GetRenderHeight(), quality.MeshLodBias))
+            {
+                // Shadow casters are drawn at the LOD picked for the camera, so static ones must match receivers again
+                _shadowAtlas.InvalidateStaticCasters();
+            }
 
-            // Bind back to default frame buffer
-            _deferredShader.UnbindGBuffer();
+            // Visible entities request mips of their textures, streamer loads and evicts them within the budget
+            auto& textureStreamer = _modelsManager->GetTextureStreamer();
+            textureStreamer.BeginFrame(view, projection, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition(), _deferredShader.GetRenderHeight());
+            _scene->RequestTextures(textureStreamer);
+            textureStreamer.Update(_controls->GetTextureBudget());
+            _controls->UpdateTextureStreamingStats(textureStreamer.GetStatistics());
 
-            // Lighting pass - calculate lighting using data from geometry pass
-            _deferredShader.GetLightingPassShader()->Activate();
-            _deferredShader.BindGTextures();
-            _scene->SetLightingPassShaderData(_deferredShader.GetLightingPassShader());
-            _deferredShader.GetLightingPassShader()->SetUniform("cameraPos", _cameras[GetCameraId(_controls->GetCameraType())].GetPosition());
-            _deferredShader.UpdateSceneMode(_controls->GetSceneMode());
-            _deferredShader.UpdateFogStrength(_controls->GetFogStrength(), _cameras[GetCameraId(_controls->GetCameraType())].GetFarZ());
-            _spotLightsFactory.SetSpotLightsCountUniform(_deferredShader.GetLightingPassShader());
-            _cameras[GetCameraId(CameraType::MOVING)].SetFlashlightUniforms(_deferredShader.GetLightingPassShader());
+            // Models imported in the background are uploaded within a budget, placeholders are drawn until then
+            if (_modelsManager->Update(MODEL_UPLOAD_BUDGET) > 0)
+            {
+                // Static shadow casters changed their shape
+                _shadowAtlas.InvalidateStaticCasters();
+            }
+            _controls->UpdateLoadingStats(_modelsManager->GetPendingModelsCount(), _modelsManager->GetPendingTexturesCount());
+            _controls->UpdateModelMemoryStats(_modelsManager->GetMemoryUsage());
+            _textureCache->Purge();
+            _controls->UpdateTextureCacheStats(_textureCache->GetStatistics());
+
+            // Spotlight shadows - only tiles that changed are redrawn, and no more than the budget per frame
+            _spotLights.clear();
+            if (const auto flashlight = _cameras[GetCameraId(CameraType::MOVING)].GetFlashlight(); flashlight != nullptr)
+            {
+                _spotLights.push_back(flashlight);
+            }
+            _scene->CollectSpotLights(_spotLights);
+            _gpuProfiler.BeginPass("Spotlight shadows");
+            _shadowAtlas.Update(_controls->IsSpotLightShadows(), _spotLights, *_scene, _deferredShader.GetDepthPrepassShader(), projection * view, quality.ShadowUpdateBudget);
+            _gpuProfiler.EndPass();
+            _controls->UpdateShadowStats(_shadowAtlas.GetUpdatedTilesCount(), _shadowAtlas.GetStaticRendersCount());
+
+            // Point light shadows - fixed number of slots, given to the most important lights
+            _gpuProfiler.BeginPass("Point light shadows");
+            _pointShadowMaps.Update(quality.PointShadowSlots, *_scene, projection * view, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition());
+            _gpuProfiler.EndPass();
+            _controls->UpdatePointShadowStats(_pointShadowMaps.GetShadowedLightsCount());
+
+            if (debugView == DebugView::OVERDRAW)
+            {
+                // Overdraw - geometry is drawn with the same depth state as in geometry pass of the selected path,
+                // but every fragment just adds one to scene color
+                _deferredShader.BindGBuffer();
+                if (renderingPath == RenderingPath::FORWARD_PLUS || (renderingPath == RenderingPath::G_BUFFER && _controls->IsDepthPrepass()))
+                {
+                    RenderDepthPrepass(view, projection);
+                }
+                _gpuProfiler.BeginPass("Overdraw");
+                _deferredShader.BeginOverdrawPass();
+                _scene->RenderEntitiesToDepthPrepass(_deferredShader.GetOverdrawShader(), view, projection);
+                _deferredShader.EndOverdrawPass();
+                _gpuProfiler.EndPass();
+            }
+            else if (renderingPath == RenderingPath::FORWARD_PLUS)
+            {
+                // Forward+ - depth prepass first, then materials are shaded directly with per-tile light lists
+                _deferredShader.BindForwardPass(_controls->IsFog());
+                RenderDepthPrepass(view, projection);
+
+                _gpuProfiler.BeginPass(FORWARD_PASS_NAME);
+                _deferredShader.GetForwardPassShader()->Activate();
+                SetLightingShaderData(_deferredShader.GetForwardPassShader(), view, projection);
+                _scene->RenderEntitiesToGeometryPass(_deferredShader.GetForwardPassShader(), view, projection);
+                _deferredShader.EndGeometryPass();
+                _gpuProfiler.EndPass();
+                UpdateGeometryOverdraw(FORWARD_PASS_NAME);
+            }
+            else
+            {
+                _deferredShader.BindGBuffer();
+                if (renderingPath == RenderingPath::VISIBILITY_BUFFER)
+                {
+                    // Visibility buffer - rasterize ids only, then resolve them into gBuffer
+                    _gpuProfiler.BeginPass("Visibility buffer");
+                    _scene->CollectVisibilityDraws(_visibilityDraws);
+                    _deferredShader.RenderVisibilityBuffer(_visibilityDraws, view, projection);
+                    _gpuProfiler.EndPass();
+                }
+                else
+                {
+                    // Depth prepass - lay down depth first, so geometry pass shades every pixel only once
+                    if (_controls->IsDepthPrepass())
+                    {
+                        RenderDepthPrepass(view, projection);
+                    }
+
+                    // Geometry pass - render data into gBuffer
+                    _gpuProfiler.BeginPass(GEOMETRY_PASS_NAME);
+                    _deferredShader.GetGeometryPassShader()->Activate();
+                    _scene->RenderEntitiesToGeometryPass(_deferredShader.GetGeometryPassShader(), view, projection);
+                    _deferredShader.EndGeometryPass();
+                    _gpuProfiler.EndPass();
+                    UpdateGeometryOverdraw(GEOMETRY_PASS_NAME);
+                }
+
+                // Bind scene buffer - lighting writes its color without depth attached, as it samples gBuffer depth
+                _gpuProfiler.BeginPass("Lighting pass");
+                _deferredShader.BindSceneBuffer(_controls->IsFog());
 
-            // Render quad with proper lighting from previous step
-            _deferredShader.RenderQuad();
+                // Lighting pass - calculate lighting using data from geometry pass
+                _deferredShader.GetLightingPassShader()->Activate();
+                _deferredShader.BindGTextures();
+                SetLightingShaderData(_deferredShader.GetLightingPassShader(), view, projection);
+                _deferredShader.GetLightingPassShader()->SetUniform("inverseViewProjection", glm::inverse(projection * view));
+                _deferredShader.UpdateChangedSpotLights(_spotLights, _shadowAtlas);
 
-            // Copy depth buffer to be able to use forward rendering
-            _deferredShader.CopyDepthBufferToDefaultBuffer();
+                // Render quad with proper lighting from previous step
+                _deferredShader.RenderLightingPass(projection * view, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition());
+                _gpuProfiler.EndPass();
+            }
+
+            // Render additional effects using forward rendering - debug views show only counts
+            if (debugView == DebugView::NONE)
+            {
+                _gpuProfiler.BeginPass("Forward effects");
+                _scene->RenderPointLightsForwardRendering(view, projection, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition(), _controls->IsFog(), _controls->GetFogStrength(), _cameras[GetCameraId(_controls->GetCameraType())].GetFarZ());
+                _deferredShader.BeginBackgroundPass();
+                RenderSkybox(view, projection);
+                _deferredShader.EndBackgroundPass();
+                _gpuProfiler.EndPass();
+            }
 
-            // Render additional effects using forward rendering
-            _scene->RenderPointLightsForwardRendering(view, projection, _cameras[GetCameraId(_controls->GetCameraType())].GetPosition(), _controls->IsFog(), _controls->GetFogStrength(), _cameras[GetCameraId(_controls->GetCameraType())].GetFarZ());
-            RenderSkybox(view, projection);
+            // Present final image to default framebuffer
+            _gpuProfiler.BeginPass("Present");
+            _deferredShader.PresentSceneBuffer();
+            _gpuProfiler.EndPass();
+            _dynamicResolution.EndFrame();
+            _deferredShader.EndFrame();
+            _gpuProfiler.EndFrame();
+            _controls->UpdateProfilerStats(_gpuProfiler.GetPassStatistics(), _gpuProfiler.HasPipelineStatistics());
+            if (_controls->ConsumeBenchmarkExportRequest())
+            {
+                ExportBenchmark();
+            }
 
             _window.PollEvents();
 
@@ -105,8 +238,22 @@ namespace Renderer3D {
 
     void Renderer::ProcessWindowResize(const int width, const int height)
     {
+        _isResizePending = true;
+        _pendingWidth = width;
+        _pendingHeight = height;
+    }
+
+    void Renderer::ApplyPendingResize()
+    {
+        // Minimized window reports zero size - keep the previous targets until it's restored
+        if (!_isResizePending || _pendingWidth <= 0 || _pendingHeight <= 0)
+        {
+            return;
+        }
+        _isResizePending = false;
+        const auto width = _pendingWidth;
+        const auto height = _pendingHeight;
         spdlog::info("Window resized: {}x{}", width, height);
-        glViewport(0, 0, width, height);
         for (size_t i = 0; i < CAMERA_TYPE_COUNT; i++)
         {
             _cameras[i].UpdateProjectionType(_controls->GetProjectionType());
@@ -229,6 +376,45 @@ namespace Renderer3D {
         }
     }
 
+    void Renderer::RenderDepthPrepass(const glm::mat4& view, const glm::mat4& projection)
+    {
+        _gpuProfiler.BeginPass("Depth prepass");
+        _deferredShader.BeginDepthPrepass();
+        _scene->RenderEntitiesToDepthPrepass(_deferredShader.GetDepthPrepassShader(), view, projection);
+        _deferredShader.EndDepthPrepass();
+        _gpuProfiler.EndPass();
+    }
+
+    void Renderer::UpdateGeometryOverdraw(const std::string_view passName) const
+    {
+        // Results come a few frames late, so the pass may not be known yet right after switching paths
+        if (const auto pass = _gpuProfiler.FindPass(passName); pass != nullptr)
+        {
+            _controls->UpdateGeometryOverdraw(static_cast<float>(pass->SamplesPassed) / static_cast<float>(_deferredShader.GetRenderWidth() * _deferredShader.GetRenderHeight()));
+        }
+    }
+
+    void Renderer::ExportBenchmark() const
+    {
+        constexpr std::string_view renderingPathNames[] = { "G-buffer", "Visibility buffer", "Forward+" };
+        const auto renderingPath = renderingPathNames[static_cast<size_t>(_controls->GetRenderingPath())];
+        _gpuProfiler.ExportBenchmark(BENCHMARK_PATH, renderingPath, _deferredShader.GetRenderWidth(), _deferredShader.GetRenderHeight(), _dynamicResolution.GetGpuFrameTime());
+    }
+
+    void Renderer::SetLightingShaderData(const std::shared_ptr<Shader>& shader, const glm::mat4& view, const glm::mat4& projection) const
+    {
+        // Shared by deferred lighting pass and forward+ pass, shader must be active
+        const auto& camera = _cameras[GetCameraId(_controls->GetCameraType())];
+        _scene->SetLightingPassShaderData(shader, view, projection, camera.GetPosition(), _deferredShader.GetRenderWidth(), _deferredShader.GetRenderHeight(), _controls->GetLightTreeErrorBound(), _qualityGovernor.GetSettings().MaxLightsPerTile);
+        shader->SetUniform("cameraPos", camera.GetPosition());
+        DeferredShaderer::UpdateSceneMode(shader, _controls->GetSceneMode());
+        DeferredShaderer::UpdateFogStrength(shader, _controls->GetFogStrength(), camera.GetFarZ());
+        _spotLightsFactory.SetSpotLightsCountUniform(shader);
+        _cameras[GetCameraId(CameraType::MOVING)].SetFlashlightUniforms(shader);
+        _shadowAtlas.SetUniforms(shader);
+        _pointShadowMaps.SetUniforms(shader);
+    }
+
     void Renderer::UpdateUfoFlashlightDirection(const Entity& ufo) const
     {
         constexpr auto rotationAxisX = glm::vec3(1.0f, 0.0f, 0.0f);
@@ -313,11 +499,12 @@ namespace Renderer3D {
 
     void Renderer::SetupModelsForScene()
     {
-        _modelsManager->AddModel("ufo", std::make_shared<Model>("../assets/models/ufo/Low_poly_UFO.obj"));
-        _modelsManager->AddModel("cottage", std::make_shared<Model>("../assets/models/cottage/Cottage_FREE.obj"));
-        _modelsManager->AddModel("farmHouse", std::make_shared<Model>("../assets/models/farm_house/farmhouse_obj.obj"));
-        _modelsManager->AddModel("spaceship", std::make_shared<Model>("../assets/models/spaceship/Intergalactic_Spaceship-(Wavefront).obj"));
-        _modelsManager->AddModel("alienAnimal", std::make_shared<Model>("../assets/models/alien_animal/Alien Animal.obj"));
+        // All models are imported in parallel, so the first frame is rendered right away with placeholders
+        _modelsManager->LoadModelAsync("ufo", "../assets/models/ufo/Low_poly_UFO.obj");
+        _modelsManager->LoadModelAsync("cottage", "../assets/models/cottage/Cottage_FREE.obj");
+        _modelsManager->LoadModelAsync("farmHouse", "../assets/models/farm_house/farmhouse_obj.obj");
+        _modelsManager->LoadModelAsync("spaceship", "../assets/models/spaceship/Intergalactic_Spaceship-(Wavefront).obj");
+        _modelsManager->LoadModelAsync("alienAnimal", "../assets/models/alien_animal/Alien Animal.obj");
 
         Entity alienAnimal(_modelsManager->GetModel("alienAnimal"));
         alienAnimal.UpdatePosition(glm::vec3(0.0f, 0.0f, -10.0f));
@@ -639,8 +826,8 @@ namespace Renderer3D {
     void Renderer::SetupSkyboxesForScene() const
     {
         const auto& skyboxShader = std::make_shared<Shader>("../assets/shaders/skybox_vertex.glsl", "../assets/shaders/skybox_fragment.glsl");
-        _scene->UpdateNightSkybox(std::make_unique<Skybox>("../assets/cubemaps/night/px.jpg", "../assets/cubemaps/night/nx.jpg", "../assets/cubemaps/night/py.jpg", "../assets/cubemaps/night/ny.jpg", "../assets/cubemaps/night/pz.jpg", "../assets/cubemaps/night/nz.jpg", skyboxShader));
-        _scene->UpdateDaySkybox(std::make_unique<Skybox>("../assets/cubemaps/day/Daylight Box_Right.bmp", "../assets/cubemaps/day/Daylight Box_Left.bmp", "../assets/cubemaps/day/Daylight Box_Top.bmp", "../assets/cubemaps/day/Daylight Box_Bottom.bmp", "../assets/cubemaps/day/Daylight Box_Front.bmp", "../assets/cubemaps/day/Daylight Box_Back.bmp", skyboxShader));
+        _scene->UpdateNightSkybox(std::make_unique<Skybox>("../assets/cubemaps/night/px.jpg", "../assets/cubemaps/night/nx.jpg", "../assets/cubemaps/night/py.jpg", "../assets/cubemaps/night/ny.jpg", "../assets/cubemaps/night/pz.jpg", "../assets/cubemaps/night/nz.jpg", skyboxShader, *_textureCache));
+        _scene->UpdateDaySkybox(std::make_unique<Skybox>("../assets/cubemaps/day/Daylight Box_Right.bmp", "../assets/cubemaps/day/Daylight Box_Left.bmp", "../assets/cubemaps/day/Daylight Box_Top.bmp", "../assets/cubemaps/day/Daylight Box_Bottom.bmp", "../assets/cubemaps/day/Daylight Box_Front.bmp", "../assets/cubemaps/day/Daylight Box_Back.bmp", skyboxShader, *_textureCache));
     }
 
     void Renderer::SetupCameras()
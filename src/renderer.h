@@ -12,8 +12,14 @@
 #include "camera.h"
 #include "controls.h"
 #include "deferred_shaderer.h"
+#include "dynamic_resolution.h"
+#include "gpu_profiler.h"
+#include "point_shadow_maps.h"
+#include "shadow_atlas.h"
 #include "models_manager.h"
+#include "quality_governor.h"
 #include "scene.h"
+#include "texture_cache.h"
 
 namespace Renderer3D {
 
@@ -29,11 +35,17 @@ namespace Renderer3D {
         float _lastFrameTime = 0.0;
         float _deltaTime = 0.0;
         bool _firstMouseMove = true;
+        // Window resize events are only recorded and applied once per frame, so a window drag doesn't flood GPU with reallocations
+        bool _isResizePending = false;
+        int _pendingWidth = 0;
+        int _pendingHeight = 0;
         float _mouseXPos = Renderer::INITIAL_WIDTH / 2.0f;
         float _mouseYPos = Renderer::INITIAL_HEIGHT / 2.0f;
 
         // Objects
         Window _window;
+        // Shared by every model, the floor and skyboxes, so no image is decoded and uploaded twice
+        std::shared_ptr<TextureCache> _textureCache = std::make_shared<TextureCache>();
         Camera _cameras[CAMERA_TYPE_COUNT] = {
             Camera(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT),
             Camera(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT),
@@ -41,17 +53,30 @@ namespace Renderer3D {
             Camera(Renderer::INITIAL_WIDTH, Renderer::INITIAL_HEIGHT)
         };
         DeferredShaderer _deferredShader;
+        DynamicResolution _dynamicResolution;
+        QualityGovernor _qualityGovernor;
+        // Per pass GPU time and counters, samples passed of geometry pass compared with pixel count give overdraw
+        GpuProfiler _gpuProfiler;
+        std::vector<VisibilityDraw> _visibilityDraws;
+        ShadowAtlas _shadowAtlas;
+        std::vector<const SpotLightSource*> _spotLights;
+        PointShadowMaps _pointShadowMaps;
         SpotLightsFactory _spotLightsFactory = SpotLightsFactory();
         std::unique_ptr<Scene> _scene = nullptr;
         std::unique_ptr<Controls> _controls = nullptr;
-        std::unique_ptr<ModelsManager> _modelsManager = std::make_unique<ModelsManager>();
+        std::unique_ptr<ModelsManager> _modelsManager = std::make_unique<ModelsManager>(_textureCache);
 
         // Actions
         void ProcessWindowResize(int width, int height);
+        void ApplyPendingResize();
         void ProcessInput();
         void ProcessMouseMovement(double xPos, double yPos);
         void ProcessKeyCallback(int key, int action);
         void RenderSkybox(const glm::mat4& view, const glm::mat4& projection) const;
+        void RenderDepthPrepass(const glm::mat4& view, const glm::mat4& projection);
+        void UpdateGeometryOverdraw(std::string_view passName) const;
+        void ExportBenchmark() const;
+        void SetLightingShaderData(const std::shared_ptr<Shader>& shader, const glm::mat4& view, const glm::mat4& projection) const;
         void UpdateUfoFlashlightDirection(const Entity& ufo) const;
         static int GetCameraId(CameraType cameraType);
         void FollowEntity(const Entity& entity);
@@ -71,6 +96,11 @@ namespace Renderer3D {
         static constexpr size_t INITIAL_WIDTH = 1600;
         static constexpr size_t INITIAL_HEIGHT = 800;
         static constexpr size_t POINTS_LIGHTS_COUNT = 256;
+        static constexpr std::string_view GEOMETRY_PASS_NAME = "Geometry pass";
+        static constexpr std::string_view FORWARD_PASS_NAME = "Forward pass";
+        static constexpr std::string_view BENCHMARK_PATH = "benchmark.json";
+        // Time per frame spent uploading meshes of models loaded in the background, in milliseconds
+        static constexpr float MODEL_UPLOAD_BUDGET = 2.0f;
     };
 
 } // Renderer3D
@@ -10,7 +10,7 @@
 #include "scene.h"
 
 namespace Renderer3D {
-    Scene::Scene(std::unordered_map<std::string, Entity> entities, std::unique_ptr<PointLightsContainer> pointLightsContainer) : _entities(std::move(entities)), _pointLightsContainer(std::move(pointLightsContainer))
+    Scene::Scene(TextureCache& textureCache, std::unordered_map<std::string, Entity> entities, std::unique_ptr<PointLightsContainer> pointLightsContainer) : _entities(std::move(entities)), _pointLightsContainer(std::move(pointLightsContainer)), _floor(textureCache)
     {
     }
 
@@ -68,6 +68,93 @@ namespace Renderer3D {
         }
     }
 
+    bool Scene::SelectLods(const glm::mat4& projection, const glm::vec3& cameraPos, const size_t renderHeight, const float lodBias)
+    {
+        auto hasStaticLodChanged = false;
+        for (auto& [name, entity] : _entities)
+        {
+            const auto previousLod = entity.GetLod();
+            entity.SelectLod(projection, cameraPos, renderHeight, lodBias);
+            // Dynamic casters are drawn into shadow maps on every update anyway
+            hasStaticLodChanged |= entity.GetLod() != previousLod && !_updateEntityFunctions.contains(name);
+        }
+        return hasStaticLodChanged;
+    }
+
+    void Scene::RenderEntitiesToDepthPrepass(const std::shared_ptr<Shader>& depthPrepassShader, const glm::mat4& view, const glm::mat4& projection) const
+    {
+        depthPrepassShader->SetUniform("view", view);
+        depthPrepassShader->SetUniform("projection", projection);
+        _floor.DrawDepth(depthPrepassShader);
+        for (const auto& [_, entity] : _entities)
+        {
+            entity.DrawDepth(depthPrepassShader);
+        }
+    }
+
+    void Scene::CollectVisibilityDraws(std::vector<VisibilityDraw>& draws) const
+    {
+        draws.clear();
+        draws.push_back({_floor.GetGeometry(), _floor.GetModelMatrix(), [this](const std::shared_ptr<Shader>& shader) { _floor.BindMaterial(shader); }});
+        for (const auto& [_, entity] : _entities)
+        {
+            entity.CollectVisibilityDraws(draws);
+        }
+    }
+
+    void Scene::RequestTextures(TextureStreamer& textureStreamer) const
+    {
+        for (const auto& [_, entity] : _entities)
+        {
+            entity.RequestTextures(textureStreamer);
+        }
+    }
+
+    void Scene::CollectSpotLights(std::vector<const SpotLightSource*>& spotLights) const
+    {
+        for (const auto& [_, entity] : _entities)
+        {
+            if (const auto spotLight = entity.GetSpotLight(); spotLight != nullptr)
+            {
+                spotLights.push_back(spotLight.get());
+            }
+        }
+    }
+
+    void Scene::RenderEntitiesToShadowMap(const std::shared_ptr<Shader>& depthShader, const glm::mat4& lightViewProjection, const ShadowCasters casters, const SpotLightSource* light) const
+    {
+        depthShader->SetUniform("view", glm::mat4(1.0f));
+        depthShader->SetUniform("projection", lightViewProjection);
+        if (casters == ShadowCasters::STATIC)
+        {
+            _floor.DrawDepth(depthShader);
+        }
+        for (const auto& [name, entity] : _entities)
+        {
+            // Light is placed inside of its owner, which would otherwise block it completely
+            const auto isDynamic = _updateEntityFunctions.contains(name);
+            if (isDynamic == (casters == ShadowCasters::DYNAMIC) && entity.GetSpotLight().get() != light)
+            {
+                entity.DrawDepth(depthShader);
+            }
+        }
+    }
+
+    void Scene::RenderEntitiesToPointShadowMap(const std::shared_ptr<Shader>& depthShader) const
+    {
+        // Floor never stands between a point light and anything it lights, and its few big triangles
+        // don't survive paraboloid projection anyway, so only entities cast point light shadows
+        for (const auto& [_, entity] : _entities)
+        {
+            entity.DrawDepth(depthShader);
+        }
+    }
+
+    bool Scene::HasDynamicShadowCasters() const
+    {
+        return !_updateEntityFunctions.empty();
+    }
+
     void Scene::RenderEntitiesToGeometryPass(const std::shared_ptr<Shader>& geometryPassShader, const glm::mat4& view, const glm::mat4& projection) const
     {
         geometryPassShader->SetUniform("view", view);
@@ -79,9 +166,9 @@ namespace Renderer3D {
         }
     }
 
-    void Scene::SetLightingPassShaderData(const std::shared_ptr<Shader>& lightingPassShader) const
+    void Scene::SetLightingPassShaderData(const std::shared_ptr<Shader>& lightingPassShader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, const size_t width, const size_t height, const float lightTreeErrorBound, const size_t maxLightsPerTile) const
     {
-        _pointLightsContainer->SetLightingPassPointLightsData(lightingPassShader);
+        _pointLightsContainer->SetLightingPassPointLightsData(lightingPassShader, projection * view, cameraPos, width, height, lightTreeErrorBound, maxLightsPerTile);
         for (const auto& [_, entity] : _entities)
         {
             entity.SetSpotlightUniforms(lightingPassShader);
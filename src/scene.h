@@ -16,9 +16,16 @@
 namespace Renderer3D {
     using UpdateEntityFunctionType = std::function<void(Entity&,float)>;
 
+    // Entities with update functions may move every frame, everything else is static
+    enum class ShadowCasters
+    {
+        STATIC,
+        DYNAMIC
+    };
+
     class Scene {
     public:
-        explicit Scene(std::unordered_map<std::string, Entity> entities = std::unordered_map<std::string, Entity>(), std::unique_ptr<PointLightsContainer> pointLightsContainer = std::make_unique<PointLightsContainer>());
+        explicit Scene(TextureCache& textureCache, std::unordered_map<std::string, Entity> entities = std::unordered_map<std::string, Entity>(), std::unique_ptr<PointLightsContainer> pointLightsContainer = std::make_unique<PointLightsContainer>());
         void AddEntity(const std::string& name, const Entity& entity);
         void AddEntityUpdateFunction(const std::string& name, const UpdateEntityFunctionType& function);
         void UpdatePointLightContainer(std::unique_ptr<PointLightsContainer> pointLightsContainer);
@@ -26,8 +33,19 @@ namespace Renderer3D {
         void UpdateNightSkybox(std::unique_ptr<Skybox> skybox);
         void UpdateDaySkybox(std::unique_ptr<Skybox> skybox);
         void UpdateEntities(float deltaTime);
+        // Called after entities are updated, see Entity::SelectLod. Returns whether LOD of any static shadow caster
+        // changed - cached shadows drawn with the previous one would no longer match the receiver.
+        bool SelectLods(const glm::mat4& projection, const glm::vec3& cameraPos, size_t renderHeight, float lodBias);
+        void RenderEntitiesToDepthPrepass(const std::shared_ptr<Shader>& depthPrepassShader, const glm::mat4& view, const glm::mat4& projection) const;
+        void CollectVisibilityDraws(std::vector<VisibilityDraw>& draws) const;
+        // Floor and skyboxes are always fully resident, so only entities request their textures
+        void RequestTextures(TextureStreamer& textureStreamer) const;
+        void CollectSpotLights(std::vector<const SpotLightSource*>& spotLights) const;
+        void RenderEntitiesToShadowMap(const std::shared_ptr<Shader>& depthShader, const glm::mat4& lightViewProjection, ShadowCasters casters, const SpotLightSource* light) const;
+        void RenderEntitiesToPointShadowMap(const std::shared_ptr<Shader>& depthShader) const;
+        [[nodiscard]] bool HasDynamicShadowCasters() const;
         void RenderEntitiesToGeometryPass(const std::shared_ptr<Shader>& geometryPassShader, const glm::mat4& view, const glm::mat4& projection) const;
-        void SetLightingPassShaderData(const std::shared_ptr<Shader>& lightingPassShader) const;
+        void SetLightingPassShaderData(const std::shared_ptr<Shader>& lightingPassShader, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, size_t width, size_t height, float lightTreeErrorBound, size_t maxLightsPerTile) const;
         void RenderPointLightsForwardRendering(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, bool useFog, float fogStrength, float cameraFarZ) const;
         void RenderNightSkyboxForwardRendering(const glm::mat4& view, const glm::mat4& projection) const;
         void RenderDaySkyboxForwardRendering(const glm::mat4& view, const glm::mat4& projection) const;
@@ -159,14 +159,33 @@ namespace Renderer3D {
         glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
     }
 
-    std::string Shader::LoadShaderSource(const fs::path& path)
+    std::string Shader::LoadShaderSource(const fs::path& path) // NOLINT(*-no-recursion)
     {
         std::ifstream file;
         file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
         file.open(path.string());
         std::stringstream buffer;
         buffer << file.rdbuf();
-        return buffer.str();
+
+        // Code shared between shaders is pasted in place of #include "path" lines, path is relative to current file
+        std::stringstream source;
+        std::string line;
+        while (std::getline(buffer, line))
+        {
+            if (line.rfind(INCLUDE_DIRECTIVE, 0) == 0)
+            {
+                const auto begin = line.find('"');
+                const auto end = line.rfind('"');
+                if (begin != std::string::npos && end > begin)
+                {
+                    source << LoadShaderSource(path.parent_path() / line.substr(begin + 1, end - begin - 1)) << '\n';
+                    continue;
+                }
+                spdlog::error("Invalid include in shader (path: {}): {}", path.string(), line);
+            }
+            source << line << '\n';
+        }
+        return source.str();
     }
 
     void Shader::CheckShaderCompilationResult(const GLuint shaderId, const fs::path& path)
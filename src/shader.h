@@ -34,10 +34,11 @@ namespace Renderer3D {
         GLuint _programID;
         bool _isMoved = false;
         // Helpers
-        static std::string LoadShaderSource(const fs::path& path);
+        static std::string LoadShaderSource(const fs::path& path); // NOLINT(*-no-recursion)
         static void CheckShaderCompilationResult(GLuint shaderId, const fs::path& path);
         static void CheckProgramLinkingResult(GLuint programId, const fs::path& vertexPath, const fs::path& fragmentPath);
         static constexpr size_t LOG_BUFFER_SIZE = 1024;
+        static constexpr auto INCLUDE_DIRECTIVE = "#include";
     };
 
 } // Renderer3D
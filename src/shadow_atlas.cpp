@@ -0,0 +1,417 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <spdlog/spdlog.h>
+
+#include "shadow_atlas.h"
+
+namespace Renderer3D {
+    ShadowAtlas::ShadowAtlas()
+    {
+        _allocatedNodes.resize(MAX_TILE_LEVEL + 1);
+        for (int level = 0; level <= MAX_TILE_LEVEL; level++)
+        {
+            _allocatedNodes[level].assign(static_cast<size_t>(1) << (2 * level), false);
+        }
+
+        // Static cache is only copied from, atlas is sampled with hardware depth comparison
+        _staticTexture = CreateDepthTexture(false);
+        _atlasTexture = CreateDepthTexture(true);
+        glGenFramebuffers(1, &_staticFramebuffer);
+        glGenFramebuffers(1, &_atlasFramebuffer);
+        for (const auto& [framebuffer, texture] : {std::pair{_staticFramebuffer, _staticTexture}, std::pair{_atlasFramebuffer, _atlasTexture}})
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                spdlog::error("Failed to create shadow atlas framebuffer!");
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    ShadowAtlas::ShadowAtlas(ShadowAtlas&& shadowAtlas) noexcept
+    {
+        shadowAtlas._isMoved = true;
+        _tiles = shadowAtlas._tiles;
+        _allocatedNodes = std::move(shadowAtlas._allocatedNodes);
+        _staticTexture = shadowAtlas._staticTexture;
+        _atlasTexture = shadowAtlas._atlasTexture;
+        _staticFramebuffer = shadowAtlas._staticFramebuffer;
+        _atlasFramebuffer = shadowAtlas._atlasFramebuffer;
+        _updatedTilesCount = shadowAtlas._updatedTilesCount;
+        _staticRendersCount = shadowAtlas._staticRendersCount;
+    }
+
+    void ShadowAtlas::Update(const bool enabled, const std::vector<const SpotLightSource*>& spotLights, const Scene& scene, const std::shared_ptr<Shader>& depthShader, const glm::mat4& cameraViewProjection, const size_t updateBudget)
+    {
+        _updatedTilesCount = 0;
+        _staticRendersCount = 0;
+        for (auto& tile : _tiles)
+        {
+            tile.IsUpdated = false;
+        }
+        std::array<const SpotLightSource*, MAX_NR_SPOT_LIGHTS> lights = {};
+        if (enabled)
+        {
+            for (const auto spotLight : spotLights)
+            {
+                if (spotLight->IsActive() && spotLight->GetId() < MAX_NR_SPOT_LIGHTS)
+                {
+                    lights[spotLight->GetId()] = spotLight;
+                    _tiles[spotLight->GetId()].Importance = CalculateImportance(*spotLight, cameraViewProjection);
+                }
+            }
+        }
+        AllocateTiles(lights);
+
+        // Empty tiles go first, the rest is ordered by importance and time since last update
+        const auto hasDynamicCasters = scene.HasDynamicShadowCasters();
+        std::vector<std::pair<float, size_t>> candidates;
+        for (size_t id = 0; id < MAX_NR_SPOT_LIGHTS; id++)
+        {
+            auto& tile = _tiles[id];
+            if (tile.Level == -1)
+            {
+                continue;
+            }
+            tile.FramesSinceUpdate++;
+            const auto hasMoved = HasMoved(tile.ViewProjection, lights[id]->CalculateViewProjection());
+            if (tile.HasContent && tile.IsStaticValid && !hasMoved && !hasDynamicCasters)
+            {
+                continue;
+            }
+            const auto priority = tile.HasContent ? tile.Importance * static_cast<float>(tile.FramesSinceUpdate) : std::numeric_limits<float>::max();
+            candidates.emplace_back(priority, id);
+        }
+        if (candidates.empty())
+        {
+            return;
+        }
+        std::ranges::sort(candidates, std::greater());
+        candidates.resize(std::min(candidates.size(), updateBudget));
+
+        glBindVertexArray(0);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_SCISSOR_TEST);
+        // Slope scaled offset removes most of shadow acne, shader adds only a tiny constant bias
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(POLYGON_OFFSET_FACTOR, POLYGON_OFFSET_UNITS);
+        depthShader->Activate();
+        for (const auto& [_, id] : candidates)
+        {
+            RenderTile(_tiles[id], *lights[id], scene, depthShader, hasDynamicCasters);
+        }
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_SCISSOR_TEST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void ShadowAtlas::SetUniforms(const std::shared_ptr<Shader>& shader) const
+    {
+        shader->SetUniform("spotShadowAtlas", ATLAS_TEXTURE_UNIT);
+        glActiveTexture(GL_TEXTURE0 + ATLAS_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, _atlasTexture);
+        glActiveTexture(GL_TEXTURE0);
+        for (size_t id = 0; id < MAX_NR_SPOT_LIGHTS; id++)
+        {
+            const auto& tile = _tiles[id];
+            const auto name = std::format("spotLights[{}]", id);
+            const auto hasShadow = tile.Level != -1 && tile.HasContent;
+            shader->SetUniform(std::format("{}.hasShadow", name), hasShadow);
+            if (hasShadow)
+            {
+                shader->SetUniform(std::format("{}.shadowMatrix", name), GetShadowMatrix(tile));
+            }
+        }
+    }
+
+    size_t ShadowAtlas::GetUpdatedTilesCount() const
+    {
+        return _updatedTilesCount;
+    }
+
+    size_t ShadowAtlas::GetStaticRendersCount() const
+    {
+        return _staticRendersCount;
+    }
+
+    bool ShadowAtlas::IsTileUpdated(const size_t lightId) const
+    {
+        return lightId < MAX_NR_SPOT_LIGHTS && _tiles[lightId].IsUpdated;
+    }
+
+    void ShadowAtlas::InvalidateStaticCasters()
+    {
+        for (auto& tile : _tiles)
+        {
+            tile.IsStaticValid = false;
+        }
+    }
+
+    ShadowAtlas::~ShadowAtlas()
+    {
+        if (_isMoved)
+        {
+            return;
+        }
+        glDeleteFramebuffers(1, &_staticFramebuffer);
+        glDeleteFramebuffers(1, &_atlasFramebuffer);
+        glDeleteTextures(1, &_staticTexture);
+        glDeleteTextures(1, &_atlasTexture);
+    }
+
+    void ShadowAtlas::AllocateTiles(const std::array<const SpotLightSource*, MAX_NR_SPOT_LIGHTS>& lights)
+    {
+        std::vector<size_t> order;
+        for (size_t id = 0; id < MAX_NR_SPOT_LIGHTS; id++)
+        {
+            if (lights[id] == nullptr)
+            {
+                FreeNode(_tiles[id]);
+                _tiles[id].DesiredLevel = -1;
+                continue;
+            }
+            order.push_back(id);
+        }
+        // The most important lights get the first pick of big tiles
+        std::ranges::sort(order, [this](const size_t a, const size_t b)
+        {
+            return _tiles[a].Importance > _tiles[b].Importance;
+        });
+
+        // Tiles are reallocated only when desired size changes, so cached content survives small importance changes
+        for (const auto id : order)
+        {
+            auto& tile = _tiles[id];
+            if (const auto desiredLevel = GetDesiredLevel(tile.Importance); desiredLevel != tile.DesiredLevel)
+            {
+                FreeNode(tile);
+                tile.DesiredLevel = desiredLevel;
+            }
+        }
+        for (const auto id : order)
+        {
+            auto& tile = _tiles[id];
+            if (tile.Level != -1 || tile.DesiredLevel == -1)
+            {
+                continue;
+            }
+            // Fall back to smaller tiles when atlas is full
+            for (int level = tile.DesiredLevel; level <= MAX_TILE_LEVEL; level++)
+            {
+                if (AllocateNode(tile, level))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    bool ShadowAtlas::AllocateNode(ShadowTile& tile, const int level)
+    {
+        const auto nodesCount = static_cast<int>(_allocatedNodes[level].size());
+        for (int index = 0; index < nodesCount; index++)
+        {
+            if (IsNodeFree(level, index))
+            {
+                _allocatedNodes[level][index] = true;
+                tile.Level = level;
+                tile.Index = index;
+                tile.HasContent = false;
+                tile.IsStaticValid = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ShadowAtlas::FreeNode(ShadowTile& tile)
+    {
+        if (tile.Level != -1)
+        {
+            _allocatedNodes[tile.Level][tile.Index] = false;
+        }
+        tile.Level = -1;
+        tile.Index = -1;
+        tile.HasContent = false;
+        tile.IsStaticValid = false;
+    }
+
+    bool ShadowAtlas::IsNodeFree(const int level, const int index) const
+    {
+        const auto x = index % (1 << level);
+        const auto y = index / (1 << level);
+        // Node is free only if none of its ancestors and descendants is allocated
+        for (int ancestorLevel = 0; ancestorLevel <= level; ancestorLevel++)
+        {
+            const auto shift = level - ancestorLevel;
+            if (_allocatedNodes[ancestorLevel][(y >> shift) * (1 << ancestorLevel) + (x >> shift)])
+            {
+                return false;
+            }
+        }
+        for (int descendantLevel = level + 1; descendantLevel <= MAX_TILE_LEVEL; descendantLevel++)
+        {
+            const auto shift = descendantLevel - level;
+            const auto rowSize = 1 << descendantLevel;
+            for (int dy = 0; dy < 1 << shift; dy++)
+            {
+                for (int dx = 0; dx < 1 << shift; dx++)
+                {
+                    if (_allocatedNodes[descendantLevel][((y << shift) + dy) * rowSize + (x << shift) + dx])
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    void ShadowAtlas::RenderTile(ShadowTile& tile, const SpotLightSource& spotLight, const Scene& scene, const std::shared_ptr<Shader>& depthShader, const bool hasDynamicCasters)
+    {
+        const auto rect = GetTileRect(tile);
+        glViewport(rect.x, rect.y, rect.z, rect.z);
+        glScissor(rect.x, rect.y, rect.z, rect.z);
+
+        const auto viewProjection = spotLight.CalculateViewProjection();
+        if (!tile.IsStaticValid || HasMoved(tile.ViewProjection, viewProjection))
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, _staticFramebuffer);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            scene.RenderEntitiesToShadowMap(depthShader, viewProjection, ShadowCasters::STATIC, &spotLight);
+            tile.ViewProjection = viewProjection;
+            tile.IsStaticValid = true;
+            _staticRendersCount++;
+        }
+
+        // Tile starts as a copy of static cache, dynamic casters are drawn over it
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _staticFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _atlasFramebuffer);
+        glBlitFramebuffer(rect.x, rect.y, rect.x + rect.z, rect.y + rect.z, rect.x, rect.y, rect.x + rect.z, rect.y + rect.z, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, _atlasFramebuffer);
+        if (hasDynamicCasters)
+        {
+            scene.RenderEntitiesToShadowMap(depthShader, tile.ViewProjection, ShadowCasters::DYNAMIC, &spotLight);
+        }
+        tile.HasContent = true;
+        tile.IsUpdated = true;
+        tile.FramesSinceUpdate = 0;
+        _updatedTilesCount++;
+    }
+
+    glm::ivec3 ShadowAtlas::GetTileRect(const ShadowTile& tile) const
+    {
+        const auto size = ATLAS_SIZE >> tile.Level;
+        const auto nodesPerRow = 1 << tile.Level;
+        return {(tile.Index % nodesPerRow) * size, (tile.Index / nodesPerRow) * size, size};
+    }
+
+    glm::mat4 ShadowAtlas::GetShadowMatrix(const ShadowTile& tile) const
+    {
+        // Maps light clip space into the tile, depth into [0, 1]
+        const auto rect = GetTileRect(tile);
+        const auto scale = static_cast<float>(rect.z) / static_cast<float>(ATLAS_SIZE);
+        const auto offset = glm::vec2(rect.x, rect.y) / static_cast<float>(ATLAS_SIZE);
+        const auto tileMatrix = glm::mat4(
+            glm::vec4(0.5f * scale, 0.0f, 0.0f, 0.0f),
+            glm::vec4(0.0f, 0.5f * scale, 0.0f, 0.0f),
+            glm::vec4(0.0f, 0.0f, 0.5f, 0.0f),
+            glm::vec4(offset.x + 0.5f * scale, offset.y + 0.5f * scale, 0.5f, 1.0f)
+        );
+        return tileMatrix * tile.ViewProjection;
+    }
+
+    GLuint ShadowAtlas::CreateDepthTexture(const bool compare)
+    {
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, ATLAS_SIZE, ATLAS_SIZE, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (compare)
+        {
+            // Linear filtering with comparison gives 2x2 PCF for free on most hardware
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        else
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return texture;
+    }
+
+    float ShadowAtlas::CalculateImportance(const SpotLightSource& spotLight, const glm::mat4& cameraViewProjection)
+    {
+        // Importance is the part of the screen covered by bounds of the light cone
+        const auto range = spotLight.GetRange();
+        const auto direction = glm::normalize(spotLight.GetDirection());
+        const auto coneRadius = range * std::tan(std::acos(spotLight.GetOuterCutOff()));
+        const auto center = spotLight.GetPosition() + direction * (range * 0.5f);
+        const auto radius = std::sqrt(range * range * 0.25f + coneRadius * coneRadius);
+
+        auto ndcMin = glm::vec2(std::numeric_limits<float>::max());
+        auto ndcMax = glm::vec2(std::numeric_limits<float>::lowest());
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const auto offset = glm::vec3(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius, corner & 4 ? radius : -radius);
+            const auto clip = cameraViewProjection * glm::vec4(center + offset, 1.0f);
+            // Camera is inside or right next to the light bounds
+            if (clip.w <= 0.0f)
+            {
+                return 1.0f;
+            }
+            const auto ndc = glm::vec2(clip.x, clip.y) / clip.w;
+            ndcMin = glm::min(ndcMin, ndc);
+            ndcMax = glm::max(ndcMax, ndc);
+        }
+        ndcMin = glm::clamp(ndcMin, glm::vec2(-1.0f), glm::vec2(1.0f));
+        ndcMax = glm::clamp(ndcMax, glm::vec2(-1.0f), glm::vec2(1.0f));
+        const auto size = glm::max(ndcMax - ndcMin, glm::vec2(0.0f));
+        return size.x * size.y * 0.25f;
+    }
+
+    int ShadowAtlas::GetDesiredLevel(const float importance)
+    {
+        if (importance <= 0.0f)
+        {
+            return -1;
+        }
+        for (int i = 0; i < static_cast<int>(std::size(LEVEL_IMPORTANCE)); i++)
+        {
+            if (importance >= LEVEL_IMPORTANCE[i])
+            {
+                return MIN_TILE_LEVEL + i;
+            }
+        }
+        return MAX_TILE_LEVEL;
+    }
+
+    bool ShadowAtlas::HasMoved(const glm::mat4& previous, const glm::mat4& current)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            const auto difference = glm::abs(previous[column] - current[column]);
+            if (glm::max(glm::max(difference.x, difference.y), glm::max(difference.z, difference.w)) > MOVE_EPSILON)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+} // Renderer3D
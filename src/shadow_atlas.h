@@ -0,0 +1,96 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "shader.h"
+#include "spot_light_source.h"
+
+namespace Renderer3D {
+
+    // Shadow maps of all spotlights packed into a single depth texture. Tile size of every light follows its
+    // screen space importance. Static casters are rendered into a separate cache, which is redrawn only when
+    // the light moves - otherwise a tile update is just a copy of the cache plus dynamic casters on top.
+    class ShadowAtlas {
+    public:
+        ShadowAtlas();
+        ShadowAtlas(const ShadowAtlas&) = delete;
+        ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+        ShadowAtlas(ShadowAtlas&& shadowAtlas) noexcept;
+        void Update(bool enabled, const std::vector<const SpotLightSource*>& spotLights, const Scene& scene, const std::shared_ptr<Shader>& depthShader, const glm::mat4& cameraViewProjection, size_t updateBudget);
+        void SetUniforms(const std::shared_ptr<Shader>& shader) const;
+        [[nodiscard]] size_t GetUpdatedTilesCount() const;
+        [[nodiscard]] size_t GetStaticRendersCount() const;
+        // Whether shadow of the light was redrawn by the last Update
+        [[nodiscard]] bool IsTileUpdated(size_t lightId) const;
+        // Static cache of every tile is redrawn on its next update, e.g. after a model finished loading
+        void InvalidateStaticCasters();
+        ~ShadowAtlas();
+    private:
+        struct ShadowTile
+        {
+            // Node of the atlas quadtree, -1 when light has no tile
+            int Level = -1;
+            int Index = -1;
+            int DesiredLevel = -1;
+            float Importance = 0.0f;
+            // Matrix the tile content was rendered with - it is used for sampling until the tile is updated
+            glm::mat4 ViewProjection = glm::mat4(1.0f);
+            bool HasContent = false;
+            bool IsStaticValid = false;
+            bool IsUpdated = false;
+            size_t FramesSinceUpdate = 0;
+        };
+        // Consts
+        // IMPORTANT: this value must match MAX_NR_SPOT_LIGHTS in SpotLightsFactory and shaders
+        static constexpr size_t MAX_NR_SPOT_LIGHTS = 16;
+
+        std::array<ShadowTile, MAX_NR_SPOT_LIGHTS> _tiles;
+        // Allocated nodes of every quadtree level, level 0 is the whole atlas
+        std::vector<std::vector<bool>> _allocatedNodes;
+        GLuint _staticTexture = 0;
+        GLuint _atlasTexture = 0;
+        GLuint _staticFramebuffer = 0;
+        GLuint _atlasFramebuffer = 0;
+        size_t _updatedTilesCount = 0;
+        size_t _staticRendersCount = 0;
+        bool _isMoved = false;
+
+        // Helpers
+        void AllocateTiles(const std::array<const SpotLightSource*, MAX_NR_SPOT_LIGHTS>& lights);
+        bool AllocateNode(ShadowTile& tile, int level);
+        void FreeNode(ShadowTile& tile);
+        [[nodiscard]] bool IsNodeFree(int level, int index) const;
+        void RenderTile(ShadowTile& tile, const SpotLightSource& spotLight, const Scene& scene, const std::shared_ptr<Shader>& depthShader, bool hasDynamicCasters);
+        [[nodiscard]] glm::ivec3 GetTileRect(const ShadowTile& tile) const;
+        [[nodiscard]] glm::mat4 GetShadowMatrix(const ShadowTile& tile) const;
+        static GLuint CreateDepthTexture(bool compare);
+        static float CalculateImportance(const SpotLightSource& spotLight, const glm::mat4& cameraViewProjection);
+        static int GetDesiredLevel(float importance);
+        static bool HasMoved(const glm::mat4& previous, const glm::mat4& current);
+
+        // IMPORTANT: this value must match SHADOW_ATLAS_SIZE in shaders
+        static constexpr int ATLAS_SIZE = 2048;
+        // Level 1 tiles are 1024 pixels wide, every next level halves it
+        static constexpr int MIN_TILE_LEVEL = 1;
+        static constexpr int MAX_TILE_LEVEL = 4;
+        // Screen coverage needed for each tile level, from the biggest one
+        static constexpr float LEVEL_IMPORTANCE[] = {0.25f, 0.06f, 0.015f};
+        static constexpr float MOVE_EPSILON = 0.0001f;
+        static constexpr float POLYGON_OFFSET_FACTOR = 2.0f;
+        static constexpr float POLYGON_OFFSET_UNITS = 4.0f;
+        static constexpr int ATLAS_TEXTURE_UNIT = 12;
+    };
+
+} // Renderer3D
+
+#endif //SHADOW_ATLAS_H
@@ -2,24 +2,20 @@
 // Created by Kacper Trzciński on 19.01.2025.
 //
 
-#include <stb_image/stb_image.h>
-#include <spdlog/spdlog.h>
-
 #include "skybox.h"
 
 namespace Renderer3D {
     Skybox::Skybox(const fs::path& right, const fs::path& left, const fs::path& top, const fs::path& bottom,
-        const fs::path& front, const fs::path& back, const std::shared_ptr<Shader>& shader) : _shader(shader)
+        const fs::path& front, const fs::path& back, const std::shared_ptr<Shader>& shader, TextureCache& textureCache) : _shader(shader)
     {
-        const fs::path faces[] = {right, left, top, bottom, front, back};
-        LoadCubemap(faces);
+        _cubemap = textureCache.AcquireCubemap({right, left, top, bottom, front, back});
         GenerateBuffers();
     }
 
     Skybox::Skybox(Skybox&& other) noexcept
     {
         other._isMoved = true;
-        _cubemapID = other._cubemapID;
+        _cubemap = std::move(other._cubemap);
         _vaoID = other._vaoID;
         _vboID = other._vboID;
         _eboID = other._eboID;
@@ -32,10 +28,6 @@ namespace Renderer3D {
         {
             return;
         }
-        if (_cubemapID != 0)
-        {
-            glDeleteTextures(1, &_cubemapID);
-        }
         if (_vaoID != 0)
         {
             glDeleteVertexArrays(1, &_vaoID);
@@ -65,7 +57,7 @@ namespace Renderer3D {
         // Render
         glBindVertexArray(_vaoID);
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, _cubemapID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, _cubemap->GetId());
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, nullptr);
         // Cleanup
         glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
@@ -73,57 +65,6 @@ namespace Renderer3D {
         glDepthFunc(GL_LESS);
     }
 
-    void Skybox::LoadCubemap(const fs::path faces[6])
-    {
-        glGenTextures(1, &_cubemapID);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, _cubemapID);
-
-        int width, height, nrComponents;
-
-        for (size_t i = 0; i < 6; i++)
-        {
-            // ReSharper disable once CppTooWideScope
-            const auto data = stbi_load(faces[i].string().c_str(), &width, &height, &nrComponents, 0);
-            if (data)
-            {
-                GLenum format;
-                switch (nrComponents)
-                {
-                case 1:
-                    format = GL_RED;
-                    break;
-                case 3:
-                    format = GL_RGB;
-                    break;
-                case 4:
-                    format = GL_RGBA;
-                    break;
-                default:
-                    spdlog::error("Texture format not supported (invalid number of components: {})", nrComponents);
-                    stbi_image_free(data);
-                    glDeleteTextures(1, &_cubemapID);
-                    return;
-                }
-
-                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, static_cast<GLint>(format), width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-                stbi_image_free(data);
-            }
-            else
-            {
-                spdlog::error("Failed to load cubemap {}", faces[i].string());
-            }
-        }
-
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-        // Cleanup
-        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    }
-
     void Skybox::GenerateBuffers()
     {
         // Generate buffers
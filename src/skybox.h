@@ -10,6 +10,8 @@
 #include <glm/glm.hpp>
 
 #include "shader.h"
+#include "texture.h"
+#include "texture_cache.h"
 
 namespace fs = std::filesystem;
 
@@ -18,12 +20,12 @@ namespace Renderer3D {
     class Skybox {
     public:
         Skybox(const fs::path& right, const fs::path& left, const fs::path& top, const fs::path& bottom,
-        const fs::path& front, const fs::path& back, const std::shared_ptr<Shader>& shader);
+        const fs::path& front, const fs::path& back, const std::shared_ptr<Shader>& shader, TextureCache& textureCache);
         Skybox(Skybox&& other) noexcept;
         ~Skybox();
         void Draw(const glm::mat4& view, const glm::mat4& projection) const;
     private:
-        GLuint _cubemapID = 0;
+        std::shared_ptr<Texture> _cubemap = nullptr;
         GLuint _vaoID = 0;
         GLuint _vboID = 0;
         GLuint _eboID = 0;
@@ -31,7 +33,6 @@ namespace Renderer3D {
         bool _isMoved = false;
 
         // Helpers
-        void LoadCubemap(const fs::path faces[6]);
         void GenerateBuffers();
 
         // Consts
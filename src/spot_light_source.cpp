@@ -3,8 +3,10 @@
 //
 
 #include <format>
+#include <glm/gtc/matrix_transform.hpp>
 
 #include "spot_light_source.h"
+#include "point_light_source.h"
 
 #include "spdlog/spdlog.h"
 
@@ -52,4 +54,44 @@ namespace Renderer3D {
         shader->SetUniform(std::format("{}.linear", name), _linear);
         shader->SetUniform(std::format("{}.quadratic", name), _quadratic);
     }
+
+    size_t SpotLightSource::GetId() const
+    {
+        return _ID;
+    }
+
+    bool SpotLightSource::IsActive() const
+    {
+        return _shouldUse;
+    }
+
+    glm::vec3 SpotLightSource::GetPosition() const
+    {
+        return _position;
+    }
+
+    glm::vec3 SpotLightSource::GetDirection() const
+    {
+        return _direction;
+    }
+
+    float SpotLightSource::GetOuterCutOff() const
+    {
+        return _outerCutOff;
+    }
+
+    float SpotLightSource::GetRange() const
+    {
+        return PointLightSource::CalculateRadius(COLOR, _linear, _quadratic);
+    }
+
+    glm::mat4 SpotLightSource::CalculateViewProjection() const
+    {
+        // Frustum covers the whole outer cone up to the distance where light fades out
+        const auto direction = glm::normalize(_direction);
+        const auto up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const auto view = glm::lookAt(_position, _position + direction, up);
+        const auto projection = glm::perspective(2.0f * std::acos(_outerCutOff), 1.0f, SHADOW_NEAR_PLANE, GetRange());
+        return projection * view;
+    }
 } // Renderer3D
\ No newline at end of file
@@ -22,6 +22,13 @@ namespace Renderer3D {
         void Activate();
         void Deactivate();
         void SetUniforms(const std::shared_ptr<Shader>& shader) const;
+        [[nodiscard]] size_t GetId() const;
+        [[nodiscard]] bool IsActive() const;
+        [[nodiscard]] glm::vec3 GetPosition() const;
+        [[nodiscard]] glm::vec3 GetDirection() const;
+        [[nodiscard]] float GetOuterCutOff() const;
+        [[nodiscard]] float GetRange() const;
+        [[nodiscard]] glm::mat4 CalculateViewProjection() const;
     private:
         glm::vec3 _position;
         glm::vec3 _direction;
@@ -37,6 +44,9 @@ namespace Renderer3D {
         // Const
         static constexpr float DEFAULT_LINEAR = 0.09f;
         static constexpr float DEFAULT_QUADRATIC = 0.032;
+        // IMPORTANT: this value must match SPOTLIGHT_COLOR in shaders
+        static constexpr glm::vec3 COLOR = glm::vec3(1.0f, 1.0f, 1.0f);
+        static constexpr float SHADOW_NEAR_PLANE = 0.05f;
     };
 
 } // Renderer3D
@@ -2,10 +2,13 @@
 // Created by Kacper Trzciński on 13.01.2025.
 //
 
+#include <algorithm>
 #include <cstdint>
 #include <stb_image/stb_image.h>
 #include <spdlog/spdlog.h>
 
+#include "gl_extensions.h"
+#include "mip_chain.h"
 #include "texture.h"
 
 namespace Renderer3D {
@@ -35,32 +38,55 @@ namespace Renderer3D {
         }
     }
 
-    Texture::Texture(const fs::path& texturePath, const TextureType type)
+    std::optional<GLenum> textureFormatFromComponents(const int components)
+    {
+        switch (components)
+        {
+        case 1:
+            return GL_RED;
+        case 3:
+            return GL_RGB;
+        case 4:
+            return GL_RGBA;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    Texture::Texture(const fs::path& texturePath, const TextureType type, const TextureLoadMode loadMode, const bool flipVertically)
     {
         _type = type;
         _texturePath = texturePath;
+        _loadMode = loadMode;
+        _isFlipped = flipVertically;
         _textureID = 0;
         glGenTextures(1, &_textureID);
 
+        if (loadMode == TextureLoadMode::DEFERRED)
+        {
+            // Only the base level exists until the loader uploads the mip tail, so the texture stays complete
+            glBindTexture(GL_TEXTURE_2D, _textureID);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_TEXEL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+            SetSamplingParameters();
+            return;
+        }
+
+        if (LoadBaked(texturePath, flipVertically))
+        {
+            return;
+        }
+
         int width, height, nrComponents;
 
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
         uint8_t* data = stbi_load(texturePath.string().c_str(), &width, &height, &nrComponents, 0);
 
         if (data)
         {
-            GLenum format;
-            switch (nrComponents)
+            const auto format = textureFormatFromComponents(nrComponents);
+            if (!format)
             {
-            case 1:
-                format = GL_RED;
-                break;
-            case 3:
-                format = GL_RGB;
-                break;
-            case 4:
-                format = GL_RGBA;
-                break;
-            default:
                 spdlog::error("Texture format not supported (invalid number of components: {})", nrComponents);
                 stbi_image_free(data);
                 glDeleteTextures(1, &_textureID);
@@ -68,13 +94,9 @@ namespace Renderer3D {
             }
 
             glBindTexture(GL_TEXTURE_2D, _textureID);
-            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(*format), width, height, 0, *format, GL_UNSIGNED_BYTE, data);
             glGenerateMipmap(GL_TEXTURE_2D);
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            SetSamplingParameters();
         }
         else
         {
@@ -84,12 +106,69 @@ namespace Renderer3D {
         stbi_image_free(data);
     }
 
+    Texture::Texture(const std::array<fs::path, 6>& faces)
+    {
+        _type = TextureType::DIFFUSE;
+        _texturePath = faces[0];
+        _target = GL_TEXTURE_CUBE_MAP;
+        _textureID = 0;
+        glGenTextures(1, &_textureID);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, _textureID);
+
+        int width, height, nrComponents;
+
+        // Cube map faces are never flipped, whatever the last texture loaded on this thread asked for
+        stbi_set_flip_vertically_on_load_thread(false);
+        for (size_t i = 0; i < faces.size(); i++)
+        {
+            // ReSharper disable once CppTooWideScope
+            const auto data = stbi_load(faces[i].string().c_str(), &width, &height, &nrComponents, 0);
+            if (data)
+            {
+                const auto format = textureFormatFromComponents(nrComponents);
+                if (!format)
+                {
+                    spdlog::error("Texture format not supported (invalid number of components: {})", nrComponents);
+                    stbi_image_free(data);
+                    glDeleteTextures(1, &_textureID);
+                    _textureID = 0;
+                    return;
+                }
+
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, static_cast<GLint>(*format), width, height, 0, *format, GL_UNSIGNED_BYTE, data);
+                stbi_image_free(data);
+            }
+            else
+            {
+                spdlog::error("Failed to load cubemap {}", faces[i].string());
+            }
+        }
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+        // Cleanup
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    }
+
     Texture::Texture(Texture&& texture) noexcept
     {
         texture._isMoved = true;
         _textureID = texture._textureID;
+        _target = texture._target;
         _texturePath = texture._texturePath;
         _type = texture._type;
+        _loadMode = texture._loadMode;
+        _isFlipped = texture._isFlipped;
+        _format = texture._format;
+        _isCompressed = texture._isCompressed;
+        _width = texture._width;
+        _height = texture._height;
+        _levelSizes = std::move(texture._levelSizes);
+        _residentLevel = texture._residentLevel;
     }
 
     Texture::~Texture()
@@ -109,6 +188,11 @@ namespace Renderer3D {
         return _textureID;
     }
 
+    GLenum Texture::GetTarget() const
+    {
+        return _target;
+    }
+
     TextureType Texture::GetType() const
     {
         return _type;
@@ -118,4 +202,201 @@ namespace Renderer3D {
     {
         return _texturePath;
     }
+
+    bool Texture::IsFlipped() const
+    {
+        return _isFlipped;
+    }
+
+    bool Texture::IsStreamable() const
+    {
+        return _loadMode == TextureLoadMode::DEFERRED && !_levelSizes.empty();
+    }
+
+    GLenum Texture::GetFormat() const
+    {
+        return _format;
+    }
+
+    bool Texture::IsCompressed() const
+    {
+        return _isCompressed;
+    }
+
+    uint32_t Texture::GetWidth() const
+    {
+        return _width;
+    }
+
+    uint32_t Texture::GetHeight() const
+    {
+        return _height;
+    }
+
+    size_t Texture::GetLevelsCount() const
+    {
+        return std::max<size_t>(_levelSizes.size(), 1);
+    }
+
+    size_t Texture::GetResidentLevel() const
+    {
+        return _residentLevel;
+    }
+
+    size_t Texture::GetLevelsSize(const size_t firstLevel) const
+    {
+        size_t size = 0;
+        for (size_t level = firstLevel; level < _levelSizes.size(); level++)
+        {
+            size += _levelSizes[level];
+        }
+        return size;
+    }
+
+    void Texture::UploadLevels(const TextureLevels& levels, const bool fromPixelBuffer)
+    {
+        _format = levels.Format;
+        _isCompressed = levels.IsCompressed;
+        _width = levels.Width;
+        _height = levels.Height;
+        _levelSizes = levels.LevelSizes;
+
+        glBindTexture(GL_TEXTURE_2D, _textureID);
+        // Rows of RGB and single channel levels are tightly packed, so they are not aligned to 4 bytes
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        size_t offset = 0;
+        for (size_t i = 0; i < levels.Levels.size(); i++)
+        {
+            const auto level = levels.FirstLevel + i;
+            const auto& data = levels.Levels[i];
+            const void* source = fromPixelBuffer ? reinterpret_cast<const void*>(offset) : data.data();
+            const auto width = static_cast<GLsizei>(mipLevelDimension(_width, level));
+            const auto height = static_cast<GLsizei>(mipLevelDimension(_height, level));
+            if (_isCompressed)
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), _format, width, height, 0, static_cast<GLsizei>(data.size()), source);
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(_format), width, height, 0, _format, GL_UNSIGNED_BYTE, source);
+            }
+            offset += data.size();
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, DEFAULT_UNPACK_ALIGNMENT);
+        // Levels before the base one are ignored by sampling, so they can be missing. Baked chain may end before 1x1,
+        // the texture stays complete as long as the max level is its last level.
+        _residentLevel = levels.FirstLevel;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(_residentLevel));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(GetLevelsCount()) - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void Texture::EvictLevels(const size_t residentLevel)
+    {
+        if (residentLevel <= _residentLevel || residentLevel >= GetLevelsCount())
+        {
+            return;
+        }
+        glBindTexture(GL_TEXTURE_2D, _textureID);
+        // Base level goes up first, so the texture is never incomplete
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(residentLevel));
+        // Redefining a level as empty releases its storage
+        for (auto level = _residentLevel; level < residentLevel; level++)
+        {
+            if (_isCompressed)
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), _format, 0, 0, 0, 0, nullptr);
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), static_cast<GLint>(_format), 0, 0, 0, _format, GL_UNSIGNED_BYTE, nullptr);
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        _residentLevel = residentLevel;
+    }
+
+    bool Texture::IsBakedFormatSupported(const BakedTextureFormat format)
+    {
+        // RGTC is core since 3.0, S3TC is an extension available on practically every desktop GPU
+        if (format == BakedTextureFormat::BC4 || format == BakedTextureFormat::BC5)
+        {
+            return true;
+        }
+        static const bool isS3tcSupported = isGlExtensionSupported("GL_EXT_texture_compression_s3tc");
+        return isS3tcSupported;
+    }
+
+    bool Texture::LoadBaked(const fs::path& texturePath, const bool flipVertically)
+    {
+        const auto bakedPath = BakedTexture::GetBakedPath(texturePath);
+        std::error_code error;
+        if (!fs::exists(bakedPath, error))
+        {
+            return false;
+        }
+        const auto bakedTexture = BakedTexture::Load(bakedPath);
+        if (!bakedTexture || bakedTexture->GetLevelsCount() == 0 || !IsBakedFormatSupported(bakedTexture->GetFormat()))
+        {
+            return false;
+        }
+        if (!bakedTexture->IsUpToDate(texturePath))
+        {
+            spdlog::warn("Baked texture {} was baked from a different version of {}, source image is used", bakedPath.string(), texturePath.string());
+            return false;
+        }
+        if (bakedTexture->IsFlipped() != flipVertically)
+        {
+            spdlog::warn("Baked texture {} has different orientation than requested, source image is used", bakedPath.string());
+            return false;
+        }
+        UploadLevels(LevelsFromBaked(*bakedTexture, 0, bakedTexture->GetLevelsCount()), false);
+        glBindTexture(GL_TEXTURE_2D, _textureID);
+        SetSamplingParameters();
+        return true;
+    }
+
+    GLenum Texture::GetCompressedFormat(const BakedTextureFormat format)
+    {
+        switch (format)
+        {
+        case BakedTextureFormat::BC1:
+            return COMPRESSED_RGB_S3TC_DXT1;
+        case BakedTextureFormat::BC3:
+            return COMPRESSED_RGBA_S3TC_DXT5;
+        case BakedTextureFormat::BC4:
+            return GL_COMPRESSED_RED_RGTC1;
+        case BakedTextureFormat::BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        default:
+            throw std::invalid_argument("Invalid enum value");
+        }
+    }
+
+    TextureLevels Texture::LevelsFromBaked(const BakedTexture& bakedTexture, const size_t firstLevel, const size_t endLevel)
+    {
+        TextureLevels levels;
+        levels.Format = GetCompressedFormat(bakedTexture.GetFormat());
+        levels.IsCompressed = true;
+        levels.Width = bakedTexture.GetWidth();
+        levels.Height = bakedTexture.GetHeight();
+        levels.FirstLevel = firstLevel;
+        for (size_t level = 0; level < bakedTexture.GetLevelsCount(); level++)
+        {
+            levels.LevelSizes.push_back(bakedTexture.GetLevel(level).size());
+            if (level >= firstLevel && level < endLevel)
+            {
+                levels.Levels.push_back(bakedTexture.GetLevel(level));
+            }
+        }
+        return levels;
+    }
+
+    void Texture::SetSamplingParameters()
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
 } // Renderer3D
\ No newline at end of file
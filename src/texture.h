@@ -6,9 +6,15 @@
 #define TEXTURE_H
 
 #include <glad/glad.h>
+#include <array>
+#include <cstdint>
 #include <filesystem>
+#include <optional>
+#include <vector>
 #include <assimp/material.h>
 
+#include "baked_texture.h"
+
 namespace fs = std::filesystem;
 
 namespace Renderer3D {
@@ -19,22 +25,96 @@ namespace Renderer3D {
         SPECULAR
     };
 
+    enum class TextureLoadMode
+    {
+        // Pixels are decoded and uploaded in the constructor
+        IMMEDIATE,
+        // Texture starts as a single placeholder texel, mip levels are provided later by TextureLoader and may be
+        // streamed in and out afterwards
+        DEFERRED
+    };
+
+    // Consecutive mip levels of a 2D texture, prepared off the GL thread
+    struct TextureLevels
+    {
+        // Internal format of compressed levels, both format and internal format of uncompressed ones
+        GLenum Format = GL_RGBA;
+        bool IsCompressed = false;
+        // Size of level 0
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        // Size in bytes of every level of the full chain, including the ones which are not present
+        std::vector<size_t> LevelSizes;
+        size_t FirstLevel = 0;
+        std::vector<std::vector<std::byte>> Levels;
+    };
+
     std::string_view textureTypeToString(TextureType type);
     TextureType textureTypeFromAssimp(aiTextureType type);
+    // Empty when number of components isn't supported
+    std::optional<GLenum> textureFormatFromComponents(int components);
 
     class Texture {
     public:
-        Texture(const fs::path& texturePath, TextureType type);
+        // Baked file next to the image is used instead of it when present and supported by the GPU
+        Texture(const fs::path& texturePath, TextureType type, TextureLoadMode loadMode = TextureLoadMode::IMMEDIATE, bool flipVertically = false);
+        // Cube map, faces are in order +X, -X, +Y, -Y, +Z, -Z
+        explicit Texture(const std::array<fs::path, 6>& faces);
         Texture(Texture&& texture) noexcept;
         ~Texture();
         [[nodiscard]] GLuint GetId() const;
+        // GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+        [[nodiscard]] GLenum GetTarget() const;
         [[nodiscard]] TextureType GetType() const;
         [[nodiscard]] const fs::path& GetPath() const;
+        [[nodiscard]] bool IsFlipped() const;
+        // Deferred texture whose levels arrived, only such textures have their levels streamed
+        [[nodiscard]] bool IsStreamable() const;
+        [[nodiscard]] GLenum GetFormat() const;
+        [[nodiscard]] bool IsCompressed() const;
+        [[nodiscard]] uint32_t GetWidth() const;
+        [[nodiscard]] uint32_t GetHeight() const;
+        [[nodiscard]] size_t GetLevelsCount() const;
+        // Most detailed level in memory, every level after it is resident too
+        [[nodiscard]] size_t GetResidentLevel() const;
+        // Size in bytes of levels from `firstLevel` to the end of the chain
+        [[nodiscard]] size_t GetLevelsSize(size_t firstLevel) const;
+        // Uploads given levels and makes the first of them the base level. With `fromPixelBuffer` levels are read
+        // from the bound pixel unpack buffer, where they must be stored one after another.
+        void UploadLevels(const TextureLevels& levels, bool fromPixelBuffer);
+        // Frees levels before `residentLevel`, which becomes the new base level
+        void EvictLevels(size_t residentLevel);
+        // Must be called on the GL thread
+        [[nodiscard]] static bool IsBakedFormatSupported(BakedTextureFormat format);
+        [[nodiscard]] static GLenum GetCompressedFormat(BakedTextureFormat format);
+        // Copies levels from `firstLevel` up to (excluding) `endLevel`
+        [[nodiscard]] static TextureLevels LevelsFromBaked(const BakedTexture& bakedTexture, size_t firstLevel, size_t endLevel);
     private:
         GLuint _textureID;
+        GLenum _target = GL_TEXTURE_2D;
         TextureType _type;
         fs::path _texturePath;
+        TextureLoadMode _loadMode = TextureLoadMode::IMMEDIATE;
+        bool _isFlipped = false;
+        GLenum _format = GL_RGBA;
+        bool _isCompressed = false;
+        uint32_t _width = 1;
+        uint32_t _height = 1;
+        // Empty until levels are uploaded with UploadLevels
+        std::vector<size_t> _levelSizes;
+        size_t _residentLevel = 0;
         bool _isMoved = false;
+
+        // Helpers
+        bool LoadBaked(const fs::path& texturePath, bool flipVertically);
+        static void SetSamplingParameters();
+
+        // Consts
+        static constexpr uint8_t PLACEHOLDER_TEXEL[] = { 128, 128, 128, 255 };
+        static constexpr GLint DEFAULT_UNPACK_ALIGNMENT = 4;
+        // S3TC is an extension which glad was not generated with, so its enums are defined here
+        static constexpr GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+        static constexpr GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
     };
 
 } // Renderer3D
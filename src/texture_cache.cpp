@@ -0,0 +1,72 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <spdlog/spdlog.h>
+
+#include "hash.h"
+#include "texture_cache.h"
+
+namespace Renderer3D {
+    std::shared_ptr<Texture> TextureCache::Acquire(const fs::path& path, const TextureType type, const bool flipVertically, TextureLoader* textureLoader, const std::optional<FileDigest>& content)
+    {
+        // Flipped and not flipped image have different pixels, so the flag is a part of both keys
+        const auto flipMarker = flipVertically ? "|flipped" : "";
+        const auto pathKey = GetPathKey(path) + flipMarker;
+        FileDigest contentKey;
+        // Content is needed only when path lookup misses
+        if (const auto it = _byPath.find(pathKey); it == _byPath.end() || it->second.expired())
+        {
+            const auto digest = content ? content : digestFile(path);
+            if (!digest)
+            {
+                spdlog::error("Failed to read texture at {}", path.string());
+            }
+            contentKey = digest.value_or(FileDigest{hashBytes(std::as_bytes(std::span(pathKey)))});
+            contentKey.Hash = hashBytes(std::as_bytes(std::span(&flipVertically, 1)), contentKey.Hash);
+        }
+        return FindOrCreate(pathKey, contentKey, [&]()
+        {
+            if (textureLoader != nullptr)
+            {
+                return textureLoader->Load(path, type, flipVertically);
+            }
+            return std::make_shared<Texture>(Texture(path, type, TextureLoadMode::IMMEDIATE, flipVertically));
+        });
+    }
+
+    std::shared_ptr<Texture> TextureCache::AcquireCubemap(const std::array<fs::path, 6>& faces)
+    {
+        // Keys are prefixed, so a cube map never matches a 2D texture made of one of its faces
+        std::string pathKey = CUBEMAP_KEY_PREFIX;
+        FileDigest contentKey{hashBytes(std::as_bytes(std::span(pathKey)))};
+        for (const auto& face : faces)
+        {
+            const auto facePathKey = GetPathKey(face);
+            pathKey += "|" + facePathKey;
+            const auto faceDigest = digestFile(face).value_or(FileDigest{hashBytes(std::as_bytes(std::span(facePathKey)))});
+            contentKey.Hash = hashBytes(std::as_bytes(std::span(&faceDigest.Hash, 1)), contentKey.Hash);
+            contentKey.Size += faceDigest.Size;
+        }
+        return FindOrCreate(pathKey, contentKey, [&faces]() { return std::make_shared<Texture>(faces); });
+    }
+
+    void TextureCache::Purge()
+    {
+        std::erase_if(_byPath, [](const auto& entry) { return entry.second.expired(); });
+        _statistics.Evictions += std::erase_if(_byContent, [](const auto& entry) { return entry.second.expired(); });
+        _statistics.ResidentTextures = _byContent.size();
+    }
+
+    const TextureCacheStatistics& TextureCache::GetStatistics() const
+    {
+        return _statistics;
+    }
+
+    std::string TextureCache::GetPathKey(const fs::path& path)
+    {
+        std::error_code error;
+        const auto canonicalPath = fs::weakly_canonical(path, error);
+        return (error ? path : canonicalPath).string();
+    }
+} // Renderer3D
@@ -0,0 +1,98 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "hash.h"
+#include "texture.h"
+#include "texture_loader.h"
+
+namespace fs = std::filesystem;
+
+namespace Renderer3D {
+
+    struct TextureCacheStatistics
+    {
+        // Textures currently alive, each one is a single GL texture no matter how many users it has
+        size_t ResidentTextures = 0;
+        // Requests served by the same canonical path
+        size_t PathHits = 0;
+        // Requests for a different file with byte-identical content
+        size_t ContentHits = 0;
+        size_t Misses = 0;
+        // Textures released by their last user
+        size_t Evictions = 0;
+    };
+
+    // Registry of every texture in the process. Textures are found by canonical path first and by content digest
+    // second, so the same image used by several models, or copied under another name, is decoded and uploaded once.
+    // Only weak references are kept - a texture lives as long as some model, floor or skybox holds it.
+    class TextureCache {
+    public:
+        // With `textureLoader` a newly created texture is decoded in the background, otherwise right away.
+        // `content` is the file digest if the caller already has it - otherwise the file is read whole on path miss.
+        std::shared_ptr<Texture> Acquire(const fs::path& path, TextureType type, bool flipVertically = false, TextureLoader* textureLoader = nullptr, const std::optional<FileDigest>& content = std::nullopt);
+        std::shared_ptr<Texture> AcquireCubemap(const std::array<fs::path, 6>& faces);
+        // Forgets textures nobody uses anymore and counts them as evicted
+        void Purge();
+        [[nodiscard]] const TextureCacheStatistics& GetStatistics() const;
+    private:
+        std::unordered_map<std::string, std::weak_ptr<Texture>> _byPath;
+        std::map<FileDigest, std::weak_ptr<Texture>> _byContent;
+        TextureCacheStatistics _statistics;
+
+        // Helpers
+        template<typename Create>
+        std::shared_ptr<Texture> FindOrCreate(const std::string& pathKey, const FileDigest& contentKey, Create&& create);
+        static std::string GetPathKey(const fs::path& path);
+
+        // Consts
+        static constexpr auto CUBEMAP_KEY_PREFIX = "cubemap";
+    };
+
+    template<typename Create>
+    std::shared_ptr<Texture> TextureCache::FindOrCreate(const std::string& pathKey, const FileDigest& contentKey, Create&& create)
+    {
+        if (const auto it = _byPath.find(pathKey); it != _byPath.end())
+        {
+            if (auto texture = it->second.lock())
+            {
+                _statistics.PathHits++;
+                return texture;
+            }
+        }
+        if (const auto it = _byContent.find(contentKey); it != _byContent.end())
+        {
+            if (auto texture = it->second.lock())
+            {
+                _statistics.ContentHits++;
+                _byPath[pathKey] = texture;
+                return texture;
+            }
+            // Entry of a released texture is replaced before Purge could count it
+            _statistics.Evictions++;
+            _statistics.ResidentTextures--;
+        }
+        auto texture = create();
+        _statistics.Misses++;
+        _statistics.ResidentTextures++;
+        _byPath[pathKey] = texture;
+        _byContent[contentKey] = texture;
+        return texture;
+    }
+
+} // Renderer3D
+
+#endif //TEXTURE_CACHE_H
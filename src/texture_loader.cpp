@@ -0,0 +1,285 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stb_image/stb_image.h>
+#include <spdlog/spdlog.h>
+
+#include "mip_chain.h"
+#include "texture_loader.h"
+
+namespace Renderer3D {
+    TextureLoader::TextureLoader(ThreadPool& threadPool) : _threadPool(threadPool)
+    {
+        for (auto& pixelBuffer : _pixelBuffers)
+        {
+            glGenBuffers(1, &pixelBuffer.Buffer);
+        }
+    }
+
+    std::shared_ptr<Texture> TextureLoader::Load(const fs::path& path, const TextureType type, const bool flipVertically)
+    {
+        auto texture = std::make_shared<Texture>(path, type, TextureLoadMode::DEFERRED, flipVertically);
+        TextureRequest request;
+        request.Target = texture;
+        request.Path = path;
+        request.FlipVertically = flipVertically;
+        request.EndLevel = ALL_LEVELS;
+        Submit(request);
+        _requests.push_back(std::move(request));
+        return texture;
+    }
+
+    void TextureLoader::LoadLevels(const std::shared_ptr<Texture>& texture, const size_t firstLevel)
+    {
+        if (!texture->IsStreamable() || firstLevel >= texture->GetResidentLevel() || IsLoading(*texture))
+        {
+            return;
+        }
+        TextureRequest request;
+        request.Target = texture;
+        request.Path = texture->GetPath();
+        request.FlipVertically = texture->IsFlipped();
+        // Levels must match the format of the ones already resident
+        request.AllowBaked = texture->IsCompressed();
+        request.FirstLevel = firstLevel;
+        request.EndLevel = texture->GetResidentLevel();
+        Submit(request);
+        _requests.push_back(std::move(request));
+    }
+
+    bool TextureLoader::IsLoading(const Texture& texture) const
+    {
+        return std::ranges::any_of(_requests, [&texture](const TextureRequest& request) { return request.Target.lock().get() == &texture; });
+    }
+
+    void TextureLoader::Update(const float uploadBudget)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto isOverBudget = [start, uploadBudget]()
+        {
+            return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() >= uploadBudget;
+        };
+
+        RetirePixelBuffers();
+
+        for (auto it = _requests.begin(); it != _requests.end() && !isOverBudget();)
+        {
+            if (it->Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                ++it;
+                continue;
+            }
+            const auto texture = it->Target.lock();
+            if (!texture)
+            {
+                it = _requests.erase(it);
+                continue;
+            }
+            const auto pixelBuffer = std::ranges::find_if(_pixelBuffers, [](const PixelBuffer& buffer) { return buffer.Fence == nullptr; });
+            if (pixelBuffer == _pixelBuffers.end())
+            {
+                // Every buffer is still being read by GPU
+                break;
+            }
+            const auto result = it->Result.get();
+            if (result.BakedFormat && !Texture::IsBakedFormatSupported(*result.BakedFormat))
+            {
+                // Support can only be checked on the GL thread, so the source image is decoded after all. Streamed
+                // levels can't be mixed with uncompressed ones, so such request is dropped instead.
+                if (!it->FirstLevel)
+                {
+                    it->AllowBaked = false;
+                    Submit(*it);
+                    ++it;
+                    continue;
+                }
+            }
+            else if (result.Levels && CanUpload(*texture, *it, *result.Levels))
+            {
+                Upload(*pixelBuffer, *texture, *result.Levels);
+            }
+            it = _requests.erase(it);
+        }
+    }
+
+    size_t TextureLoader::GetPendingTexturesCount() const
+    {
+        return _requests.size();
+    }
+
+    TextureLoader::~TextureLoader()
+    {
+        for (auto& pixelBuffer : _pixelBuffers)
+        {
+            if (pixelBuffer.Fence != nullptr)
+            {
+                glDeleteSync(pixelBuffer.Fence);
+            }
+            glDeleteBuffers(1, &pixelBuffer.Buffer);
+        }
+    }
+
+    void TextureLoader::Submit(TextureRequest& request)
+    {
+        request.Result = _threadPool.Submit([path = request.Path, flipVertically = request.FlipVertically, allowBaked = request.AllowBaked, firstLevel = request.FirstLevel, endLevel = request.EndLevel]()
+        {
+            return Decode(path, flipVertically, allowBaked, firstLevel, endLevel);
+        });
+    }
+
+    TextureLoader::DecodedLevels TextureLoader::Decode(const fs::path& path, const bool flipVertically, const bool allowBaked, const std::optional<size_t> firstLevel, const size_t endLevel)
+    {
+        DecodedLevels result;
+        const auto bakedPath = BakedTexture::GetBakedPath(path);
+        std::error_code error;
+        if (allowBaked && fs::exists(bakedPath, error))
+        {
+            const auto bakedTexture = BakedTexture::Load(bakedPath);
+            // Image edited after baking would otherwise show its old content forever
+            const auto isUpToDate = bakedTexture && bakedTexture->IsUpToDate(path);
+            if (isUpToDate && bakedTexture->GetLevelsCount() > 0 && bakedTexture->IsFlipped() == flipVertically)
+            {
+                const auto first = std::min(firstLevel.value_or(GetMipTailLevel(bakedTexture->GetWidth(), bakedTexture->GetHeight())), bakedTexture->GetLevelsCount() - 1);
+                result.Levels = Texture::LevelsFromBaked(*bakedTexture, first, endLevel);
+                result.BakedFormat = bakedTexture->GetFormat();
+                return result;
+            }
+            if (bakedTexture && !isUpToDate)
+            {
+                spdlog::warn("Baked texture {} was baked from a different version of {}, source image is decoded instead", bakedPath.string(), path.string());
+            }
+            else
+            {
+                spdlog::warn("Baked texture {} can't be used, source image is decoded instead", bakedPath.string());
+            }
+        }
+
+        // Flip setting is thread local, so workers loading different models don't race on the global one
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
+        int width, height, components;
+        const std::unique_ptr<uint8_t, void(*)(void*)> pixels = { stbi_load(path.string().c_str(), &width, &height, &components, 0), stbi_image_free };
+        if (!pixels)
+        {
+            spdlog::error("Failed to load texture at {}", path.string());
+            return result;
+        }
+        const auto format = textureFormatFromComponents(components);
+        if (!format)
+        {
+            spdlog::error("Texture format not supported (invalid number of components: {})", components);
+            return result;
+        }
+
+        TextureLevels levels;
+        levels.Format = *format;
+        levels.Width = static_cast<uint32_t>(width);
+        levels.Height = static_cast<uint32_t>(height);
+        const auto levelsCount = mipLevelsCount(levels.Width, levels.Height);
+        for (size_t level = 0; level < levelsCount; level++)
+        {
+            levels.LevelSizes.push_back(static_cast<size_t>(mipLevelDimension(levels.Width, level)) * mipLevelDimension(levels.Height, level) * components);
+        }
+        levels.FirstLevel = std::min(firstLevel.value_or(GetMipTailLevel(levels.Width, levels.Height)), levelsCount - 1);
+        const auto end = std::min(endLevel, levelsCount);
+
+        // Whole chain is built from level 0 even when only the tail is needed, so every level is filtered the same way
+        std::vector<uint8_t> downsampled;
+        const uint8_t* current = pixels.get();
+        for (size_t level = 0; level < end; level++)
+        {
+            if (level >= levels.FirstLevel)
+            {
+                const auto bytes = reinterpret_cast<const std::byte*>(current);
+                levels.Levels.emplace_back(bytes, bytes + levels.LevelSizes[level]);
+            }
+            if (level + 1 < end)
+            {
+                downsampled = downsampleImage(current, mipLevelDimension(levels.Width, level), mipLevelDimension(levels.Height, level), components);
+                current = downsampled.data();
+            }
+        }
+        result.Levels = std::move(levels);
+        return result;
+    }
+
+    size_t TextureLoader::GetMipTailLevel(const uint32_t width, const uint32_t height)
+    {
+        size_t level = 0;
+        while (std::max(mipLevelDimension(width, level), mipLevelDimension(height, level)) > MIP_TAIL_SIZE)
+        {
+            level++;
+        }
+        return level;
+    }
+
+    bool TextureLoader::CanUpload(const Texture& texture, const TextureRequest& request, const TextureLevels& levels)
+    {
+        if (levels.Levels.empty())
+        {
+            return false;
+        }
+        if (!request.FirstLevel)
+        {
+            return true;
+        }
+        // Streamed levels must continue the resident chain, which could have changed since the request was made
+        return texture.IsStreamable() && levels.Format == texture.GetFormat() && levels.Width == texture.GetWidth()
+            && levels.Height == texture.GetHeight() && levels.FirstLevel + levels.Levels.size() == texture.GetResidentLevel();
+    }
+
+    void TextureLoader::RetirePixelBuffers()
+    {
+        for (auto& pixelBuffer : _pixelBuffers)
+        {
+            if (pixelBuffer.Fence == nullptr)
+            {
+                continue;
+            }
+            const auto status = glClientWaitSync(pixelBuffer.Fence, 0, 0);
+            if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            {
+                glDeleteSync(pixelBuffer.Fence);
+                pixelBuffer.Fence = nullptr;
+            }
+        }
+    }
+
+    void TextureLoader::Upload(PixelBuffer& pixelBuffer, Texture& texture, const TextureLevels& levels)
+    {
+        size_t size = 0;
+        for (const auto& level : levels.Levels)
+        {
+            size += level.size();
+        }
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.Buffer);
+        if (pixelBuffer.Size < size)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+            pixelBuffer.Size = size;
+        }
+        const auto mapping = static_cast<std::byte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+        if (mapping == nullptr)
+        {
+            spdlog::error("Failed to map pixel buffer for texture {}", texture.GetPath().string());
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+        size_t offset = 0;
+        for (const auto& level : levels.Levels)
+        {
+            std::memcpy(mapping + offset, level.data(), level.size());
+            offset += level.size();
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Source is the bound buffer, so upload calls return without waiting for the copy
+        texture.UploadLevels(levels, true);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pixelBuffer.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+} // Renderer3D
@@ -0,0 +1,93 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <glad/glad.h>
+
+#include "baked_texture.h"
+#include "texture.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+namespace Renderer3D {
+
+    // Loads mip levels of textures without stalling the render loop. Images are decoded and their mip chains built
+    // on worker threads (each with its own flip setting), and levels are copied into pixel buffer objects so the
+    // driver uploads them asynchronously. Baked textures are read instead of their source images when present.
+    // A texture starts with only its mip tail, more detailed levels are loaded on request of TextureStreamer.
+    class TextureLoader {
+    public:
+        explicit TextureLoader(ThreadPool& threadPool);
+        TextureLoader(const TextureLoader&) = delete;
+        TextureLoader& operator=(const TextureLoader&) = delete;
+        // Returned texture can be bound right away, it shows a placeholder texel until its mip tail is uploaded
+        std::shared_ptr<Texture> Load(const fs::path& path, TextureType type, bool flipVertically);
+        // Loads levels from `firstLevel` up to the resident one of a streamable texture
+        void LoadLevels(const std::shared_ptr<Texture>& texture, size_t firstLevel);
+        [[nodiscard]] bool IsLoading(const Texture& texture) const;
+        // Must be called on the GL thread, uploads decoded levels until `uploadBudget` milliseconds pass
+        void Update(float uploadBudget);
+        [[nodiscard]] size_t GetPendingTexturesCount() const;
+        ~TextureLoader();
+    private:
+        struct DecodedLevels
+        {
+            std::optional<TextureLevels> Levels;
+            // Set when levels come from a baked file, whose format may turn out to be unsupported
+            std::optional<BakedTextureFormat> BakedFormat;
+        };
+
+        struct TextureRequest
+        {
+            // Texture may be released before its levels are ready, they are dropped then
+            std::weak_ptr<Texture> Target;
+            std::future<DecodedLevels> Result;
+            fs::path Path;
+            bool FlipVertically = false;
+            bool AllowBaked = true;
+            // Mip tail is loaded when empty
+            std::optional<size_t> FirstLevel;
+            size_t EndLevel = 0;
+        };
+
+        // Buffer is free when it has no fence - otherwise GPU may still be reading it
+        struct PixelBuffer
+        {
+            GLuint Buffer = 0;
+            size_t Size = 0;
+            GLsync Fence = nullptr;
+        };
+
+        ThreadPool& _threadPool;
+        std::vector<TextureRequest> _requests;
+        std::vector<PixelBuffer> _pixelBuffers = std::vector<PixelBuffer>(PIXEL_BUFFERS_COUNT);
+
+        // Helpers
+        void Submit(TextureRequest& request);
+        static DecodedLevels Decode(const fs::path& path, bool flipVertically, bool allowBaked, std::optional<size_t> firstLevel, size_t endLevel);
+        static size_t GetMipTailLevel(uint32_t width, uint32_t height);
+        [[nodiscard]] static bool CanUpload(const Texture& texture, const TextureRequest& request, const TextureLevels& levels);
+        void RetirePixelBuffers();
+        void Upload(PixelBuffer& pixelBuffer, Texture& texture, const TextureLevels& levels);
+
+        // Consts
+        static constexpr size_t PIXEL_BUFFERS_COUNT = 4;
+        // Levels not bigger than this are always resident
+        static constexpr uint32_t MIP_TAIL_SIZE = 64;
+        static constexpr size_t ALL_LEVELS = SIZE_MAX;
+    };
+
+} // Renderer3D
+
+#endif //TEXTURE_LOADER_H
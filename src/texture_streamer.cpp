@@ -0,0 +1,175 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "texture_streamer.h"
+
+namespace Renderer3D {
+    TextureStreamer::TextureStreamer(TextureLoader& textureLoader) : _textureLoader(textureLoader)
+    {
+    }
+
+    void TextureStreamer::BeginFrame(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, const size_t renderHeight)
+    {
+        _frame++;
+        _frustum = LightTree::CalculateTilePlanes(projection * view, glm::vec2(-1.0f), glm::vec2(1.0f));
+        _projection = projection;
+        _cameraPos = cameraPos;
+        _renderHeight = std::max<size_t>(renderHeight, 1);
+    }
+
+    std::optional<float> TextureStreamer::CalculateUvPerPixel(const glm::vec3& center, const float radius, const float uvDensity) const
+    {
+        if (!isSphereVisible(_frustum, center, radius))
+        {
+            return std::nullopt;
+        }
+        // Nearest point of the sphere decides, so no part of the surface is undersampled
+        const auto distance = std::max(glm::length(center - _cameraPos) - radius, MIN_DISTANCE);
+        // Clip space w at that distance - the distance itself for perspective projection and 1 for orthographic one
+        const auto w = -_projection[2][3] * distance + _projection[3][3];
+        const auto worldPerPixel = 2.0f * w / (_projection[1][1] * static_cast<float>(_renderHeight));
+        return uvDensity * worldPerPixel;
+    }
+
+    void TextureStreamer::Request(const std::shared_ptr<Texture>& texture, const float uvPerPixel)
+    {
+        if (!texture->IsStreamable())
+        {
+            return;
+        }
+        auto [it, isInserted] = _textures.try_emplace(texture.get());
+        auto& streamedTexture = it->second;
+        if (isInserted || streamedTexture.Target.expired())
+        {
+            streamedTexture = StreamedTexture{ texture, texture->GetResidentLevel() };
+        }
+        // Level at which one texel covers about one pixel
+        const auto texelsPerPixel = uvPerPixel * static_cast<float>(std::max(texture->GetWidth(), texture->GetHeight()));
+        const auto level = texelsPerPixel <= 1.0f ? 0 : static_cast<size_t>(std::log2(texelsPerPixel));
+        const auto wantedLevel = std::min({ level, streamedTexture.TailLevel, texture->GetLevelsCount() - 1 });
+        // Texture used by several meshes gets the most detailed level any of them needs
+        if (streamedTexture.LastRequestedFrame != _frame || wantedLevel < streamedTexture.WantedLevel)
+        {
+            streamedTexture.WantedLevel = wantedLevel;
+        }
+        streamedTexture.LastRequestedFrame = _frame;
+    }
+
+    void TextureStreamer::Update(const size_t budget)
+    {
+        std::erase_if(_textures, [](const auto& entry) { return entry.second.Target.expired(); });
+
+        size_t residentSize = 0;
+        size_t loadingSize = 0;
+        size_t loadsCount = 0;
+        std::vector<StreamedTexture*> candidates;
+        for (auto& [key, streamedTexture] : _textures)
+        {
+            const auto texture = streamedTexture.Target.lock();
+            residentSize += texture->GetLevelsSize(texture->GetResidentLevel());
+            if (_textureLoader.IsLoading(*texture))
+            {
+                loadingSize += texture->GetLevelsSize(streamedTexture.LoadingLevel) - texture->GetLevelsSize(texture->GetResidentLevel());
+                loadsCount++;
+            }
+            else if (streamedTexture.LastRequestedFrame == _frame && streamedTexture.WantedLevel < texture->GetResidentLevel())
+            {
+                candidates.push_back(&streamedTexture);
+            }
+        }
+        // Lowered budget is met right away, even with nothing to load
+        if (residentSize + loadingSize > budget)
+        {
+            residentSize -= Evict(residentSize + loadingSize - budget);
+        }
+
+        // Textures missing most levels are the blurriest on screen, so they go first
+        const auto missingLevels = [](const StreamedTexture* streamedTexture)
+        {
+            return streamedTexture->Target.lock()->GetResidentLevel() - streamedTexture->WantedLevel;
+        };
+        std::ranges::sort(candidates, std::greater(), missingLevels);
+        for (const auto streamedTexture : candidates)
+        {
+            if (loadsCount >= MAX_LOADS_IN_FLIGHT)
+            {
+                break;
+            }
+            const auto texture = streamedTexture->Target.lock();
+            const auto residentLevel = texture->GetResidentLevel();
+            // Levels are taken from the least detailed one, as many as fit in the budget after evictions
+            auto level = streamedTexture->WantedLevel;
+            const auto getLoadSize = [&texture, residentLevel](const size_t firstLevel)
+            {
+                return texture->GetLevelsSize(firstLevel) - texture->GetLevelsSize(residentLevel);
+            };
+            if (residentSize + loadingSize + getLoadSize(level) > budget)
+            {
+                residentSize -= Evict(residentSize + loadingSize + getLoadSize(level) - budget);
+            }
+            while (level < residentLevel && residentSize + loadingSize + getLoadSize(level) > budget)
+            {
+                level++;
+            }
+            if (level == residentLevel)
+            {
+                continue;
+            }
+            _textureLoader.LoadLevels(texture, level);
+            streamedTexture->LoadingLevel = level;
+            loadingSize += getLoadSize(level);
+            loadsCount++;
+        }
+
+        _statistics.StreamedTextures = _textures.size();
+        _statistics.ResidentSize = residentSize;
+        _statistics.Budget = budget;
+        _statistics.PendingLoads = loadsCount;
+    }
+
+    const TextureStreamingStatistics& TextureStreamer::GetStatistics() const
+    {
+        return _statistics;
+    }
+
+    size_t TextureStreamer::GetNeededLevel(const StreamedTexture& streamedTexture) const
+    {
+        return streamedTexture.LastRequestedFrame == _frame ? streamedTexture.WantedLevel : streamedTexture.TailLevel;
+    }
+
+    size_t TextureStreamer::Evict(const size_t size)
+    {
+        std::vector<StreamedTexture*> victims;
+        for (auto& [key, streamedTexture] : _textures)
+        {
+            const auto texture = streamedTexture.Target.lock();
+            // Textures being loaded are skipped, as loaded levels must continue the resident chain
+            if (GetNeededLevel(streamedTexture) > texture->GetResidentLevel() && !_textureLoader.IsLoading(*texture))
+            {
+                victims.push_back(&streamedTexture);
+            }
+        }
+        std::ranges::sort(victims, std::less(), &StreamedTexture::LastRequestedFrame);
+
+        size_t freedSize = 0;
+        for (const auto streamedTexture : victims)
+        {
+            if (freedSize >= size)
+            {
+                break;
+            }
+            const auto texture = streamedTexture->Target.lock();
+            const auto residentLevel = texture->GetResidentLevel();
+            const auto neededLevel = GetNeededLevel(*streamedTexture);
+            freedSize += texture->GetLevelsSize(residentLevel) - texture->GetLevelsSize(neededLevel);
+            _statistics.EvictedLevels += neededLevel - residentLevel;
+            texture->EvictLevels(neededLevel);
+        }
+        return freedSize;
+    }
+} // Renderer3D
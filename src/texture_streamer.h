@@ -0,0 +1,83 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "light_tree.h"
+#include "texture.h"
+#include "texture_loader.h"
+
+namespace Renderer3D {
+
+    struct TextureStreamingStatistics
+    {
+        size_t StreamedTextures = 0;
+        // In bytes, counts every resident level of streamed textures
+        size_t ResidentSize = 0;
+        size_t Budget = 0;
+        size_t PendingLoads = 0;
+        // Total count of levels freed to stay within budget
+        size_t EvictedLevels = 0;
+    };
+
+    // Keeps mip levels of deferred textures resident only as far as they are needed. Every frame visible meshes
+    // request their textures together with how much texture space a screen pixel covers, which picks the most
+    // detailed level worth sampling. Missing levels are loaded in the background, and levels nobody needs anymore
+    // are evicted (least recently requested first) whenever memory would exceed the budget. Mip tails always stay.
+    class TextureStreamer {
+    public:
+        explicit TextureStreamer(TextureLoader& textureLoader);
+        TextureStreamer(const TextureStreamer&) = delete;
+        TextureStreamer& operator=(const TextureStreamer&) = delete;
+        // Starts collecting requests of a frame rendered with given camera at `renderHeight` pixels
+        void BeginFrame(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPos, size_t renderHeight);
+        // Texture coordinates change per screen pixel for a surface inside given world space sphere, where they change
+        // by `uvDensity` per world unit. Empty when the sphere is outside of the view.
+        [[nodiscard]] std::optional<float> CalculateUvPerPixel(const glm::vec3& center, float radius, float uvDensity) const;
+        void Request(const std::shared_ptr<Texture>& texture, float uvPerPixel);
+        // Loads requested levels and evicts unused ones so resident levels fit in `budget` bytes
+        void Update(size_t budget);
+        [[nodiscard]] const TextureStreamingStatistics& GetStatistics() const;
+    private:
+        struct StreamedTexture
+        {
+            std::weak_ptr<Texture> Target;
+            // Resident when the texture is seen for the first time, it is never evicted
+            size_t TailLevel = 0;
+            size_t WantedLevel = 0;
+            // Level which is being loaded, valid while loader has a request for the texture
+            size_t LoadingLevel = 0;
+            size_t LastRequestedFrame = 0;
+        };
+
+        TextureLoader& _textureLoader;
+        std::unordered_map<const Texture*, StreamedTexture> _textures;
+        TilePlanes _frustum{};
+        glm::mat4 _projection = glm::mat4(1.0f);
+        glm::vec3 _cameraPos = glm::vec3(0.0f);
+        size_t _renderHeight = 1;
+        size_t _frame = 0;
+        TextureStreamingStatistics _statistics;
+
+        // Helpers
+        // Level which should be resident for this frame, levels before it may be evicted
+        [[nodiscard]] size_t GetNeededLevel(const StreamedTexture& streamedTexture) const;
+        // Returns freed size in bytes
+        size_t Evict(size_t size);
+
+        // Consts
+        static constexpr float MIN_DISTANCE = 0.1f;
+        static constexpr size_t MAX_LOADS_IN_FLIGHT = 4;
+    };
+
+} // Renderer3D
+
+#endif //TEXTURE_STREAMER_H
@@ -0,0 +1,71 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace Renderer3D {
+    ThreadPool::ThreadPool(const size_t threadsCount)
+    {
+        for (size_t i = 0; i < std::max(threadsCount, static_cast<size_t>(1)); i++)
+        {
+            _threads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    size_t ThreadPool::GetThreadsCount() const
+    {
+        return _threads.size();
+    }
+
+    size_t ThreadPool::GetDefaultThreadsCount()
+    {
+        // hardware_concurrency may return 0 when it can't be determined
+        const auto hardwareThreads = static_cast<size_t>(std::thread::hardware_concurrency());
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _isStopping = true;
+        }
+        _condition.notify_all();
+        // Tasks still waiting in the queue are dropped, their futures report a broken promise
+        for (auto& thread : _threads)
+        {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::Enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _tasks.push(std::move(task));
+        }
+        _condition.notify_one();
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(_mutex);
+                _condition.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+                if (_isStopping)
+                {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+            task();
+        }
+    }
+} // Renderer3D
@@ -0,0 +1,55 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Renderer3D {
+
+    // Fixed set of worker threads executing submitted tasks in FIFO order. Tasks must not touch GL state -
+    // the context is current only on the main thread, so their results are handed back through futures.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(size_t threadsCount);
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        template<typename Function>
+        std::future<std::invoke_result_t<Function>> Submit(Function&& function)
+        {
+            using Result = std::invoke_result_t<Function>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+            auto future = task->get_future();
+            Enqueue([task]() { (*task)(); });
+            return future;
+        }
+        [[nodiscard]] size_t GetThreadsCount() const;
+        // All cores but the one running the render loop
+        [[nodiscard]] static size_t GetDefaultThreadsCount();
+        ~ThreadPool();
+    private:
+        std::vector<std::thread> _threads;
+        std::queue<std::function<void()>> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _isStopping = false;
+
+        // Helpers
+        void Enqueue(std::function<void()> task);
+        void WorkerLoop();
+    };
+
+} // Renderer3D
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,103 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "vertex_quantization.h"
+
+namespace Renderer3D {
+    static constexpr float UNORM16_MAX = 65535.0f;
+    static constexpr float SNORM10_MAX = 511.0f;
+    static constexpr uint32_t MAX_FINITE_HALF = 0x7BFF;
+
+    PositionQuantization calculatePositionQuantization(const std::span<const Vertex> vertices)
+    {
+        PositionQuantization quantization;
+        if (vertices.empty())
+        {
+            return quantization;
+        }
+        auto boundsMin = vertices[0].Position;
+        auto boundsMax = vertices[0].Position;
+        for (const auto& vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+        quantization.Offset = boundsMin;
+        quantization.Scale = boundsMax - boundsMin;
+        return quantization;
+    }
+
+    PackedVertex packVertex(const Vertex& vertex, const PositionQuantization& quantization)
+    {
+        PackedVertex packed{};
+        for (int axis = 0; axis < 3; axis++)
+        {
+            // Flat axes have zero scale, every position on them is the offset
+            const auto normalized = quantization.Scale[axis] > 0.0f ? (vertex.Position[axis] - quantization.Offset[axis]) / quantization.Scale[axis] : 0.0f;
+            packed.Position[axis] = static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.0f, 1.0f) * UNORM16_MAX));
+        }
+        packed.Normal = packNormal(vertex.Normal);
+        packed.TexCoords[0] = packHalf(vertex.TexCoords.x);
+        packed.TexCoords[1] = packHalf(vertex.TexCoords.y);
+        return packed;
+    }
+
+    uint16_t packHalf(const float value)
+    {
+        const auto bits = std::bit_cast<uint32_t>(value);
+        const auto sign = (bits >> 16) & 0x8000u;
+        const auto floatExponent = (bits >> 23) & 0xFFu;
+        auto mantissa = bits & 0x7FFFFFu;
+        if (floatExponent == 0xFFu)
+        {
+            // NaN stays NaN, infinities become the largest finite value like every other value out of range
+            return static_cast<uint16_t>(mantissa != 0 ? sign | 0x7E00u : sign | MAX_FINITE_HALF);
+        }
+        const auto exponent = static_cast<int>(floatExponent) - 127 + 15;
+        if (exponent >= 31)
+        {
+            return static_cast<uint16_t>(sign | MAX_FINITE_HALF);
+        }
+        // Dropped mantissa bits are rounded to nearest, ties to even
+        const auto round = [](const uint32_t kept, const uint32_t dropped, const uint32_t halfway)
+        {
+            return dropped > halfway || (dropped == halfway && (kept & 1u) != 0) ? kept + 1 : kept;
+        };
+        if (exponent <= 0)
+        {
+            // Denormal half, or zero when even the implicit bit is shifted out
+            if (exponent < -10)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+            mantissa |= 0x800000u;
+            const auto shift = static_cast<uint32_t>(14 - exponent);
+            return static_cast<uint16_t>(sign | round(mantissa >> shift, mantissa & ((1u << shift) - 1), 1u << (shift - 1)));
+        }
+        // Rounding may carry into exponent, which is still the correctly rounded value
+        const auto half = round((static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13), mantissa & 0x1FFFu, 0x1000u);
+        return static_cast<uint16_t>(sign | std::min(half, MAX_FINITE_HALF));
+    }
+
+    uint32_t packNormal(const glm::vec3& normal)
+    {
+        uint32_t packed = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const auto component = static_cast<int32_t>(std::lround(std::clamp(normal[axis], -1.0f, 1.0f) * SNORM10_MAX));
+            packed |= (static_cast<uint32_t>(component) & 0x3FFu) << (axis * 10);
+        }
+        return packed;
+    }
+
+    bool canUseShortIndices(const size_t verticesCount)
+    {
+        return verticesCount <= static_cast<size_t>(std::numeric_limits<uint16_t>::max()) + 1;
+    }
+} // Renderer3D
\ No newline at end of file
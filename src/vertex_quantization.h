@@ -0,0 +1,36 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef VERTEX_QUANTIZATION_H
+#define VERTEX_QUANTIZATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+namespace Renderer3D {
+
+    // Maps 16-bit normalized positions back to model space: `Offset + position * Scale`
+    struct PositionQuantization
+    {
+        glm::vec3 Offset = glm::vec3(0.0f);
+        glm::vec3 Scale = glm::vec3(1.0f);
+    };
+
+    // Quantization grid spanning bounds of all positions
+    PositionQuantization calculatePositionQuantization(std::span<const Vertex> vertices);
+    // IMPORTANT: decoding in visibility_resolve_fragment.glsl must match these packings
+    PackedVertex packVertex(const Vertex& vertex, const PositionQuantization& quantization);
+    // Round to nearest even, values outside of half range are clamped to the largest finite half
+    uint16_t packHalf(float value);
+    uint32_t packNormal(const glm::vec3& normal);
+    // 16-bit indices can address every vertex
+    bool canUseShortIndices(size_t verticesCount);
+
+} // Renderer3D
+
+#endif //VERTEX_QUANTIZATION_H
@@ -0,0 +1,371 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+#include "visibility_buffer.h"
+
+namespace Renderer3D {
+    VisibilityBuffer::VisibilityBuffer()
+    {
+        _visibilityShader = std::make_shared<Shader>("../assets/shaders/visibility_vertex.glsl", "../assets/shaders/visibility_fragment.glsl");
+        _classifyShader = std::make_shared<Shader>("../assets/shaders/visibility_quad_vertex.glsl", "../assets/shaders/visibility_classify_fragment.glsl");
+        _resolveShader = std::make_shared<Shader>("../assets/shaders/visibility_quad_vertex.glsl", "../assets/shaders/visibility_resolve_fragment.glsl");
+
+        glGenFramebuffers(1, &_visibilityFramebuffer);
+        glGenFramebuffers(1, &_resolveFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, _resolveFramebuffer);
+        constexpr unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        glDrawBuffers(2, attachments);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Arena starts empty and grows whenever a new mesh is drawn
+        glGenTextures(1, &_arenaVerticesTextureID);
+        glGenTextures(1, &_arenaPackedVerticesTextureID);
+        glGenTextures(1, &_arenaIndicesTextureID);
+        glGenTextures(1, &_arenaShortIndicesTextureID);
+        _arenaVertexCapacity = INITIAL_ARENA_VERTEX_UNITS;
+        _arenaIndexCapacity = INITIAL_ARENA_INDEX_UNITS;
+        GrowBuffer(_arenaVerticesBufferID, 0, _arenaVertexCapacity * ARENA_VERTEX_UNIT);
+        AttachBufferTexture(_arenaVerticesTextureID, GL_RGBA32F, _arenaVerticesBufferID);
+        AttachBufferTexture(_arenaPackedVerticesTextureID, GL_RGBA32UI, _arenaVerticesBufferID);
+        GrowBuffer(_arenaIndicesBufferID, 0, _arenaIndexCapacity * ARENA_INDEX_UNIT);
+        AttachBufferTexture(_arenaIndicesTextureID, GL_R32UI, _arenaIndicesBufferID);
+        AttachBufferTexture(_arenaShortIndicesTextureID, GL_R16UI, _arenaIndicesBufferID);
+
+        glGenBuffers(1, &_drawsBufferID);
+        glBindBuffer(GL_TEXTURE_BUFFER, _drawsBufferID);
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4) * DRAW_DATA_STRIDE, nullptr, GL_STREAM_DRAW);
+        glGenTextures(1, &_drawsTextureID);
+        glBindTexture(GL_TEXTURE_BUFFER, _drawsTextureID);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, _drawsBufferID);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        _classifyShader->Activate();
+        _classifyShader->SetUniform("visibility", VISIBILITY_TEXTURE_UNIT);
+        _resolveShader->Activate();
+        _resolveShader->SetUniform("visibility", VISIBILITY_TEXTURE_UNIT);
+        _resolveShader->SetUniform("arenaVertices", VERTICES_TEXTURE_UNIT);
+        _resolveShader->SetUniform("arenaPackedVertices", PACKED_VERTICES_TEXTURE_UNIT);
+        _resolveShader->SetUniform("arenaIndices", INDICES_TEXTURE_UNIT);
+        _resolveShader->SetUniform("arenaShortIndices", SHORT_INDICES_TEXTURE_UNIT);
+        _resolveShader->SetUniform("draws", DRAWS_TEXTURE_UNIT);
+    }
+
+    VisibilityBuffer::VisibilityBuffer(VisibilityBuffer&& visibilityBuffer) noexcept
+    {
+        visibilityBuffer._isMoved = true;
+        _arenaVerticesBufferID = visibilityBuffer._arenaVerticesBufferID;
+        _arenaVerticesTextureID = visibilityBuffer._arenaVerticesTextureID;
+        _arenaPackedVerticesTextureID = visibilityBuffer._arenaPackedVerticesTextureID;
+        _arenaIndicesBufferID = visibilityBuffer._arenaIndicesBufferID;
+        _arenaIndicesTextureID = visibilityBuffer._arenaIndicesTextureID;
+        _arenaShortIndicesTextureID = visibilityBuffer._arenaShortIndicesTextureID;
+        _arenaVertexCount = visibilityBuffer._arenaVertexCount;
+        _arenaIndexCount = visibilityBuffer._arenaIndexCount;
+        _arenaVertexCapacity = visibilityBuffer._arenaVertexCapacity;
+        _arenaIndexCapacity = visibilityBuffer._arenaIndexCapacity;
+        _arenaReleasedVertexUnits = visibilityBuffer._arenaReleasedVertexUnits;
+        _arenaReleasedIndexUnits = visibilityBuffer._arenaReleasedIndexUnits;
+        _arenaRanges = std::move(visibilityBuffer._arenaRanges);
+        _drawsBufferID = visibilityBuffer._drawsBufferID;
+        _drawsTextureID = visibilityBuffer._drawsTextureID;
+        _drawsData = std::move(visibilityBuffer._drawsData);
+        _visibility = visibilityBuffer._visibility;
+        _materialDepth = visibilityBuffer._materialDepth;
+        _visibilityFramebuffer = visibilityBuffer._visibilityFramebuffer;
+        _resolveFramebuffer = visibilityBuffer._resolveFramebuffer;
+        _visibilityShader = visibilityBuffer._visibilityShader;
+        _classifyShader = visibilityBuffer._classifyShader;
+        _resolveShader = visibilityBuffer._resolveShader;
+    }
+
+    void VisibilityBuffer::AcquireTargets(RenderTargetPool& pool, const size_t width, const size_t height)
+    {
+        _visibility = pool.Acquire(GL_R32UI, width, height);
+        _materialDepth = pool.Acquire(GL_DEPTH_COMPONENT32F, width, height);
+    }
+
+    void VisibilityBuffer::ReleaseTargets(RenderTargetPool& pool)
+    {
+        pool.Release(_visibility);
+        pool.Release(_materialDepth);
+        _visibility = {};
+        _materialDepth = {};
+    }
+
+    void VisibilityBuffer::AttachTargets(const RenderTarget& gDepth, const RenderTarget& gNormal, const RenderTarget& gAlbedoSpec) const
+    {
+        // Visibility pass fills gBuffer depth and stencil, so lighting and forward passes work unchanged
+        glBindFramebuffer(GL_FRAMEBUFFER, _visibilityFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _visibility.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, gDepth.Texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            spdlog::error("Failed to create visibility framebuffer!");
+
+        // Resolve writes gBuffer normals and albedo, its depth holds material ids instead of scene depth
+        glBindFramebuffer(GL_FRAMEBUFFER, _resolveFramebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gNormal.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gAlbedoSpec.Texture, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, _materialDepth.Texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            spdlog::error("Failed to create visibility resolve framebuffer!");
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void VisibilityBuffer::Render(const std::vector<VisibilityDraw>& draws, const glm::mat4& view, const glm::mat4& projection, const size_t renderWidth, const size_t renderHeight, const GLuint quadVaoID)
+    {
+        // IMPORTANT: gBuffer must be bound and cleared before, together with stencil state for geometry
+        ReleaseDestroyedMeshes();
+        UpdateDrawsData(draws);
+        // Every batch is depth tested against the previous ones and resolves only pixels it won,
+        // so later batches overwrite gBuffer exactly where they are in front
+        for (size_t firstDraw = 0; firstDraw < draws.size(); firstDraw += MAX_BATCH_DRAWS)
+        {
+            const auto drawsCount = std::min(draws.size() - firstDraw, MAX_BATCH_DRAWS);
+            RenderBatch(draws, firstDraw, drawsCount, view, projection, renderWidth, renderHeight, quadVaoID);
+        }
+        glStencilMask(0x00);
+        glDisable(GL_STENCIL_TEST);
+    }
+
+    VisibilityBuffer::~VisibilityBuffer()
+    {
+        if (_isMoved)
+        {
+            return;
+        }
+        glDeleteFramebuffers(1, &_visibilityFramebuffer);
+        glDeleteFramebuffers(1, &_resolveFramebuffer);
+        glDeleteTextures(1, &_arenaVerticesTextureID);
+        glDeleteTextures(1, &_arenaPackedVerticesTextureID);
+        glDeleteTextures(1, &_arenaIndicesTextureID);
+        glDeleteTextures(1, &_arenaShortIndicesTextureID);
+        glDeleteTextures(1, &_drawsTextureID);
+        glDeleteBuffers(1, &_arenaVerticesBufferID);
+        glDeleteBuffers(1, &_arenaIndicesBufferID);
+        glDeleteBuffers(1, &_drawsBufferID);
+    }
+
+    void VisibilityBuffer::RenderBatch(const std::vector<VisibilityDraw>& draws, const size_t firstDraw, const size_t drawsCount,
+        const glm::mat4& view, const glm::mat4& projection, const size_t renderWidth, const size_t renderHeight, const GLuint quadVaoID)
+    {
+        // Visibility pass - only positions are fetched and only 4 bytes per pixel are written. Draw ids are local to the batch.
+        glBindFramebuffer(GL_FRAMEBUFFER, _visibilityFramebuffer);
+        glEnable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
+        constexpr GLuint emptyPixel[4] = { EMPTY_PIXEL, 0, 0, 0 };
+        glClearBufferuiv(GL_COLOR, 0, emptyPixel);
+        _visibilityShader->Activate();
+        _visibilityShader->SetUniform("view", view);
+        _visibilityShader->SetUniform("projection", projection);
+        for (size_t i = 0; i < drawsCount; i++)
+        {
+            const auto& geometry = draws[firstDraw + i].Geometry;
+            _visibilityShader->SetUniform("model", draws[firstDraw + i].Model);
+            _visibilityShader->SetUniform("positionOffset", geometry.PositionOffset);
+            _visibilityShader->SetUniform("positionScale", geometry.PositionScale);
+            _visibilityShader->SetUniform("drawId", static_cast<int>(i));
+            glBindVertexArray(geometry.DepthVaoID);
+            const auto indexSize = geometry.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(geometry.LodIndexCount), geometry.IndexType, reinterpret_cast<void*>(geometry.LodFirstIndex * indexSize));
+        }
+        glBindVertexArray(0);
+        glStencilMask(0x00);
+
+        // Classify pass - depth of every pixel becomes its draw id, so resolve draws can be early depth tested
+        glBindFramebuffer(GL_FRAMEBUFFER, _resolveFramebuffer);
+        BindBufferTextures();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthFunc(GL_ALWAYS);
+        _classifyShader->Activate();
+        glBindVertexArray(quadVaoID);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        // Resolve pass - one quad per draw at its material depth, each pixel passes depth test for exactly one of them
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+        _resolveShader->Activate();
+        _resolveShader->SetUniform("viewProjection", projection * view);
+        _resolveShader->SetUniform("renderSize", glm::vec2(renderWidth, renderHeight));
+        _resolveShader->SetUniform("firstDrawId", static_cast<int>(firstDraw));
+        for (size_t i = 0; i < drawsCount; i++)
+        {
+            _resolveShader->SetUniform("drawId", static_cast<int>(i));
+            draws[firstDraw + i].BindMaterial(_resolveShader);
+            glBindVertexArray(quadVaoID);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+
+        // Cleanup state
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    void VisibilityBuffer::ReleaseDestroyedMeshes()
+    {
+        std::erase_if(_arenaRanges, [this](const auto& entry) {
+            if (!entry.second.Token.expired())
+            {
+                return false;
+            }
+            _arenaReleasedVertexUnits += entry.second.VertexUnits;
+            _arenaReleasedIndexUnits += entry.second.IndexUnits;
+            return true;
+        });
+        // Once most of the arena is dead space it's dropped, live meshes are copied again when they are drawn
+        if (_arenaReleasedVertexUnits * 2 > _arenaVertexCount || _arenaReleasedIndexUnits * 2 > _arenaIndexCount)
+        {
+            _arenaRanges.clear();
+            _arenaVertexCount = 0;
+            _arenaIndexCount = 0;
+            _arenaReleasedVertexUnits = 0;
+            _arenaReleasedIndexUnits = 0;
+        }
+    }
+
+    VisibilityBuffer::ArenaRange VisibilityBuffer::GetArenaRange(const MeshGeometry& geometry)
+    {
+        // Meshes are copied into the arena once, their space is released by ReleaseDestroyedMeshes
+        const auto token = geometry.Token.lock();
+        if (token == nullptr)
+        {
+            spdlog::error("Visibility buffer draw uses a destroyed mesh!");
+            return {0, 0, 0, 0, {}};
+        }
+        if (const auto it = _arenaRanges.find(token->GetId()); it != _arenaRanges.end())
+        {
+            return it->second;
+        }
+
+        const auto vertexSize = geometry.Format == VertexFormat::COMPACT ? sizeof(PackedVertex) : sizeof(Vertex);
+        const auto indexSize = geometry.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+        const auto vertexUnits = geometry.VertexCount * vertexSize / ARENA_VERTEX_UNIT;
+        const auto indexUnits = geometry.IndexCount * indexSize / ARENA_INDEX_UNIT;
+        // Every range starts at a whole element of its own layout
+        const auto vertexStart = (_arenaVertexCount * ARENA_VERTEX_UNIT + vertexSize - 1) / vertexSize * vertexSize / ARENA_VERTEX_UNIT;
+        const auto indexStart = (_arenaIndexCount * ARENA_INDEX_UNIT + indexSize - 1) / indexSize * indexSize / ARENA_INDEX_UNIT;
+        if (vertexStart + vertexUnits > _arenaVertexCapacity)
+        {
+            _arenaVertexCapacity = std::max(_arenaVertexCapacity * 2, vertexStart + vertexUnits);
+            GrowBuffer(_arenaVerticesBufferID, _arenaVertexCount * ARENA_VERTEX_UNIT, _arenaVertexCapacity * ARENA_VERTEX_UNIT);
+            AttachBufferTexture(_arenaVerticesTextureID, GL_RGBA32F, _arenaVerticesBufferID);
+            AttachBufferTexture(_arenaPackedVerticesTextureID, GL_RGBA32UI, _arenaVerticesBufferID);
+        }
+        if (indexStart + indexUnits > _arenaIndexCapacity)
+        {
+            _arenaIndexCapacity = std::max(_arenaIndexCapacity * 2, indexStart + indexUnits);
+            GrowBuffer(_arenaIndicesBufferID, _arenaIndexCount * ARENA_INDEX_UNIT, _arenaIndexCapacity * ARENA_INDEX_UNIT);
+            AttachBufferTexture(_arenaIndicesTextureID, GL_R32UI, _arenaIndicesBufferID);
+            AttachBufferTexture(_arenaShortIndicesTextureID, GL_R16UI, _arenaIndicesBufferID);
+        }
+
+        // Copy happens entirely on GPU
+        glBindBuffer(GL_COPY_READ_BUFFER, geometry.VboID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _arenaVerticesBufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, static_cast<GLintptr>(vertexStart * ARENA_VERTEX_UNIT), static_cast<GLsizeiptr>(vertexUnits * ARENA_VERTEX_UNIT));
+        glBindBuffer(GL_COPY_READ_BUFFER, geometry.EboID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _arenaIndicesBufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, static_cast<GLintptr>(indexStart * ARENA_INDEX_UNIT), static_cast<GLsizeiptr>(indexUnits * ARENA_INDEX_UNIT));
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        // Alignment padding is counted as part of the range, so releasing it returns everything it took
+        const ArenaRange range = {vertexStart * ARENA_VERTEX_UNIT / vertexSize, indexStart * ARENA_INDEX_UNIT / indexSize,
+            vertexStart + vertexUnits - _arenaVertexCount, indexStart + indexUnits - _arenaIndexCount, geometry.Token};
+        _arenaVertexCount = vertexStart + vertexUnits;
+        _arenaIndexCount = indexStart + indexUnits;
+        _arenaRanges[token->GetId()] = range;
+        return range;
+    }
+
+    void VisibilityBuffer::GrowBuffer(GLuint& bufferID, const size_t usedBytes, const size_t newCapacityBytes)
+    {
+        GLuint newBufferID = 0;
+        glGenBuffers(1, &newBufferID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newCapacityBytes), nullptr, GL_STATIC_DRAW);
+        if (bufferID != 0)
+        {
+            if (usedBytes > 0)
+            {
+                glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(usedBytes));
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &bufferID);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        bufferID = newBufferID;
+    }
+
+    void VisibilityBuffer::AttachBufferTexture(const GLuint textureID, const GLenum textureFormat, const GLuint bufferID)
+    {
+        glBindTexture(GL_TEXTURE_BUFFER, textureID);
+        glTexBuffer(GL_TEXTURE_BUFFER, textureFormat, bufferID);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void VisibilityBuffer::UpdateDrawsData(const std::vector<VisibilityDraw>& draws)
+    {
+        // Layout per draw: model matrix columns, normal matrix columns, (base vertex, first index, is compact, is short).
+        // All batches share it, resolve offsets batch local draw ids by the batch's first draw.
+        _drawsData.clear();
+        _drawsData.reserve(draws.size() * DRAW_DATA_STRIDE);
+        for (size_t i = 0; i < draws.size(); i++)
+        {
+            const auto& geometry = draws[i].Geometry;
+            const auto range = GetArenaRange(geometry);
+            const auto& model = draws[i].Model;
+            const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+            // Position dequantization is folded into the model matrix, it doesn't affect normals
+            const auto dequantization = glm::mat4(
+                glm::vec4(geometry.PositionScale.x, 0.0f, 0.0f, 0.0f),
+                glm::vec4(0.0f, geometry.PositionScale.y, 0.0f, 0.0f),
+                glm::vec4(0.0f, 0.0f, geometry.PositionScale.z, 0.0f),
+                glm::vec4(geometry.PositionOffset, 1.0f));
+            const auto positionMatrix = model * dequantization;
+            for (int column = 0; column < 4; column++)
+            {
+                _drawsData.push_back(positionMatrix[column]);
+            }
+            for (int column = 0; column < 3; column++)
+            {
+                _drawsData.emplace_back(normalMatrix[column], 0.0f);
+            }
+            // Offsets are stored as floats, which is exact for arenas below 2^24 elements. Whole index buffer with all
+            // LODs is in the arena, primitive ids count from the drawn LOD's first index.
+            _drawsData.emplace_back(static_cast<float>(range.BaseVertex), static_cast<float>(range.FirstIndex + geometry.LodFirstIndex),
+                geometry.Format == VertexFormat::COMPACT ? 1.0f : 0.0f, geometry.IndexType == GL_UNSIGNED_SHORT ? 1.0f : 0.0f);
+        }
+        if (_drawsData.empty())
+        {
+            return;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, _drawsBufferID);
+        glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(_drawsData.size() * sizeof(glm::vec4)), _drawsData.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    void VisibilityBuffer::BindBufferTextures() const
+    {
+        glActiveTexture(GL_TEXTURE0 + VISIBILITY_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, _visibility.Texture);
+        glActiveTexture(GL_TEXTURE0 + VERTICES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _arenaVerticesTextureID);
+        glActiveTexture(GL_TEXTURE0 + INDICES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _arenaIndicesTextureID);
+        glActiveTexture(GL_TEXTURE0 + DRAWS_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _drawsTextureID);
+        glActiveTexture(GL_TEXTURE0 + PACKED_VERTICES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _arenaPackedVerticesTextureID);
+        glActiveTexture(GL_TEXTURE0 + SHORT_INDICES_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, _arenaShortIndicesTextureID);
+        glActiveTexture(GL_TEXTURE0);
+    }
+} // Renderer3D
@@ -0,0 +1,118 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef VISIBILITY_BUFFER_H
+#define VISIBILITY_BUFFER_H
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "render_target_pool.h"
+#include "shader.h"
+
+namespace Renderer3D {
+
+    struct VisibilityDraw
+    {
+        MeshGeometry Geometry;
+        glm::mat4 Model;
+        std::function<void(const std::shared_ptr<Shader>&)> BindMaterial;
+    };
+
+    // Geometry pass writes only packed draw and triangle ids, gBuffer normals and albedo are resolved from them afterward.
+    // Every draw is resolved with a full screen quad, which is depth tested against per pixel "material depth",
+    // so each pixel is shaded by exactly one resolve draw and textures are sampled only for visible triangles.
+    class VisibilityBuffer {
+    public:
+        VisibilityBuffer();
+        VisibilityBuffer(const VisibilityBuffer&) = delete;
+        VisibilityBuffer& operator=(const VisibilityBuffer&) = delete;
+        VisibilityBuffer(VisibilityBuffer&& visibilityBuffer) noexcept;
+        void AcquireTargets(RenderTargetPool& pool, size_t width, size_t height);
+        void ReleaseTargets(RenderTargetPool& pool);
+        void AttachTargets(const RenderTarget& gDepth, const RenderTarget& gNormal, const RenderTarget& gAlbedoSpec) const;
+        void Render(const std::vector<VisibilityDraw>& draws, const glm::mat4& view, const glm::mat4& projection, size_t renderWidth, size_t renderHeight, GLuint quadVaoID);
+        ~VisibilityBuffer();
+    private:
+        // Offsets are in elements of the mesh's own vertex and index layout
+        struct ArenaRange
+        {
+            size_t BaseVertex;
+            size_t FirstIndex;
+            // Space taken in ARENA_VERTEX_UNIT and ARENA_INDEX_UNIT, returned once the mesh is destroyed
+            size_t VertexUnits;
+            size_t IndexUnits;
+            std::weak_ptr<const GeometryToken> Token;
+        };
+        // All meshes copied into shared buffers, so resolve can fetch vertices of any draw. Full and compact vertices,
+        // as well as 32 and 16-bit indices, share a buffer - each layout reads it through its own buffer texture.
+        GLuint _arenaVerticesBufferID = 0;
+        GLuint _arenaVerticesTextureID = 0;
+        GLuint _arenaPackedVerticesTextureID = 0;
+        GLuint _arenaIndicesBufferID = 0;
+        GLuint _arenaIndicesTextureID = 0;
+        GLuint _arenaShortIndicesTextureID = 0;
+        // Sizes are in ARENA_VERTEX_UNIT and ARENA_INDEX_UNIT bytes
+        size_t _arenaVertexCount = 0;
+        size_t _arenaIndexCount = 0;
+        size_t _arenaVertexCapacity = 0;
+        size_t _arenaIndexCapacity = 0;
+        // Space of destroyed meshes - ranges are only appended, so it's reused by rebuilding the arena
+        size_t _arenaReleasedVertexUnits = 0;
+        size_t _arenaReleasedIndexUnits = 0;
+        // Key is id of the mesh's geometry token
+        std::unordered_map<size_t, ArenaRange> _arenaRanges;
+        // Per draw transforms and arena offsets
+        GLuint _drawsBufferID = 0;
+        GLuint _drawsTextureID = 0;
+        std::vector<glm::vec4> _drawsData;
+        // Targets
+        RenderTarget _visibility;
+        RenderTarget _materialDepth;
+        GLuint _visibilityFramebuffer = 0;
+        GLuint _resolveFramebuffer = 0;
+        std::shared_ptr<Shader> _visibilityShader = nullptr;
+        std::shared_ptr<Shader> _classifyShader = nullptr;
+        std::shared_ptr<Shader> _resolveShader = nullptr;
+        bool _isMoved = false;
+
+        // Helpers
+        void RenderBatch(const std::vector<VisibilityDraw>& draws, size_t firstDraw, size_t drawsCount, const glm::mat4& view, const glm::mat4& projection, size_t renderWidth, size_t renderHeight, GLuint quadVaoID);
+        void ReleaseDestroyedMeshes();
+        ArenaRange GetArenaRange(const MeshGeometry& geometry);
+        static void GrowBuffer(GLuint& bufferID, size_t usedBytes, size_t newCapacityBytes);
+        static void AttachBufferTexture(GLuint textureID, GLenum textureFormat, GLuint bufferID);
+        void UpdateDrawsData(const std::vector<VisibilityDraw>& draws);
+        void BindBufferTextures() const;
+
+        // Consts
+        // IMPORTANT: these values must match constants with the same name in visibility shaders
+        static constexpr unsigned int PRIMITIVE_ID_BITS = 23;
+        // Last draw id is reserved for empty pixels, more draws are rendered in batches of this size
+        static constexpr size_t MAX_BATCH_DRAWS = (1u << (32 - PRIMITIVE_ID_BITS)) - 1;
+        static constexpr size_t DRAW_DATA_STRIDE = 8;
+        static constexpr size_t VERTEX_DATA_STRIDE = 2;
+        static constexpr int VISIBILITY_TEXTURE_UNIT = 8;
+        static constexpr int VERTICES_TEXTURE_UNIT = 9;
+        static constexpr int INDICES_TEXTURE_UNIT = 10;
+        static constexpr int DRAWS_TEXTURE_UNIT = 11;
+        // 12 and 13 are taken by spotlight and point light shadow maps, 15 is the last unit GL 3.3 guarantees
+        static constexpr int PACKED_VERTICES_TEXTURE_UNIT = 14;
+        static constexpr int SHORT_INDICES_TEXTURE_UNIT = 15;
+        // One texel of the packed vertices view, full vertices take two
+        static constexpr size_t ARENA_VERTEX_UNIT = sizeof(PackedVertex);
+        static constexpr size_t ARENA_INDEX_UNIT = sizeof(uint16_t);
+        static constexpr GLuint EMPTY_PIXEL = 0xFFFFFFFF;
+        static constexpr size_t INITIAL_ARENA_VERTEX_UNITS = 1 << 16;
+        static constexpr size_t INITIAL_ARENA_INDEX_UNITS = 3 << 16;
+    };
+
+} // Renderer3D
+
+#endif //VISIBILITY_BUFFER_H
@@ -0,0 +1,222 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+#include "block_encoder.h"
+
+namespace Renderer3D {
+    namespace {
+        constexpr size_t BLOCK_DIMENSION = 4;
+        constexpr size_t BLOCK_TEXELS = BLOCK_DIMENSION * BLOCK_DIMENSION;
+
+        uint16_t packRgb565(const std::array<int, 3>& color)
+        {
+            return static_cast<uint16_t>((color[0] >> 3) << 11 | (color[1] >> 2) << 5 | color[2] >> 3);
+        }
+
+        std::array<int, 3> unpackRgb565(const uint16_t packed)
+        {
+            const auto red = packed >> 11 & 0x1F;
+            const auto green = packed >> 5 & 0x3F;
+            const auto blue = packed & 0x1F;
+            // Top bits are replicated into the bottom ones, the same way the GPU expands them
+            return { red << 3 | red >> 2, green << 2 | green >> 4, blue << 3 | blue >> 2 };
+        }
+
+        void writeLittleEndian(std::byte* output, const uint64_t value, const size_t bytesCount)
+        {
+            for (size_t i = 0; i < bytesCount; i++)
+            {
+                output[i] = static_cast<std::byte>(value >> (8 * i) & 0xFF);
+            }
+        }
+
+        // Color block shared by BC1 and BC3. Endpoints span the bounding box of block colors, inset slightly because
+        // extreme texels are rare, with the box diagonal flipped to follow the direction in which colors change.
+        void encodeColorBlock(const TexelBlock& texels, std::byte* output)
+        {
+            std::array<int, 3> minimum = { 255, 255, 255 };
+            std::array<int, 3> maximum = { 0, 0, 0 };
+            std::array<int, 3> mean = { 0, 0, 0 };
+            for (const auto& texel : texels)
+            {
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    minimum[channel] = std::min<int>(minimum[channel], texel[channel]);
+                    maximum[channel] = std::max<int>(maximum[channel], texel[channel]);
+                    mean[channel] += texel[channel];
+                }
+            }
+            for (auto& value : mean)
+            {
+                value /= static_cast<int>(BLOCK_TEXELS);
+            }
+
+            // Covariance of red and blue against green decides on which diagonal of the box colors lie
+            int redGreen = 0;
+            int blueGreen = 0;
+            for (const auto& texel : texels)
+            {
+                const auto green = texel[1] - mean[1];
+                redGreen += (texel[0] - mean[0]) * green;
+                blueGreen += (texel[2] - mean[2]) * green;
+            }
+            if (redGreen < 0)
+            {
+                std::swap(minimum[0], maximum[0]);
+            }
+            if (blueGreen < 0)
+            {
+                std::swap(minimum[2], maximum[2]);
+            }
+            for (size_t channel = 0; channel < 3; channel++)
+            {
+                const auto inset = (maximum[channel] - minimum[channel]) / 16;
+                maximum[channel] = std::clamp(maximum[channel] - inset, 0, 255);
+                minimum[channel] = std::clamp(minimum[channel] + inset, 0, 255);
+            }
+
+            auto color0 = packRgb565(maximum);
+            auto color1 = packRgb565(minimum);
+            // Four color mode requires first endpoint to be bigger, equal endpoints mean a single color block
+            if (color0 < color1)
+            {
+                std::swap(color0, color1);
+            }
+            uint32_t indices = 0;
+            if (color0 != color1)
+            {
+                const auto endpoint0 = unpackRgb565(color0);
+                const auto endpoint1 = unpackRgb565(color1);
+                std::array<std::array<int, 3>, 4> palette{};
+                for (size_t channel = 0; channel < 3; channel++)
+                {
+                    palette[0][channel] = endpoint0[channel];
+                    palette[1][channel] = endpoint1[channel];
+                    palette[2][channel] = (2 * endpoint0[channel] + endpoint1[channel]) / 3;
+                    palette[3][channel] = (endpoint0[channel] + 2 * endpoint1[channel]) / 3;
+                }
+                for (size_t i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    uint32_t bestIndex = 0;
+                    auto bestDistance = std::numeric_limits<int>::max();
+                    for (uint32_t index = 0; index < palette.size(); index++)
+                    {
+                        auto distance = 0;
+                        for (size_t channel = 0; channel < 3; channel++)
+                        {
+                            const auto difference = texels[i][channel] - palette[index][channel];
+                            distance += difference * difference;
+                        }
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            bestIndex = index;
+                        }
+                    }
+                    indices |= bestIndex << (2 * i);
+                }
+            }
+            writeLittleEndian(output, color0, 2);
+            writeLittleEndian(output + 2, color1, 2);
+            writeLittleEndian(output + 4, indices, 4);
+        }
+
+        // Single channel block used for BC3 alpha, BC4 and both BC5 channels, always in the eight value mode
+        void encodeChannelBlock(const TexelBlock& texels, const size_t channel, std::byte* output)
+        {
+            int maximum = 0;
+            int minimum = 255;
+            for (const auto& texel : texels)
+            {
+                maximum = std::max<int>(maximum, texel[channel]);
+                minimum = std::min<int>(minimum, texel[channel]);
+            }
+            uint64_t indices = 0;
+            if (maximum != minimum)
+            {
+                const auto range = maximum - minimum;
+                for (size_t i = 0; i < BLOCK_TEXELS; i++)
+                {
+                    // Position between endpoints, 0 is maximum and 7 is minimum
+                    const auto position = static_cast<uint64_t>(((maximum - texels[i][channel]) * 14 + range) / (2 * range));
+                    // Endpoints have indices 0 and 1, interpolated values follow them
+                    const auto index = position == 0 ? 0 : position == 7 ? 1 : position + 1;
+                    indices |= index << (3 * i);
+                }
+            }
+            output[0] = static_cast<std::byte>(maximum);
+            output[1] = static_cast<std::byte>(minimum);
+            writeLittleEndian(output + 2, indices, 6);
+        }
+    }
+
+    void encodeBc1Block(const TexelBlock& texels, std::byte* output)
+    {
+        encodeColorBlock(texels, output);
+    }
+
+    void encodeBc3Block(const TexelBlock& texels, std::byte* output)
+    {
+        encodeChannelBlock(texels, 3, output);
+        encodeColorBlock(texels, output + 8);
+    }
+
+    void encodeBc4Block(const TexelBlock& texels, std::byte* output)
+    {
+        encodeChannelBlock(texels, 0, output);
+    }
+
+    void encodeBc5Block(const TexelBlock& texels, std::byte* output)
+    {
+        encodeChannelBlock(texels, 0, output);
+        encodeChannelBlock(texels, 1, output + 8);
+    }
+
+    std::vector<std::byte> compressImage(const BakedTextureFormat format, const uint8_t* rgba, const uint32_t width, const uint32_t height)
+    {
+        const auto encodeBlock = [format]()
+        {
+            switch (format)
+            {
+            case BakedTextureFormat::BC1:
+                return encodeBc1Block;
+            case BakedTextureFormat::BC3:
+                return encodeBc3Block;
+            case BakedTextureFormat::BC4:
+                return encodeBc4Block;
+            case BakedTextureFormat::BC5:
+                return encodeBc5Block;
+            default:
+                throw std::invalid_argument("Invalid enum value");
+            }
+        }();
+        const auto blockSize = BakedTexture::GetBlockSize(format);
+        std::vector<std::byte> output(BakedTexture::GetLevelSize(format, width, height));
+        auto block = output.data();
+        for (uint32_t blockY = 0; blockY < height; blockY += BLOCK_DIMENSION)
+        {
+            for (uint32_t blockX = 0; blockX < width; blockX += BLOCK_DIMENSION)
+            {
+                TexelBlock texels;
+                for (uint32_t y = 0; y < BLOCK_DIMENSION; y++)
+                {
+                    for (uint32_t x = 0; x < BLOCK_DIMENSION; x++)
+                    {
+                        const auto sourceX = std::min(blockX + x, width - 1);
+                        const auto sourceY = std::min(blockY + y, height - 1);
+                        std::copy_n(rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4, texels[y * BLOCK_DIMENSION + x]);
+                    }
+                }
+                encodeBlock(texels, block);
+                block += blockSize;
+            }
+        }
+        return output;
+    }
+} // Renderer3D
@@ -0,0 +1,31 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#ifndef BLOCK_ENCODER_H
+#define BLOCK_ENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "baked_texture.h"
+
+namespace Renderer3D {
+
+    // RGBA8 texels of a single 4x4 block in row-major order
+    using TexelBlock = uint8_t[16][4];
+
+    // Encoders write exactly BakedTexture::GetBlockSize(format) bytes. They run on the CPU only.
+    void encodeBc1Block(const TexelBlock& texels, std::byte* output);
+    void encodeBc3Block(const TexelBlock& texels, std::byte* output);
+    // Only red channel is stored
+    void encodeBc4Block(const TexelBlock& texels, std::byte* output);
+    // Only red and green channels are stored
+    void encodeBc5Block(const TexelBlock& texels, std::byte* output);
+    // Compresses a whole RGBA8 image, edge texels are repeated in blocks which stick out of the image
+    [[nodiscard]] std::vector<std::byte> compressImage(BakedTextureFormat format, const uint8_t* rgba, uint32_t width, uint32_t height);
+
+} // Renderer3D
+
+#endif //BLOCK_ENCODER_H
@@ -0,0 +1,187 @@
+//
+// Created by Kacper Trzciński on 19.10.2026.
+//
+
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <stb_image/stb_image.h>
+#include <spdlog/spdlog.h>
+
+#include "baked_texture.h"
+#include "block_encoder.h"
+#include "mip_chain.h"
+
+using namespace Renderer3D;
+
+struct BakerOptions
+{
+    fs::path Input;
+    fs::path Output;
+    std::optional<BakedTextureFormat> Format;
+    bool FlipVertically = false;
+};
+
+static void printUsage()
+{
+    spdlog::info("Usage: TextureBaker <input> [--format bc1|bc3|bc4|bc5] [--flip] [-o <output>]");
+    spdlog::info("Output defaults to <input>.baked, which is picked up by the renderer in place of <input>");
+    spdlog::info("Use --flip for textures of models loaded with flipped textures");
+}
+
+static std::optional<BakedTextureFormat> formatFromString(const std::string_view name)
+{
+    if (name == "bc1")
+    {
+        return BakedTextureFormat::BC1;
+    }
+    if (name == "bc3")
+    {
+        return BakedTextureFormat::BC3;
+    }
+    if (name == "bc4")
+    {
+        return BakedTextureFormat::BC4;
+    }
+    if (name == "bc5")
+    {
+        return BakedTextureFormat::BC5;
+    }
+    return std::nullopt;
+}
+
+static std::optional<BakerOptions> parseOptions(const int argc, char** argv)
+{
+    BakerOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view argument = argv[i];
+        if (argument == "--flip")
+        {
+            options.FlipVertically = true;
+        }
+        else if (argument == "--format" && i + 1 < argc)
+        {
+            options.Format = formatFromString(argv[++i]);
+            if (!options.Format)
+            {
+                spdlog::error("Unknown format {}", argv[i]);
+                return std::nullopt;
+            }
+        }
+        else if (argument == "-o" && i + 1 < argc)
+        {
+            options.Output = argv[++i];
+        }
+        else if (options.Input.empty() && !argument.starts_with("-"))
+        {
+            options.Input = argument;
+        }
+        else
+        {
+            spdlog::error("Unexpected argument {}", argument);
+            return std::nullopt;
+        }
+    }
+    if (options.Input.empty())
+    {
+        return std::nullopt;
+    }
+    if (options.Output.empty())
+    {
+        options.Output = BakedTexture::GetBakedPath(options.Input);
+    }
+    return options;
+}
+
+// Matches what the renderer would upload: single channel images are red only, three channel ones are opaque
+static std::vector<uint8_t> expandToRgba(const uint8_t* pixels, const uint32_t width, const uint32_t height, const int components)
+{
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    for (size_t i = 0; i < static_cast<size_t>(width) * height; i++)
+    {
+        const auto source = pixels + i * components;
+        const auto target = rgba.data() + i * 4;
+        target[0] = source[0];
+        target[1] = components >= 3 ? source[1] : 0;
+        target[2] = components >= 3 ? source[2] : 0;
+        target[3] = components == 4 ? source[3] : 255;
+    }
+    return rgba;
+}
+
+// Picks the smallest format which keeps every channel the renderer reads from the image
+static BakedTextureFormat chooseFormat(const std::vector<uint8_t>& rgba, const int components)
+{
+    if (components == 1)
+    {
+        return BakedTextureFormat::BC4;
+    }
+    for (size_t i = 3; i < rgba.size(); i += 4)
+    {
+        if (rgba[i] != 255)
+        {
+            return BakedTextureFormat::BC3;
+        }
+    }
+    return BakedTextureFormat::BC1;
+}
+
+int main(const int argc, char** argv)
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options)
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Taken before decoding, so the renderer can tell the image was edited since
+    const auto source = BakedTexture::ReadSource(options->Input);
+    if (!source)
+    {
+        spdlog::error("Failed to read image {}", options->Input.string());
+        return 1;
+    }
+    stbi_set_flip_vertically_on_load(options->FlipVertically);
+    int width, height, components;
+    const auto pixels = stbi_load(options->Input.string().c_str(), &width, &height, &components, 0);
+    if (!pixels)
+    {
+        spdlog::error("Failed to load image {}", options->Input.string());
+        return 1;
+    }
+    if (components == 2)
+    {
+        spdlog::error("Images with two channels are not supported by the renderer");
+        stbi_image_free(pixels);
+        return 1;
+    }
+    auto rgba = expandToRgba(pixels, width, height, components);
+    stbi_image_free(pixels);
+
+    const auto format = options->Format.value_or(chooseFormat(rgba, components));
+    // Whole chain down to 1x1 is baked, so the renderer never generates mips for these textures
+    std::vector<std::vector<std::byte>> levels;
+    auto levelWidth = static_cast<uint32_t>(width);
+    auto levelHeight = static_cast<uint32_t>(height);
+    while (true)
+    {
+        levels.push_back(compressImage(format, rgba.data(), levelWidth, levelHeight));
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+        rgba = downsampleImage(rgba.data(), levelWidth, levelHeight, 4);
+        levelWidth = mipLevelDimension(levelWidth, 1);
+        levelHeight = mipLevelDimension(levelHeight, 1);
+    }
+
+    const BakedTexture bakedTexture(format, width, height, options->FlipVertically, *source, std::move(levels));
+    if (!bakedTexture.Save(options->Output))
+    {
+        return 1;
+    }
+    spdlog::info("Baked {} into {} ({} levels, {} bytes)", options->Input.string(), options->Output.string(), bakedTexture.GetLevelsCount(), bakedTexture.GetDataSize());
+    return 0;
+}